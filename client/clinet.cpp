@@ -39,6 +39,7 @@
 #include "governor.h"
 #include "options.h"
 #include "packhand.h"
+#include "ruleset_cache.h"
 
 // gui-qt
 #include "qtg_cxxside.h"
@@ -70,6 +71,11 @@ static void client_conn_close_callback(struct connection *pconn)
 {
   QString reason;
 
+  if (pconn != &client.conn) {
+    // Scratch connection, see ruleset_cache_load().
+    return;
+  }
+
   if (pconn->sock != nullptr) {
     reason = pconn->sock->errorString();
   } else {
@@ -177,6 +183,7 @@ void make_connection(QTcpSocket *sock, const QString &username)
   client.conn.client.request_id_of_currently_handled_packet = 0;
   client.conn.incoming_packet_notify = notify_about_incoming_packet;
   client.conn.outgoing_packet_notify = notify_about_outgoing_packet;
+  ruleset_cache_stop_recording();
 
   // call gui-dependent stuff in gui_main.c
   add_net_input(client.conn.sock);
@@ -10,17 +10,31 @@
 *-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*/
 
 #include <QElapsedTimer>
+#include <QHash>
+#include <QTimer>
+
+#include <vector>
 
 // utility
 #include "bugs.h"
 #include "fciconv.h"
 
 // common
+#include "citizens.h"
 #include "city.h"
 #include "dataio.h"
+#include "effects.h"
 #include "featured_text.h"
+#include "game.h"
+#include "government.h"
 #include "nation.h"
+#include "player.h"
+#include "research.h"
 #include "specialist.h"
+#include "traderoutes.h"
+#include "unit.h"
+#include "unitlist.h"
+#include "unittype.h"
 // client
 #include "attribute.h"
 #include "citydlg_common.h"
@@ -46,6 +60,10 @@
 
 #define CMA_NUM_PARAMS 5
 
+/* Time the governor may spend solving cities before yielding back to the
+ * event loop. Remaining cities are handled on the next iteration. */
+#define GOVERNOR_SLICE_MSEC 20
+
 #define SPECLIST_TAG preset
 #define SPECLIST_TYPE struct cma_preset
 #include "speclist.h"
@@ -65,6 +83,7 @@ struct cma_preset {
 
 static struct {
   int apply_result_ignored, apply_result_applied, refresh_forced;
+  int cache_hits, cache_misses;
 } stats;
 
 governor *governor::m_instance = nullptr;
@@ -86,11 +105,22 @@ class cma_yoloswag {
   void handle_city(struct city *pcity);
   int get_request();
   void result_came_from_server(int request);
+  void forget_city(int city_id);
+  void clear_cache();
 
 private:
   struct city *check_city(int city_id, struct cm_parameter *parameter);
   bool apply_result_on_server(struct city *pcity,
                               std::unique_ptr<cm_result> &&result);
+  void query_result(struct city *pcity,
+                    const struct cm_parameter *parameter,
+                    std::unique_ptr<cm_result> &result);
+  // Last result per city, with the inputs it was solved for
+  struct cached_result {
+    std::vector<int> key;
+    cm_result result;
+  };
+  QHash<int, cached_result> result_cache;
   std::unique_ptr<cm_result> cma_result_got;
   int last_request;
   struct city *xcity;
@@ -102,6 +132,7 @@ Q_GLOBAL_STATIC(cma_yoloswag, gimb)
 // deletes governor
 void governor::drop()
 {
+  gimb->clear_cache();
   delete m_instance;
   m_instance = nullptr;
 }
@@ -136,14 +167,36 @@ void governor::add_city_remove(struct city *pcity)
   run();
 };
 
-// run all events
+// continue a run that ran out of its time slice
+void governor::run_deferred()
+{
+  if (m_instance == nullptr) {
+    return;
+  }
+  m_instance->run_scheduled = false;
+  m_instance->run();
+}
+
+/**
+   Run all events. Changed cities are handled until GOVERNOR_SLICE_MSEC
+   have elapsed; the rest is left queued and handled from the event loop,
+   so that a turn change with many governed cities doesn't block the GUI.
+ */
 void governor::run()
 {
+  QElapsedTimer timer;
+
   if (superhot < 1 || !client.conn.playing) {
     return;
   }
 
-  for (auto *pcity : qAsConst(scity_changed)) {
+  timer.start();
+  while (!scity_changed.isEmpty()) {
+    auto it = scity_changed.begin();
+    auto *pcity = *it;
+
+    scity_changed.erase(it);
+
     // dont check city if its not ours, asan says
     // city was removed, but city still points to something
     // uncomment and check whats happening when city is conquered
@@ -162,15 +215,23 @@ void governor::run()
     if (pcity) {
       city_changed(pcity->id);
     }
+    if (timer.elapsed() >= GOVERNOR_SLICE_MSEC) {
+      break;
+    }
   }
-  scity_changed.clear();
   for (auto *pcity : qAsConst(scity_remove)) {
     if (pcity) {
       attr_city_set(ATTR_CITY_CMAFE_PARAMETER, pcity->id, 0, nullptr);
       city_remove(pcity->id);
+      gimb->forget_city(pcity->id);
     }
   }
   scity_remove.clear();
+
+  if (!scity_changed.isEmpty() && !run_scheduled) {
+    run_scheduled = true;
+    QTimer::singleShot(0, &governor::run_deferred);
+  }
 }
 
 inline bool operator==(const struct cm_result &result1,
@@ -215,6 +276,184 @@ inline bool operator==(const struct cm_result &result1,
   return true;
 }
 
+/**
+   Collect everything the CM looks at when solving the city: the output of
+   every workable tile, specialist output, city size, buildings and trade
+   routes, the citizens' nationalities, taxes, known techs, the units
+   supported by or inside the city and the effects driving happiness and
+   waste. Two queries with the same key and parameter are assumed to give
+   the same result.
+ */
+static std::vector<int> cm_input_key(const struct city *pcity,
+                                     const struct cm_parameter *parameter)
+{
+  const struct player *pplayer = city_owner(pcity);
+  const struct research *presearch = research_get(pplayer);
+  bool is_celebrating = base_city_celebrating(pcity);
+  std::vector<int> key;
+  auto mix = [&key](int value) { key.push_back(value); };
+
+  output_type_iterate(o)
+  {
+    mix(parameter->minimal_surplus[o]);
+    mix(parameter->factor[o]);
+  }
+  output_type_iterate_end;
+  mix(parameter->happy_factor);
+  mix(parameter->max_growth);
+  mix(parameter->require_happy);
+  mix(parameter->allow_disorder);
+  mix(parameter->allow_specialists);
+
+  mix(city_size_get(pcity));
+  mix(city_map_radius_sq_get(pcity));
+  mix(is_celebrating);
+  mix(pplayer->economic.tax);
+  mix(pplayer->economic.luxury);
+  mix(pplayer->economic.science);
+  mix(government_number(government_of_player(pplayer)));
+
+  // Base content and angry citizens, from the empire size
+  mix(player_content_citizens(pplayer));
+  mix(player_angry_citizens(pplayer));
+
+  // Techs, 32 per value
+  mix(presearch->techs_researched);
+  mix(presearch->future_tech);
+  for (int i = A_FIRST; i < advance_count(); i += 32) {
+    unsigned int known = 0;
+
+    for (int j = i; j < MIN(i + 32, advance_count()); j++) {
+      if (research_invention_state(presearch, j) == TECH_KNOWN) {
+        known |= 1U << (j - i);
+      }
+    }
+    mix(static_cast<int>(known));
+  }
+
+  // Unhappiness from citizens of enemy nations
+  mix(get_city_bonus(pcity, EFT_ENEMY_CITIZEN_UNHAPPY_PCT));
+  if (game.info.citizen_nationality) {
+    citizens_iterate(pcity, pslot, nationality)
+    {
+      const struct player *pnation = player_slot_get_player(pslot);
+
+      mix(player_slot_index(pslot));
+      mix(nationality);
+      mix(pnation != nullptr && pplayers_at_war(pplayer, pnation));
+    }
+    citizens_iterate_end;
+  }
+
+  mix(trade_route_list_size(pcity->routes));
+  trade_routes_iterate(pcity, proute)
+  {
+    mix(proute->partner);
+    mix(proute->value);
+    mix(proute->dir);
+  }
+  trade_routes_iterate_end;
+
+  // Upkeep and military unhappiness of the supported units
+  mix(unit_list_size(pcity->units_supported));
+  unit_list_iterate(pcity->units_supported, punit)
+  {
+    mix(punit->id);
+    mix(utype_number(unit_type_get(punit)));
+    mix(unit_being_aggressive(punit));
+    output_type_iterate(o) { mix(punit->upkeep[o]); }
+    output_type_iterate_end;
+  }
+  unit_list_iterate_end;
+
+  // Martial law
+  mix(unit_list_size(city_tile(pcity)->units));
+  unit_list_iterate(city_tile(pcity)->units, punit)
+  {
+    mix(player_number(unit_owner(punit)));
+    mix(utype_number(unit_type_get(punit)));
+  }
+  unit_list_iterate_end;
+
+  city_built_iterate(pcity, pimprove) { mix(improvement_number(pimprove)); }
+  city_built_iterate_end;
+
+  mix(get_city_bonus(pcity, EFT_MAKE_CONTENT));
+  mix(get_city_bonus(pcity, EFT_FORCE_CONTENT));
+  mix(get_city_bonus(pcity, EFT_MAKE_HAPPY));
+  mix(get_city_bonus(pcity, EFT_NO_UNHAPPY));
+  mix(get_city_bonus(pcity, EFT_EMPIRE_SIZE_BASE));
+  mix(get_city_bonus(pcity, EFT_EMPIRE_SIZE_STEP));
+  mix(get_city_bonus(pcity, EFT_MARTIAL_LAW_EACH));
+  output_type_iterate(o)
+  {
+    const struct output_type *poutput = get_output_type(o);
+
+    mix(get_city_output_bonus(pcity, poutput, EFT_OUTPUT_BONUS));
+    mix(get_city_output_bonus(pcity, poutput, EFT_OUTPUT_BONUS_2));
+    mix(get_city_output_bonus(pcity, poutput, EFT_OUTPUT_WASTE));
+  }
+  output_type_iterate_end;
+
+  city_tile_iterate_index(city_map_radius_sq_get(pcity), city_tile(pcity),
+                          ptile, ctindex)
+  {
+    if (is_free_worked(pcity, ptile) || !city_can_work_tile(pcity, ptile)) {
+      continue;
+    }
+    mix(ctindex);
+    output_type_iterate(o)
+    {
+      mix(city_tile_output(pcity, ptile, is_celebrating, o));
+    }
+    output_type_iterate_end;
+  }
+  city_tile_iterate_index_end;
+
+  specialist_type_iterate(sp)
+  {
+    if (city_can_use_specialist(pcity, sp)) {
+      output_type_iterate(o) { mix(get_specialist_output(pcity, sp, o)); }
+      output_type_iterate_end;
+    }
+  }
+  specialist_type_iterate_end;
+
+  return key;
+}
+
+/**
+   Solve the city, reusing the previous result if none of the inputs
+   changed since it was computed.
+ */
+void cma_yoloswag::query_result(struct city *pcity,
+                                const struct cm_parameter *parameter,
+                                std::unique_ptr<cm_result> &result)
+{
+  auto key = cm_input_key(pcity, parameter);
+  auto cached = result_cache.constFind(pcity->id);
+
+  if (!result) {
+    result = cm_result_new(pcity);
+  }
+
+  if (cached != result_cache.constEnd() && cached->key == key) {
+    *result = cached->result;
+    stats.cache_hits++;
+    return;
+  }
+
+  cm_query_result(pcity, parameter, result, false);
+  result_cache.insert(pcity->id, {std::move(key), *result});
+  stats.cache_misses++;
+}
+
+// drops the cached result of a city
+void cma_yoloswag::forget_city(int city_id) { result_cache.remove(city_id); }
+
+// drops all cached results
+void cma_yoloswag::clear_cache() { result_cache.clear(); }
+
 // yet another abstraction layer
 int cities_results_request() { return gimb->get_request(); }
 int cma_yoloswag::get_request() { return last_request; }
@@ -422,6 +661,7 @@ void cma_yoloswag::put_city_under_agent(
 void cma_yoloswag::release_city(struct city *pcity)
 {
   attr_city_set(ATTR_CITY_CMA_PARAMETER, pcity->id, 0, nullptr);
+  forget_city(pcity->id);
   refresh_city_dialog(pcity);
   city_report_dialog_update_city(pcity);
 }
@@ -579,7 +819,7 @@ void cma_yoloswag::handle_city(struct city *pcity)
       break;
     }
 
-    cm_query_result(pcity, &parameter, result, false);
+    query_result(pcity, &parameter, result);
     if (!result->found_a_valid) {
       log_handle_city2("  no valid found result");
 
@@ -594,6 +834,8 @@ void cma_yoloswag::handle_city(struct city *pcity)
     } else {
       if (!apply_result_on_server(pcity, std::move(result))) {
         log_handle_city2("  doesn't cleanly apply");
+        // Don't hand out the same result on the next try
+        forget_city(city_id);
         if (pcity == check_city(city_id, nullptr) && i == 0) {
           create_event(city_tile(pcity), E_CITY_CMA_RELEASE, ftc_client,
                        _("The citizen governor has gotten confused dealing "
@@ -32,10 +32,12 @@ class governor {
 private:
   governor() { superhot = 1; };
   void run();
+  static void run_deferred();
   static governor *m_instance;
   QSet<struct city *> scity_changed;
   QSet<struct city *> scity_remove;
   int superhot;
+  bool run_scheduled = false;
 };
 
 void cma_put_city_under_agent(struct city *pcity,
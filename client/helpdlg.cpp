@@ -838,12 +838,7 @@ void help_widget::set_bottom_panel(QWidget *widget)
 void help_widget::set_topic_other(const help_item *topic, const char *title)
 {
   Q_UNUSED(title)
-  if (topic->text) {
-    text_browser->setPlainText(topic->text);
-  } else {
-    text_browser->setPlainText(
-        QLatin1String("")); // Something better to do ?
-  }
+  text_browser->setPlainText(help_item_text(topic));
 }
 
 /**
@@ -860,8 +855,9 @@ void help_widget::set_topic_unit(const help_item *topic, const char *title)
 
   utype = unit_type_by_translated_name(title);
   if (utype) {
-    helptext_unit(buffer, sizeof(buffer), client.conn.playing, topic->text,
-                  utype, client_current_nation_set());
+    helptext_unit(buffer, sizeof(buffer), client.conn.playing,
+                  help_item_text(topic), utype,
+                  client_current_nation_set());
     text_browser->setPlainText(buffer);
 
     // Create information panel
@@ -972,7 +968,8 @@ void help_widget::set_topic_building(const help_item *topic,
 
   if (itype) {
     helptext_building(buffer, sizeof(buffer), client.conn.playing,
-                      topic->text, itype, client_current_nation_set());
+                      help_item_text(topic), itype,
+                      client_current_nation_set());
     text_browser->setPlainText(buffer);
     show_info_panel();
     auto spr = get_building_sprite(tileset, itype);
@@ -1145,7 +1142,8 @@ void help_widget::set_topic_tech(const help_item *topic, const char *title)
 
       info_panel_done();
       helptext_advance(buffer, sizeof(buffer), client.conn.playing,
-                       topic->text, n, client_current_nation_set());
+                       help_item_text(topic), n,
+                       client_current_nation_set());
       text_browser->setPlainText(buffer);
     }
   } else {
@@ -1322,7 +1320,7 @@ void help_widget::set_topic_terrain(const help_item *topic,
     for_terr.value.terrain = pterrain;
 
     helptext_terrain(buffer, sizeof(buffer), client.conn.playing,
-                     topic->text, pterrain);
+                     help_item_text(topic), pterrain);
     text_browser->setPlainText(buffer);
 
     // Create information panel
@@ -1471,8 +1469,8 @@ void help_widget::set_topic_extra(const help_item *topic, const char *title)
   char buffer[MAX_HELP_TEXT_SIZE];
   struct extra_type *pextra = extra_type_by_translated_name(title);
   if (pextra) {
-    helptext_extra(buffer, sizeof(buffer), client.conn.playing, topic->text,
-                   pextra);
+    helptext_extra(buffer, sizeof(buffer), client.conn.playing,
+                   help_item_text(topic), pextra);
     text_browser->setPlainText(buffer);
   } else {
     set_topic_other(topic, title);
@@ -1489,7 +1487,7 @@ void help_widget::set_topic_specialist(const help_item *topic,
   struct specialist *pspec = specialist_by_translated_name(title);
   if (pspec) {
     helptext_specialist(buffer, sizeof(buffer), client.conn.playing,
-                        topic->text, pspec);
+                        help_item_text(topic), pspec);
     text_browser->setPlainText(buffer);
   } else {
     set_topic_other(topic, title);
@@ -1506,7 +1504,7 @@ void help_widget::set_topic_government(const help_item *topic,
   struct government *pgov = government_by_translated_name(title);
   if (pgov) {
     helptext_government(buffer, sizeof(buffer), client.conn.playing,
-                        topic->text, pgov);
+                        help_item_text(topic), pgov);
     text_browser->setPlainText(buffer);
   } else {
     set_topic_other(topic, title);
@@ -1521,7 +1519,7 @@ void help_widget::set_topic_nation(const help_item *topic, const char *title)
   char buffer[MAX_HELP_TEXT_SIZE];
   struct nation_type *pnation = nation_by_translated_plural(title);
   if (pnation) {
-    helptext_nation(buffer, sizeof(buffer), pnation, topic->text);
+    helptext_nation(buffer, sizeof(buffer), pnation, help_item_text(topic));
     text_browser->setPlainText(buffer);
   } else {
     set_topic_other(topic, title);
@@ -1536,8 +1534,8 @@ void help_widget::set_topic_goods(const help_item *topic, const char *title)
   char buffer[MAX_HELP_TEXT_SIZE];
   struct goods_type *pgood = goods_by_translated_name(title);
   if (pgood) {
-    helptext_goods(buffer, sizeof(buffer), client.conn.playing, topic->text,
-                   pgood);
+    helptext_goods(buffer, sizeof(buffer), client.conn.playing,
+                   help_item_text(topic), pgood);
     text_browser->setText(buffer);
   } else {
     set_topic_other(topic, title);
@@ -93,6 +93,7 @@
 #include "options.h"
 #include "overview_common.h"
 #include "page_game.h"
+#include "ruleset_cache.h"
 #include "tileset/tilespec.h"
 #include "update_queue.h"
 #include "views/view_map.h"
@@ -2971,6 +2972,7 @@ void handle_tile_info(const struct packet_tile_info *packet)
 
   if (!BV_ARE_EQUAL(ptile->extras, packet->extras)) {
     ptile->extras = packet->extras;
+    city_tile_cache_tile_changed(ptile);
     tile_changed = true;
   }
 
@@ -2984,7 +2986,7 @@ void handle_tile_info(const struct packet_tile_info *packet)
     tile_changed = true;
   }
   if (extra_owner(ptile) != eowner) {
-    ptile->extras_owner = eowner;
+    tile_set_extras_owner(ptile, eowner);
     tile_changed = true;
   }
 
@@ -3330,6 +3332,20 @@ void handle_ruleset_description_part(
              game.control.desc_length + 1);
 }
 
+/**
+   The server is about to send the rulesets. Tell it whether we have them
+   in the cache already.
+ */
+void handle_ruleset_cache_offer(const char *hash)
+{
+  bool cached = ruleset_cache_load(hash);
+
+  if (!cached) {
+    ruleset_cache_record(hash);
+  }
+  dsend_packet_ruleset_cache_reply(&client.conn, hash, cached);
+}
+
 /**
    Received packet indicating that all rulesets have now been received.
  */
@@ -3367,6 +3383,9 @@ void handle_rulesets_ready()
   // Setup improvement feature caches
   improvement_feature_cache_init();
 
+  // Setup tech requirement caches
+  techs_precalc_reqs();
+
   // Setup road integrators caches
   road_integrators_cache_init();
 
@@ -5249,6 +5268,8 @@ void notify_about_incoming_packet(struct connection *pc, int packet_type,
 {
   fc_assert(pc == &client.conn);
   log_debug("incoming packet={type=%d, size=%d}", packet_type, size);
+
+  ruleset_cache_packet_received(pc, packet_type, size);
 }
 
 /**
@@ -0,0 +1,271 @@
+/*
+ Copyright (c) 1996-2020 Freeciv21 and Freeciv contributors. This file is
+ part of Freeciv21. Freeciv21 is free software: you can redistribute it
+ and/or modify it under the terms of the GNU  General Public License  as
+ published by the Free Software Foundation, either version 3 of the
+ License,  or (at your option) any later version. You should have received
+ a copy of the GNU General Public License along with Freeciv21. If not,
+ see https://www.gnu.org/licenses/.
+ */
+
+/**
+  Ruleset packet cache.
+
+  When the server supports it, it announces the hash of the ruleset packets
+  it is about to send. The client keeps the packets of the rulesets it has
+  already received on disk, keyed by that hash, and replays them instead of
+  having them sent again.
+
+  The packets are stored as received: uncompressed frames encoded with the
+  delta protocol against an empty cache, since they are the first packets
+  of their types on a new connection. They are decoded again through a
+  scratch connection, so that the delta state of the real connection stays
+  the same as the one the server has.
+
+  A file holds the SHA-256 checksum of the frames followed by the frames.
+ */
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <vector>
+
+// utility
+#include "log.h"
+#include "version.h"
+
+// common
+#include "capstr.h"
+#include "packets.h"
+
+// client
+#include "client_main.h"
+
+#include "ruleset_cache.h"
+
+// Number of cached rulesets kept on disk.
+#define RULESET_CACHE_FILES 16
+
+// Larger frames would be taken for compressed ones.
+#define RULESET_CACHE_MAX_FRAME (16 * 1024)
+
+// Hash of the ruleset being recorded; empty when not recording.
+static QByteArray recording_hash;
+static QByteArray recording;
+
+/**
+   Returns the directory the rulesets are cached in.
+ */
+static QString ruleset_cache_dir()
+{
+  return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+         + QStringLiteral("/rulesets");
+}
+
+/**
+   Returns the file the ruleset with the given hash is cached in. The
+   encoding of the packets depends on the capabilities and the version, so
+   they are part of the key.
+ */
+static QString ruleset_cache_file(const char *hash)
+{
+  QCryptographicHash key(QCryptographicHash::Sha256);
+
+  key.addData(hash);
+  key.addData(client.conn.capability);
+  key.addData(our_capability);
+  key.addData(freeciv21_version());
+
+  return ruleset_cache_dir() + QStringLiteral("/")
+         + QString::fromLatin1(key.result().toHex())
+         + QStringLiteral(".bin");
+}
+
+/**
+   Returns the length of the frame at 'pos' in 'frames', or -1 if there is
+   no valid frame there.
+ */
+static int ruleset_cache_frame_len(const QByteArray &frames, int pos)
+{
+  int len;
+
+  if (frames.size() - pos < 2) {
+    return -1;
+  }
+  len = (static_cast<unsigned char>(frames[pos]) << 8)
+        | static_cast<unsigned char>(frames[pos + 1]);
+  if (len < 4 || len > RULESET_CACHE_MAX_FRAME
+      || len > frames.size() - pos) {
+    return -1;
+  }
+
+  return len;
+}
+
+/**
+   Decodes the cached frames and hands the packets to the packet handlers.
+   Nothing is handled unless all of them can be decoded.
+ */
+static bool ruleset_cache_replay(const QByteArray &frames)
+{
+  struct connection replay {};
+  std::vector<std::pair<void *, enum packet_type>> packets;
+  bool ok = true;
+
+  connection_common_init(&replay);
+  replay.packet_header = client.conn.packet_header;
+  replay.phs.handlers = client.conn.phs.handlers;
+  conn_set_capability(&replay, client.conn.capability);
+
+  replay.buffer->data = static_cast<unsigned char *>(
+      fc_realloc(replay.buffer->data, frames.size()));
+  replay.buffer->nsize = frames.size();
+  memcpy(replay.buffer->data, frames.constData(), frames.size());
+  replay.buffer->ndata = frames.size();
+
+  while (replay.buffer->ndata > 0) {
+    enum packet_type type;
+    void *packet = get_packet_from_connection(&replay, &type);
+
+    if (packet == nullptr || !replay.closing_reason.isEmpty()) {
+      ::operator delete(packet);
+      ok = false;
+      break;
+    }
+    packets.emplace_back(packet, type);
+  }
+
+  ok = ok && !packets.empty()
+       && packets.front().second == PACKET_RULESET_CONTROL
+       && packets.back().second == PACKET_RULESETS_READY;
+  for (const auto &packet : packets) {
+    if (ok) {
+      client_packet_input(packet.first, packet.second);
+    }
+    ::operator delete(packet.first);
+  }
+
+  connection_common_close(&replay);
+
+  return ok;
+}
+
+/**
+   Removes the least recently used files beyond RULESET_CACHE_FILES.
+ */
+static void ruleset_cache_prune()
+{
+  QDir dir(ruleset_cache_dir());
+  const auto files = dir.entryInfoList({QStringLiteral("*.bin")},
+                                       QDir::Files, QDir::Time);
+
+  for (int i = RULESET_CACHE_FILES; i < files.size(); i++) {
+    QFile::remove(files[i].absoluteFilePath());
+  }
+}
+
+/**
+   Replays the cached ruleset with the given hash. Returns whether it was
+   found, in which case the server doesn't need to send it.
+ */
+bool ruleset_cache_load(const char *hash)
+{
+  QFile file(ruleset_cache_file(hash));
+  QByteArray data, frames;
+  int pos = 0, len;
+
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  data = file.readAll();
+  file.close();
+
+  frames = data.mid(32);
+  if (data.size() <= 32
+      || data.left(32)
+             != QCryptographicHash::hash(frames,
+                                         QCryptographicHash::Sha256)) {
+    qDebug("Ruleset cache %s is corrupt.", qUtf8Printable(file.fileName()));
+    file.remove();
+    return false;
+  }
+
+  while ((len = ruleset_cache_frame_len(frames, pos)) > 0) {
+    pos += len;
+  }
+  if (pos != frames.size() || !ruleset_cache_replay(frames)) {
+    qDebug("Ruleset cache %s can't be decoded.",
+           qUtf8Printable(file.fileName()));
+    file.remove();
+    return false;
+  }
+
+  log_debug("Loaded ruleset %s from the cache (%d bytes).", hash,
+            frames.size());
+  // Mark it as recently used.
+  if (file.open(QIODevice::ReadWrite)) {
+    file.setFileTime(QDateTime::currentDateTime(),
+                     QFileDevice::FileModificationTime);
+    file.close();
+  }
+
+  return true;
+}
+
+/**
+   Starts recording the ruleset packets about to be received, to cache them
+   under the given hash.
+ */
+void ruleset_cache_record(const char *hash)
+{
+  recording_hash = hash;
+  recording.clear();
+}
+
+/**
+   Records the packet that was just received, if it belongs to the ruleset
+   being recorded. The ruleset is written to the cache once complete.
+ */
+void ruleset_cache_packet_received(const struct connection *pc, int type,
+                                   int size)
+{
+  if (recording_hash.isEmpty()) {
+    return;
+  }
+
+  if (type == PACKET_RULESET_CONTROL) {
+    recording.clear();
+  } else if (recording.isEmpty()) {
+    // Not in the rulesets yet.
+    return;
+  }
+  recording.append(reinterpret_cast<const char *>(pc->buffer->data), size);
+
+  if (type == PACKET_RULESETS_READY) {
+    QSaveFile file(ruleset_cache_file(recording_hash.constData()));
+
+    if (QDir().mkpath(ruleset_cache_dir())
+        && file.open(QIODevice::WriteOnly)) {
+      file.write(
+          QCryptographicHash::hash(recording, QCryptographicHash::Sha256));
+      file.write(recording);
+      if (file.commit()) {
+        ruleset_cache_prune();
+      }
+    }
+    ruleset_cache_stop_recording();
+  }
+}
+
+/**
+   Stops recording the ruleset packets, e.g. when the connection changes.
+ */
+void ruleset_cache_stop_recording()
+{
+  recording_hash.clear();
+  recording.clear();
+}
@@ -0,0 +1,18 @@
+/*
+ Copyright (c) 1996-2020 Freeciv21 and Freeciv contributors. This file is
+ part of Freeciv21. Freeciv21 is free software: you can redistribute it
+ and/or modify it under the terms of the GNU  General Public License  as
+ published by the Free Software Foundation, either version 3 of the
+ License,  or (at your option) any later version. You should have received
+ a copy of the GNU General Public License along with Freeciv21. If not,
+ see https://www.gnu.org/licenses/.
+ */
+#pragma once
+
+struct connection;
+
+bool ruleset_cache_load(const char *hash);
+void ruleset_cache_record(const char *hash);
+void ruleset_cache_packet_received(const struct connection *pc, int type,
+                                   int size);
+void ruleset_cache_stop_recording();
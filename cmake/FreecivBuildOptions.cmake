@@ -24,6 +24,10 @@ cmake_dependent_option(
   FREECIV_ENABLE_RULEUP
   "Build the ruleset updater"
   ON FREECIV_ENABLE_TOOLS OFF)
+cmake_dependent_option(
+  FREECIV_ENABLE_BENCH
+  "Build the headless turn benchmark"
+  ON FREECIV_ENABLE_TOOLS OFF)
 
 option(FREECIV_ENABLE_NLS "Enable internationalization" ON)
 
@@ -44,7 +48,8 @@ mark_as_advanced(FREECIV_AI_MOD_LAST)
 if (FREECIV_ENABLE_SERVER
     OR FREECIV_ENABLE_CIVMANUAL
     OR FREECIV_ENABLE_RULEDIT
-    OR FREECIV_ENABLE_RULEUP)
+    OR FREECIV_ENABLE_RULEUP
+    OR FREECIV_ENABLE_BENCH)
   set(FREECIV_BUILD_LIBSERVER TRUE)
 endif()
 
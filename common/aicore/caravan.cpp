@@ -11,7 +11,10 @@
     \_____/ /                     If not, see https://www.gnu.org/licenses/.
       \____/        ********************************************************/
 
+#include <QHash>
+
 #include <cmath>
+#include <vector>
 
 // common
 #include "game.h"
@@ -113,6 +116,79 @@ int caravan_result_compare(const struct caravan_result *a,
 typedef bool (*search_callback)(void *data, const struct city *pcity,
                                 int arrival_turn, int arrival_moves_left);
 
+/* The cities found by a complete search. Caravans built in the same city
+ * usually start from the same tile with the same moves, so the searches
+ * made during a turn are kept and replayed for them. */
+struct caravan_search_stop {
+  int city_id;
+  int turn;
+  int moves_left;
+};
+
+struct caravan_search_cache {
+  struct pf_parameter key;
+  int horizon;
+  std::vector<struct caravan_search_stop> stops;
+};
+
+// More than this many distinct searches in a turn and the cache restarts.
+#define CARAVAN_SEARCH_CACHE_SIZE 64
+
+static std::vector<struct caravan_search_cache> search_cache;
+static int search_cache_turn = -1;
+static int search_cache_phase = -1;
+
+/**
+   Forgets the searches made so far. Cities being founded, changing hands
+   or destroyed change the paths and the cities found, so this must be
+   called then.
+ */
+void caravan_search_cache_clear()
+{
+  search_cache.clear();
+}
+
+/**
+   Returns whether the two searches go through the same positions.
+ */
+static bool caravan_search_same(const struct pf_parameter *a,
+                                const struct pf_parameter *b)
+{
+  return a->owner == b->owner && a->utype == b->utype
+         && a->start_tile == b->start_tile
+         && a->moves_left_initially == b->moves_left_initially
+         && a->move_rate == b->move_rate
+         && a->fuel_left_initially == b->fuel_left_initially
+         && a->transported_by_initially == b->transported_by_initially
+         && a->cargo_depth == b->cargo_depth
+         && BV_ARE_EQUAL(a->cargo_types, b->cargo_types)
+         && a->omniscience == b->omniscience;
+}
+
+/**
+   Returns the cached search matching the parameters, or nullptr. The
+   cache only lasts for the phase.
+ */
+static const struct caravan_search_cache *
+caravan_search_cache_find(const struct pf_parameter *pfparam, int horizon)
+{
+  if (search_cache_turn != game.info.turn
+      || search_cache_phase != game.info.phase) {
+    search_cache.clear();
+    search_cache_turn = game.info.turn;
+    search_cache_phase = game.info.phase;
+  }
+
+  for (const auto &cached : search_cache) {
+    if (cached.horizon == horizon
+        && caravan_search_same(&cached.key, pfparam)) {
+      return &cached;
+    }
+  }
+
+  return nullptr;
+}
+
 static void caravan_search_from(const struct unit *caravan,
                                 const struct caravan_parameter *param,
                                 struct tile *start_tile,
@@ -122,6 +198,9 @@ static void caravan_search_from(const struct unit *caravan,
 {
   struct pf_map *pfm;
   struct pf_parameter pfparam;
+  const struct caravan_search_cache *cached;
+  struct caravan_search_cache found;
+  bool complete = true;
   int end_time;
 
   end_time = param->horizon;
@@ -131,6 +210,22 @@ static void caravan_search_from(const struct unit *caravan,
   pfparam.start_tile = start_tile;
   pfparam.moves_left_initially = moves_left_before;
   pfparam.omniscience = omniscient;
+
+  cached = caravan_search_cache_find(&pfparam, end_time);
+  if (cached != nullptr) {
+    for (const auto &stop : cached->stops) {
+      const struct city *pcity = game_city_by_number(stop.city_id);
+
+      if (pcity != nullptr
+          && callback(callback_data, pcity, stop.turn, stop.moves_left)) {
+        break;
+      }
+    }
+    return;
+  }
+
+  found.key = pfparam;
+  found.horizon = end_time;
   pfm = pf_map_new(&pfparam);
 
   /* For every tile in distance order:
@@ -148,13 +243,25 @@ static void caravan_search_from(const struct unit *caravan,
     }
 
     pcity = tile_city(pos.tile);
-    if (pcity && callback(callback_data, pcity, pos.turn, pos.moves_left)) {
-      break;
+    if (pcity) {
+      found.stops.push_back({pcity->id, pos.turn, pos.moves_left});
+      if (callback(callback_data, pcity, pos.turn, pos.moves_left)) {
+        complete = false;
+        break;
+      }
     }
   }
   pf_map_positions_iterate_end;
 
   pf_map_destroy(pfm);
+
+  // A search stopped by the callback can't be replayed for another one.
+  if (complete) {
+    if (search_cache.size() >= CARAVAN_SEARCH_CACHE_SIZE) {
+      search_cache.clear();
+    }
+    search_cache.push_back(std::move(found));
+  }
 }
 
 /**
@@ -241,6 +348,102 @@ static int one_city_trade_benefit(const struct city *pcity,
   return newtrade - losttrade;
 }
 
+/* What the trade benefit reads from one of the two cities: the base trade
+ * of the new route depends on the size and base trade, and the routes it
+ * would replace on the existing ones. */
+struct trade_benefit_side {
+  const struct player *owner;
+  int size;
+  int base_trade;
+  int routes;
+  int route_value;
+};
+
+/* The trade benefit of the city pairs evaluated during the phase. Many
+ * caravans consider the same pairs; the value is kept as long as neither
+ * city changes in a way that matters to it. */
+struct trade_benefit_cache {
+  const struct player *owner;
+  bool countloser;
+  struct trade_benefit_side src, dest;
+  int value;
+};
+
+static QHash<quint64, struct trade_benefit_cache> trade_cache;
+static int trade_cache_turn = -1;
+static int trade_cache_phase = -1;
+
+/**
+   Fills in what the trade benefit reads from the city.
+ */
+static void trade_benefit_side_get(const struct city *pcity,
+                                   struct trade_benefit_side *side)
+{
+  side->owner = city_owner(pcity);
+  side->size = city_size_get(pcity);
+  side->base_trade = pcity->citizen_base[O_TRADE];
+  side->routes = city_num_trade_routes(pcity);
+  side->route_value = 0;
+  trade_routes_iterate(pcity, proute)
+  {
+    side->route_value += proute->value;
+  }
+  trade_routes_iterate_end;
+}
+
+/**
+   Returns whether the two cities look the same to the trade benefit.
+ */
+static bool trade_benefit_side_same(const struct trade_benefit_side *a,
+                                    const struct trade_benefit_side *b)
+{
+  return a->owner == b->owner && a->size == b->size
+         && a->base_trade == b->base_trade && a->routes == b->routes
+         && a->route_value == b->route_value;
+}
+
+/**
+   Returns the per-turn trade benefit of a new route from src to dest for
+   the caravan owner, i.e. one_city_trade_benefit() for both cities.
+ */
+static int cached_trade_benefit(const struct player *caravan_owner,
+                                const struct city *src,
+                                const struct city *dest, bool countloser)
+{
+  quint64 key = (static_cast<quint64>(static_cast<quint32>(src->id)) << 32)
+                | static_cast<quint32>(dest->id);
+  struct trade_benefit_side src_side, dest_side;
+  struct trade_benefit_cache *cached;
+  int newtrade;
+
+  if (trade_cache_turn != game.info.turn
+      || trade_cache_phase != game.info.phase) {
+    trade_cache.clear();
+    trade_cache_turn = game.info.turn;
+    trade_cache_phase = game.info.phase;
+  }
+
+  trade_benefit_side_get(src, &src_side);
+  trade_benefit_side_get(dest, &dest_side);
+  cached = &trade_cache[key];
+  if (cached->owner == caravan_owner && cached->countloser == countloser
+      && trade_benefit_side_same(&cached->src, &src_side)
+      && trade_benefit_side_same(&cached->dest, &dest_side)) {
+    return cached->value;
+  }
+
+  newtrade = trade_base_between_cities(src, dest);
+  cached->owner = caravan_owner;
+  cached->countloser = countloser;
+  cached->src = src_side;
+  cached->dest = dest_side;
+  cached->value =
+      one_city_trade_benefit(src, caravan_owner, countloser, newtrade)
+      + one_city_trade_benefit(dest, caravan_owner, countloser, newtrade);
+
+  return cached->value;
+}
+
 /**
    Compute one_trade_benefit for both cities and do some other logic.
    This yields the total benefit in terms of trade per turn of establishing
@@ -267,12 +470,8 @@ static double trade_benefit(const struct player *caravan_owner,
   }
 
   if (!param->convert_trade) {
-    bool countloser = param->account_for_broken_routes;
-    int newtrade = trade_base_between_cities(src, dest);
-
-    return one_city_trade_benefit(src, caravan_owner, countloser, newtrade)
-           + one_city_trade_benefit(dest, caravan_owner, countloser,
-                                    newtrade);
+    return cached_trade_benefit(caravan_owner, src, dest,
+                                param->account_for_broken_routes);
   } else {
     // Always fails.
     fc_assert_msg(false == param->convert_trade,
@@ -93,9 +93,12 @@ struct one_perf {
   civtimer *wall_timer;
   int query_count;
   int apply_count;
+  int node_count;
   const char *name;
 };
-static struct {
+/* Queries may run on worker threads (see auto_arrange_workers_list()),
+ * so each thread gathers its own statistics. */
+static thread_local struct {
   one_perf greedy, opt;
   struct one_perf *current;
 } performance;
@@ -212,6 +215,10 @@ struct cm_state {
   // needed luxury to be content, this includes effects by specialists
   int min_luxury;
 
+  /* production of the tiles worked for free (the city center), which
+   * doesn't depend on the worker arrangement */
+  int free_production[O_LAST];
+
   // the current solution we're examining.
   struct partial_solution current;
 
@@ -225,6 +232,9 @@ struct cm_state {
   } choice;
 
   bool *workers_map; // placement of the workers within the city map
+
+  // branch & bound nodes explored by all the queries on this state
+  int node_count;
 };
 
 // return #fields + specialist types
@@ -850,8 +860,8 @@ static int compare_tile_type_by_fitness(const void *va, const void *vb)
   return compare_tile_type_by_lattice_order(*a, *b);
 }
 
-static Output_type_id compare_key;
-static double compare_key_trade_bonus;
+static thread_local Output_type_id compare_key;
+static thread_local double compare_key_trade_bonus;
 
 /**
    Compare by the production of type compare_key.
@@ -1596,21 +1606,11 @@ static void compute_max_stats_heuristic(const struct cm_state *state,
      we add free production, and have the city.c code do the rest */
 
   struct city *pcity = state->pcity;
-  struct tile *pcenter = city_tile(pcity);
-  bool is_celebrating = base_city_celebrating(pcity);
 
   output_type_iterate(stat_index)
   {
-    int base = production[stat_index];
-
-    city_tile_iterate(city_map_radius_sq_get(pcity), pcenter, ptile)
-    {
-      if (is_free_worked(pcity, ptile)) {
-        base += city_tile_output(pcity, ptile, is_celebrating, stat_index);
-      }
-    }
-    city_tile_iterate_end;
-    pcity->citizen_base[stat_index] = base;
+    pcity->citizen_base[stat_index] =
+        production[stat_index] + state->free_production[stat_index];
   }
   output_type_iterate_end;
 
@@ -1830,12 +1830,16 @@ static bool bb_next(struct cm_state *state, bool negative_ok)
 }
 
 /**
-   Initialize the state for the branch-and-bound algorithm.
+   Initialize the state for the branch-and-bound algorithm. The state holds
+   the tile lattice of the city and can be used for several queries with
+   different parameters, see cm_state_query().
  */
-static struct cm_state *cm_state_init(struct city *pcity, bool negative_ok)
+struct cm_state *cm_state_init(struct city *pcity, bool negative_ok)
 {
   const int SCIENCE = 0, TAX = 1, LUXURY = 2;
   const struct player *pplayer = city_owner(pcity);
+  struct tile *pcenter = city_tile(pcity);
+  bool is_celebrating = base_city_celebrating(pcity);
   int numtypes;
   auto *state = new cm_state;
   int rates[3];
@@ -1845,6 +1849,7 @@ static struct cm_state *cm_state_init(struct city *pcity, bool negative_ok)
 
   // copy the arguments
   state->pcity = pcity;
+  state->node_count = 0;
 
   // create the lattice
   tile_type_vector_init(&state->lattice);
@@ -1886,6 +1891,21 @@ static struct cm_state *cm_state_init(struct city *pcity, bool negative_ok)
 
   state->min_luxury = -FC_INFINITY;
 
+  // The free tiles produce the same whatever the arrangement
+  output_type_iterate(stat_index)
+  {
+    state->free_production[stat_index] = 0;
+    city_tile_iterate(city_map_radius_sq_get(pcity), pcenter, ptile)
+    {
+      if (is_free_worked(pcity, ptile)) {
+        state->free_production[stat_index] +=
+            city_tile_output(pcity, ptile, is_celebrating, stat_index);
+      }
+    }
+    city_tile_iterate_end;
+  }
+  output_type_iterate_end;
+
   // We have no best solution yet, so its value is the worst possible.
   init_partial_solution(&state->best, numtypes, city_size_get(pcity),
                         negative_ok);
@@ -1967,6 +1987,11 @@ static void begin_search(struct cm_state *state,
                          bool negative_ok)
 {
 #ifdef GATHER_TIME_STATS
+  if (performance.current->wall_timer == nullptr) {
+    // First query on a worker thread; cm_init() only set up the main one.
+    performance.current->wall_timer = timer_new(TIMER_USER, TIMER_ACTIVE);
+    performance.current->name = "opt";
+  }
   timer_start(performance.current->wall_timer);
   performance.current->query_count++;
 #endif // GATHER_TIME_STATS
@@ -1981,9 +2006,14 @@ static void begin_search(struct cm_state *state,
   }
 
   init_min_production(state);
+  state->min_luxury = -FC_INFINITY;
 
-  // clear out the old solution
+  /* clear out the old solutions; the lattice was just resorted and the
+   * best solution may come from a query with another parameter */
   state->best_value = worst_fitness();
+  destroy_partial_solution(&state->best);
+  init_partial_solution(&state->best, num_types(state),
+                        city_size_get(state->pcity), negative_ok);
   destroy_partial_solution(&state->current);
   init_partial_solution(&state->current, num_types(state),
                         city_size_get(state->pcity), negative_ok);
@@ -1994,11 +2024,13 @@ static void begin_search(struct cm_state *state,
    Clean up after a search.
    Currently, does nothing except stop the timer and output.
  */
-static void end_search(struct cm_state *state)
+static void end_search(struct cm_state *state, int loop_count)
 {
+  Q_UNUSED(loop_count)
   Q_UNUSED(state)
 #ifdef GATHER_TIME_STATS
   timer_stop(performance.current->wall_timer);
+  performance.current->node_count += loop_count;
 
 #ifdef PRINT_TIME_STATS_EVERY_QUERY
   print_performance(performance.current);
@@ -2011,7 +2043,7 @@ static void end_search(struct cm_state *state)
 /**
    Release all the memory allocated by the state.
  */
-static void cm_state_free(struct cm_state *state)
+void cm_state_free(struct cm_state *state)
 {
   tile_type_vector_free_all(&state->lattice);
   output_type_iterate(stat_index)
@@ -2078,7 +2110,8 @@ static void cm_find_best_solution(struct cm_state *state,
 
   memcpy(state->pcity, &backup, sizeof(backup));
 
-  end_search(state);
+  state->node_count += loop_count;
+  end_search(state, loop_count);
 }
 
 /**
@@ -2090,13 +2123,34 @@ void cm_query_result(struct city *pcity, const struct cm_parameter *param,
 {
   struct cm_state *state = cm_state_init(pcity, negative_ok);
 
+  cm_state_query(state, param, result, negative_ok);
+  cm_state_free(state);
+}
+
+/**
+   Run a query on a state from cm_state_init(). The lattice is kept, so
+   asking again with a relaxed parameter only costs the search itself.
+   The city must not have changed since the state was created.
+ */
+void cm_state_query(struct cm_state *state,
+                    const struct cm_parameter *const parameter,
+                    std::unique_ptr<cm_result> &result, bool negative_ok)
+{
   /* Refresh the city.  Otherwise the CM can give wrong results or just be
    * slower than necessary.  Note that cities are often passed in in an
    * unrefreshed state (which should probably be fixed). */
-  city_refresh_from_main_map(pcity, nullptr);
+  city_refresh_from_main_map(state->pcity, nullptr);
 
-  cm_find_best_solution(state, param, result, negative_ok);
-  cm_state_free(state);
+  cm_find_best_solution(state, parameter, result, negative_ok);
+}
+
+/**
+   Returns the number of branch & bound nodes explored by all the queries
+   made on the state so far.
+ */
+int cm_state_node_count(const struct cm_state *state)
+{
+  return state->node_count;
 }
 
 bool operator==(const struct cm_parameter &p1, const struct cm_parameter &p2)
@@ -2383,7 +2437,7 @@ static void print_performance(struct one_perf *counts)
 {
   double s, ms;
   double q;
-  int queries, applies;
+  int queries, applies, nodes;
 
   s = timer_read_seconds(counts->wall_timer);
   ms = 1000.0 * s;
@@ -2392,10 +2446,12 @@ static void print_performance(struct one_perf *counts)
   q = queries;
 
   applies = counts->apply_count;
+  nodes = counts->node_count;
 
   qCDebug(timers_category,
-          "CM-%s: overall=%fs queries=%d %fms / query, %d applies",
-          counts->name, s, queries, ms / q, applies);
+          "CM-%s: overall=%fs queries=%d %fms / query, %d applies, "
+          "%d nodes",
+          counts->name, s, queries, ms / q, applies, nodes);
 }
 #endif // GATHER_TIME_STATS
 
@@ -60,6 +60,20 @@ void cm_query_result(struct city *pcity,
                      const struct cm_parameter *const parameter,
                      std::unique_ptr<cm_result> &result, bool negative_ok);
 
+/*
+ * Same as cm_query_result(), but the tile lattice of the city is built
+ * once by cm_state_init() and shared by all the queries made with
+ * cm_state_query(), e.g. when retrying with a relaxed parameter. The city
+ * must not change in between.
+ */
+struct cm_state;
+struct cm_state *cm_state_init(struct city *pcity, bool negative_ok);
+void cm_state_query(struct cm_state *state,
+                    const struct cm_parameter *const parameter,
+                    std::unique_ptr<cm_result> &result, bool negative_ok);
+void cm_state_free(struct cm_state *state);
+int cm_state_node_count(const struct cm_state *state);
+
 /***************** utility methods *************************************/
 bool operator==(const struct cm_parameter &p1,
                 const struct cm_parameter &p2);
@@ -43,6 +43,9 @@ void citizens_init(struct city *pcity)
     memset(pcity->nationality, 0,
            MAX_NUM_PLAYER_SLOTS * sizeof(*pcity->nationality));
   }
+  if (is_server()) {
+    pcity->server.info_dirty |= CITY_INFO_CITIZENS;
+  }
 }
 
 /**
@@ -146,6 +149,9 @@ void citizens_nation_set(struct city *pcity, const struct player_slot *pslot,
   fc_assert_ret(pcity->nationality != nullptr);
 
   *(pcity->nationality + player_slot_index(pslot)) = count;
+  if (is_server()) {
+    pcity->server.info_dirty |= CITY_INFO_CITIZENS;
+  }
 }
 
 /**
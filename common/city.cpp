@@ -11,6 +11,7 @@
     \_____/ /                     If not, see https://www.gnu.org/licenses/.
       \____/        ********************************************************/
 
+#include <atomic>
 #include <cmath> // pow, sqrt, exp
 #include <cstdlib>
 #include <cstring>
@@ -68,6 +69,11 @@ struct tile_cache {
   int output[O_LAST];
 };
 
+/* Bumped whenever the outputs of all tile caches may have changed, i.e.
+ * when a building or an advance changes hands. Atomic because the city
+ * governor refreshes cities on worker threads. */
+static std::atomic<int> tile_cache_generation{1};
+
 static inline void city_tile_cache_update(struct city *pcity);
 static inline int city_tile_cache_get_output(const struct city *pcity,
                                              int city_tile_index,
@@ -2299,13 +2305,162 @@ static inline void set_city_bonuses(struct city *pcity)
   output_type_iterate_end;
 }
 
+/**
+   Returns whether the tile outputs can only change through the state kept
+   in the tile_cache_stamp, the tiles around the city and the changes
+   tracked by tile_cache_generation, when they depend on a requirement.
+ */
+static bool tile_cache_tracks_req(const struct requirement *preq)
+{
+  if (preq->range == REQ_RANGE_TEAM || preq->range == REQ_RANGE_ALLIANCE) {
+    // Treaties are not tracked.
+    return false;
+  }
+
+  switch (preq->source.kind) {
+  case VUT_NONE:
+  case VUT_ADVANCE:
+  case VUT_TECHFLAG:
+  case VUT_MINTECHS:
+  case VUT_GOVERNMENT:
+  case VUT_IMPROVEMENT:
+  case VUT_IMPR_GENUS:
+  case VUT_SPECIALIST:
+  case VUT_MINSIZE:
+  case VUT_NATION:
+  case VUT_NATIONGROUP:
+  case VUT_STYLE:
+  case VUT_ACHIEVEMENT:
+  case VUT_MINYEAR:
+  case VUT_MINCALFRAG:
+  case VUT_TOPO:
+  case VUT_OTYPE:
+  case VUT_CITYSTATUS:
+  case VUT_CITYTILE:
+  case VUT_TERRAIN:
+  case VUT_TERRAINCLASS:
+  case VUT_TERRFLAG:
+  case VUT_TERRAINALTER:
+  case VUT_EXTRA:
+  case VUT_EXTRAFLAG:
+  case VUT_ROADFLAG:
+  case VUT_BASEFLAG:
+  // There is no unit when computing tile outputs.
+  case VUT_UTYPE:
+  case VUT_UTFLAG:
+  case VUT_UCLASS:
+  case VUT_UCFLAG:
+  case VUT_MINVETERAN:
+  case VUT_UNITSTATE:
+  case VUT_ACTIVITY:
+  case VUT_MINMOVES:
+  case VUT_MINHP:
+  case VUT_AGE:
+  case VUT_ACTION:
+    return true;
+  // Culture includes the performance, which changes within a turn.
+  case VUT_MINCULTURE:
+  // The nationality of the citizens is not part of the stamp.
+  case VUT_NATIONALITY:
+  case VUT_MINFOREIGNPCT:
+  case VUT_AI_LEVEL:
+  case VUT_GOOD:
+  case VUT_DIPLREL:
+  case VUT_MAXTILEUNITS:
+  case VUT_SERVERSETTING:
+  case VUT_VISIONLAYER:
+  case VUT_NINTEL:
+  case VUT_GAMEMODE:
+  case VUT_COUNT:
+    break;
+  }
+
+  return false;
+}
+
+/**
+   Returns whether the tile caches can be kept across refreshes with the
+   current ruleset. They can't when one of the effects used to compute the
+   tile outputs depends on something that isn't tracked.
+
+   Safe to call from several threads: they compute the same answer, and
+   once the effects are checked, which a refresh on the main thread does,
+   the others only read it.
+ */
+static bool tile_cache_is_usable()
+{
+  static const enum effect_type types[] = {
+      EFT_MINING_PCT,           EFT_IRRIGATION_PCT,
+      EFT_OUTPUT_ADD_TILE,      EFT_OUTPUT_PENALTY_TILE,
+      EFT_OUTPUT_INC_TILE,      EFT_OUTPUT_INC_TILE_CELEBRATE,
+      EFT_OUTPUT_PER_TILE,      EFT_OUTPUT_TILE_PUNISH_PCT};
+  static std::atomic<int> checked_generation{-1};
+  static std::atomic<bool> checked_usable{false};
+  bool usable = true;
+
+  if (checked_generation.load(std::memory_order_acquire)
+      == effects_generation()) {
+    return checked_usable.load(std::memory_order_relaxed);
+  }
+
+  for (auto type : types) {
+    effect_list_iterate(get_effects(type), peffect)
+    {
+      requirement_vector_iterate(&peffect->reqs, preq)
+      {
+        usable = usable && tile_cache_tracks_req(preq);
+      }
+      requirement_vector_iterate_end;
+    }
+    effect_list_iterate_end;
+  }
+  checked_usable.store(usable, std::memory_order_relaxed);
+  // The effects changed: none of the caches can be trusted.
+  city_tile_cache_invalidate_all();
+  checked_generation.store(effects_generation(), std::memory_order_release);
+
+  return usable;
+}
+
+/**
+   Forgets the tile outputs cached for all cities, e.g. when an advance
+   that may change them has been gained or lost.
+ */
+void city_tile_cache_invalidate_all() { tile_cache_generation++; }
+
+/**
+   Forgets the tile outputs cached for the cities that may work the given
+   tile, or whose workable tiles may depend on it. Call it when the terrain,
+   the extras, the resource, the owner or the extras owner of the tile
+   changes.
+ */
+void city_tile_cache_tile_changed(const struct tile *ptile)
+{
+  if (wld.cities == nullptr || wld.cities->isEmpty()
+      || tile_virtual_check(ptile)) {
+    return;
+  }
+
+  // Adjacency requirements reach one tile beyond the city radius.
+  square_iterate(&(wld.map), ptile, CITY_MAP_MAX_RADIUS + 1, ptile1)
+  {
+    struct city *pcity = tile_city(ptile1);
+
+    if (pcity != nullptr) {
+      pcity->tile_cache_stamp.generation = 0;
+    }
+  }
+  square_iterate_end;
+}
+
 /**
    This function sets the cache for the tile outputs, the pcity->tile_cache[]
    array. It is called near the beginning of city_refresh_from_main_map().
 
    It doesn't depend on anything else in the refresh and doesn't change
    as workers are moved around, but does change when buildings are built,
-   etc.
+   etc. The outputs are kept as long as the tile_cache_stamp of the city
+   still matches; tile and game changes that the stamp can't see reset it.
 
    TODO: use the cached values elsewhere in the code!
  */
@@ -2313,6 +2468,7 @@ static inline void city_tile_cache_update(struct city *pcity)
 {
   bool is_celebrating = base_city_celebrating(pcity);
   int radius_sq = city_map_radius_sq_get(pcity);
+  struct tile_cache_stamp stamp;
 
   // initialize tile_cache if needed
   if (pcity->tile_cache == nullptr || pcity->tile_cache_radius_sq == -1
@@ -2321,7 +2477,28 @@ static inline void city_tile_cache_update(struct city *pcity)
         fc_realloc(pcity->tile_cache, city_map_tiles(radius_sq)
                                           * sizeof(*(pcity->tile_cache))));
     pcity->tile_cache_radius_sq = radius_sq;
+    pcity->tile_cache_stamp.generation = 0;
+  }
+
+  stamp.generation = tile_cache_is_usable() ? tile_cache_generation : 0;
+  stamp.turn = game.info.turn;
+  stamp.size = city_size_get(pcity);
+  stamp.celebrating = is_celebrating;
+  stamp.owner = city_owner(pcity);
+  stamp.government = government_of_player(stamp.owner);
+  stamp.style = pcity->style;
+
+  if (stamp.generation != 0
+      && stamp.generation == pcity->tile_cache_stamp.generation
+      && stamp.turn == pcity->tile_cache_stamp.turn
+      && stamp.size == pcity->tile_cache_stamp.size
+      && stamp.celebrating == pcity->tile_cache_stamp.celebrating
+      && stamp.owner == pcity->tile_cache_stamp.owner
+      && stamp.government == pcity->tile_cache_stamp.government
+      && stamp.style == pcity->tile_cache_stamp.style) {
+    return;
   }
+  pcity->tile_cache_stamp = stamp;
 
   /* Any unreal tiles are skipped - these values should have been memset
    * to 0 when the city was created. */
@@ -3275,6 +3452,11 @@ void city_add_improvement(struct city *pcity,
 {
   pcity->built[improvement_index(pimprove)].turn =
       game.info.turn; /*I_ACTIVE*/
+  city_tile_cache_invalidate_all();
+
+  if (is_server()) {
+    pcity->server.info_dirty |= CITY_INFO_IMPROVEMENTS;
+  }
 
   if (is_server() && is_wonder(pimprove)) {
     // Client just read the info from the packets.
@@ -3292,6 +3474,11 @@ void city_remove_improvement(struct city *pcity,
             improvement_rule_name(pimprove), pcity->name);
 
   pcity->built[improvement_index(pimprove)].turn = I_DESTROYED;
+  city_tile_cache_invalidate_all();
+
+  if (is_server()) {
+    pcity->server.info_dirty |= CITY_INFO_IMPROVEMENTS;
+  }
 
   if (is_server() && is_wonder(pimprove)) {
     // Client just read the info from the packets.
@@ -3384,6 +3571,7 @@ struct city *create_city_virtual(struct player *pplayer, struct tile *ptile,
   pcity->turn_last_built = game.info.turn;
 
   pcity->tile_cache_radius_sq = -1; // -1 = tile_cache must be initialised
+  pcity->tile_cache_stamp.generation = 0;
 
   // pcity->ai.act_cache: worker activities on the city map
 
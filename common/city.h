@@ -274,8 +274,28 @@ enum city_updates {
   CU_POPUP_DIALOG = 1 << 2
 };
 
+/* Parts of the city info packet that the server only packs again after
+ * they changed (see package_city()). */
+enum city_info_part {
+  CITY_INFO_CITIZENS = 1 << 0,
+  CITY_INFO_IMPROVEMENTS = 1 << 1
+};
+
+struct city_info_cache; // defined and only used within citytools.c
 struct tile_cache; // defined and only used within city.c
 
+/* The state of the city and the game the outputs in the tile_cache depend
+ * on, other than the tiles themselves. */
+struct tile_cache_stamp {
+  int generation; // 0 when the tile_cache must be recomputed
+  int turn;
+  int size;
+  bool celebrating;
+  const struct player *owner;
+  const struct government *government;
+  int style;
+};
+
 struct adv_city; /* defined in ./server/advisors/infracache.h */
 
 struct cm_parameter; /* defined in ./common/aicore/cm.h */
@@ -314,6 +334,8 @@ struct city {
   /* The memory allocated for tile_cache is valid for this squared city
    * radius. */
   int tile_cache_radius_sq;
+  // What the tile_cache was computed for; it is kept while this matches.
+  struct tile_cache_stamp tile_cache_stamp;
 
   // the productions
   int surplus[O_LAST];         // Final surplus in each category.
@@ -412,6 +434,11 @@ struct city {
       // the city map is synced with the client.
       bool synced;
 
+      /* The parts of the city info packed last time, and those of them
+       * that changed since (enum city_info_part). */
+      struct city_info_cache *info_cache;
+      int info_dirty;
+
       bool debug; // not saved
 
       struct adv_city *adv;
@@ -698,6 +725,8 @@ void city_remove_improvement(struct city *pcity,
 
 // city update functions
 void city_refresh_from_main_map(struct city *pcity, bool *workers_map);
+void city_tile_cache_invalidate_all();
+void city_tile_cache_tile_changed(const struct tile *ptile);
 
 int city_waste(const struct city *pcity, Output_type_id otype, int total,
                int *breakdown);
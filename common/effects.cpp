@@ -111,6 +111,16 @@ static struct {
   } reqs;
 } ruleset_cache;
 
+// Changed whenever an effect is added or changed, see effects_generation().
+static int generation = 0;
+
+/**
+   Returns a number that changes whenever the effects of the ruleset are
+   added to or changed. Caches of effect values can compare it to the one
+   they were filled with.
+ */
+int effects_generation() { return generation; }
+
 /**
    Get a list of all effects.
  */
@@ -172,6 +182,7 @@ struct effect *effect_new(enum effect_type type, int value,
   peffect->multiplier = pmul;
 
   requirement_vector_init(&peffect->reqs);
+  generation++;
 
   // Now add the effect to the ruleset cache.
   effect_list_append(ruleset_cache.tracker, peffect);
@@ -205,6 +216,7 @@ void effect_req_append(struct effect *peffect, struct requirement req)
   struct effect_list *eff_list = get_req_source_effects(&req.source);
 
   requirement_vector_append(&peffect->reqs, req);
+  generation++;
 
   if (eff_list) {
     effect_list_append(eff_list, peffect);
@@ -221,6 +233,7 @@ void ruleset_cache_init()
   int i;
 
   initialized = true;
+  generation++;
 
   ruleset_cache.tracker = effect_list_new();
 
@@ -406,6 +406,7 @@ struct packet_ruleset_effect;
 
 void ruleset_cache_init();
 void ruleset_cache_free();
+int effects_generation();
 void recv_ruleset_effect(const struct packet_ruleset_effect *packet);
 void send_ruleset_cache(struct conn_list *dest);
 
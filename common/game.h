@@ -169,6 +169,9 @@ struct civ_game {
       int revolution_length;
       int spaceship_travel_time;
       bool threaded_save;
+      bool threaded_arrange;
+      int luatimelimit;
+      int luainstrlimit;
       enum compress_type save_compress_type;
       int save_nturns;
       int save_frequency;
@@ -659,6 +662,16 @@ extern struct world wld;
 
 #define GAME_DEFAULT_THREADED_SAVE false
 
+#define GAME_DEFAULT_THREADED_ARRANGE false
+
+#define GAME_DEFAULT_LUATIMELIMIT 5000
+#define GAME_MIN_LUATIMELIMIT 0
+#define GAME_MAX_LUATIMELIMIT 60000
+
+#define GAME_DEFAULT_LUAINSTRLIMIT 0
+#define GAME_MIN_LUAINSTRLIMIT 0
+#define GAME_MAX_LUAINSTRLIMIT 1000000
+
 #define GAME_DEFAULT_USER_META_MESSAGE ""
 
 #define GAME_DEFAULT_SKILL_LEVEL AI_LEVEL_EASY
@@ -19,6 +19,7 @@
 #include <fc_config.h>
 
 #include <QBitArray>
+#include <QElapsedTimer>
 #include <QList>
 
 #include <cstring>
@@ -661,6 +662,115 @@ struct help_item *new_help_item(help_page_type type)
   return pitem;
 }
 
+/**
+   Returns the text of the help item, generating it if this is the first
+   time it is needed. Never returns nullptr.
+ */
+const char *help_item_text(const struct help_item *pitem)
+{
+  if (pitem->text == nullptr && pitem->generate) {
+    pitem->text = qstrdup(qUtf8Printable(pitem->generate()));
+    pitem->generate = nullptr;
+  }
+
+  return pitem->text != nullptr ? pitem->text : "";
+}
+
+/**
+   Returns the text of a "help_" section of helpdata.txt, made of the
+   given paragraphs. Paragraphs starting with '$' are generated.
+ */
+static QString help_text_from_paras(const QStringList &paras)
+{
+  char long_buffer[64000]; // HACK: this may be overrun.
+
+  long_buffer[0] = '\0';
+  for (int i = 0; i < paras.size(); i++) {
+    bool inserted;
+    QByteArray para = paras[i].toUtf8();
+
+    if (para.startsWith('$')) {
+      inserted = insert_generated_text(long_buffer, sizeof(long_buffer),
+                                       para.constData() + 1);
+    } else {
+      sz_strlcat(long_buffer, _(para.constData()));
+      inserted = true;
+    }
+    if (inserted && i != paras.size() - 1) {
+      sz_strlcat(long_buffer, "\n\n");
+    }
+  }
+
+  return QString::fromUtf8(long_buffer);
+}
+
+/**
+   Returns the text of the ruleset help page.
+ */
+static QString help_text_ruleset()
+{
+  QString text = _(game.control.name);
+
+  if (game.control.version[0] != '\0') {
+    text += QStringLiteral(" ") + QString::fromUtf8(game.control.version);
+  }
+  text += QStringLiteral("\n\n");
+  if (game.ruleset_summary != nullptr) {
+    text += _(game.ruleset_summary);
+  } else {
+    text += _("Current ruleset contains no summary.");
+  }
+  if (game.ruleset_description != nullptr) {
+    text += QStringLiteral("\n\n")
+            + QString::fromUtf8(game.ruleset_description);
+  }
+
+  return text;
+}
+
+/**
+   Returns the text of the help page of a multiplier.
+ */
+static QString help_text_multiplier(const struct multiplier *pmul)
+{
+  if (pmul->helptext == nullptr) {
+    return QString();
+  }
+
+  return QStringList(pmul->helptext->toList())
+      .join(QStringLiteral("\n\n"));
+}
+
+/**
+   Returns the text of the help page of an effect type: the list of the
+   effects contributing to it.
+ */
+static QString help_text_effect(enum effect_type type)
+{
+  char buf[MAX_LEN_PACKET];
+  QString all_text = _("The following rules contribute to the "
+                       "value of this effect:\n");
+
+  effect_list_iterate(get_effects(type), peffect)
+  {
+    if (requirement_vector_size(&peffect->reqs) == 0) {
+      all_text += QString(_("* %1 by default\n"))
+                      .arg(effect_type_unit_text(peffect->type,
+                                                 peffect->value));
+    } else {
+      buf[0] = '\0';
+      get_effect_req_text(peffect, buf, sizeof(buf));
+      all_text += QString(_("* %1 with %2\n"))
+                      .arg(effect_type_unit_text(peffect->type,
+                                                 peffect->value))
+                      .arg(buf);
+    }
+  }
+  effect_list_iterate_end;
+
+  return all_text;
+}
+
 /**
    For help_list_sort(); sort by topic via compare_strings()
    (sort topics with more leading spaces after those with fewer)
@@ -689,10 +799,9 @@ void boot_help_texts(const nation_set *nations_to_show,
   struct section_list *sec;
   const char **paras;
   size_t npara;
-  char empty[1];
-  char long_buffer[64000]; // HACK: this may be overrun.
+  QElapsedTimer timer;
 
-  empty[0] = '\0';
+  timer.start();
 
   // need to do something like this or bad things happen
   free_help_texts();
@@ -717,7 +826,6 @@ void boot_help_texts(const nation_set *nations_to_show,
   if (nullptr != sec) {
     section_list_iterate(sec, psection)
     {
-      char help_text_buffer[MAX_LEN_PACKET];
       const char *sec_name = section_name(psection);
       const char *gen_str = secfile_lookup_str(sf, "%s.generate", sec_name);
 
@@ -768,7 +876,6 @@ void boot_help_texts(const nation_set *nations_to_show,
               fc_snprintf(name, sizeof(name), "%*s%s", level, "",
                           utype_name_translation(punittype));
               pitem->topic = qstrdup(name);
-              pitem->text = qstrdup(empty);
               category_nodes.append(pitem);
             }
             unit_type_iterate_end;
@@ -782,7 +889,6 @@ void boot_help_texts(const nation_set *nations_to_show,
                     name, sizeof(name), "%*s%s", level, "",
                     advance_name_translation(advance_by_number(advi)));
                 pitem->topic = qstrdup(name);
-                pitem->text = qstrdup(empty);
                 category_nodes.append(pitem);
               }
             }
@@ -796,7 +902,6 @@ void boot_help_texts(const nation_set *nations_to_show,
                 fc_snprintf(name, sizeof(name), "%*s%s", level, "",
                             terrain_name_translation(pterrain));
                 pitem->topic = qstrdup(name);
-                pitem->text = qstrdup(empty);
                 category_nodes.append(pitem);
               }
             }
@@ -829,7 +934,6 @@ void boot_help_texts(const nation_set *nations_to_show,
               fc_snprintf(name, sizeof(name), "%*s%s", level, "",
                           extra_name_translation(pextra));
               pitem->topic = qstrdup(name);
-              pitem->text = qstrdup(empty);
               category_nodes.append(pitem);
             }
             extra_type_iterate_end;
@@ -843,7 +947,6 @@ void boot_help_texts(const nation_set *nations_to_show,
               fc_snprintf(name, sizeof(name), "%*s%s", level, "",
                           goods_name_translation(pgood));
               pitem->topic = qstrdup(name);
-              pitem->text = qstrdup(empty);
               category_nodes.append(pitem);
             }
             goods_type_iterate_end;
@@ -857,7 +960,6 @@ void boot_help_texts(const nation_set *nations_to_show,
               fc_snprintf(name, sizeof(name), "%*s%s", level, "",
                           specialist_plural_translation(pspec));
               pitem->topic = qstrdup(name);
-              pitem->text = qstrdup(empty);
               category_nodes.append(pitem);
             }
             specialist_type_iterate_end;
@@ -868,7 +970,6 @@ void boot_help_texts(const nation_set *nations_to_show,
               fc_snprintf(name, sizeof(name), "%*s%s", level, "",
                           government_name_translation(&gov));
               pitem->topic = qstrdup(name);
-              pitem->text = qstrdup(empty);
               category_nodes.append(pitem);
             };
             break;
@@ -881,7 +982,6 @@ void boot_help_texts(const nation_set *nations_to_show,
                 fc_snprintf(name, sizeof(name), "%*s%s", level, "",
                             improvement_name_translation(pimprove));
                 pitem->topic = qstrdup(name);
-                pitem->text = qstrdup(empty);
                 category_nodes.append(pitem);
               }
             }
@@ -895,70 +995,18 @@ void boot_help_texts(const nation_set *nations_to_show,
                 fc_snprintf(name, sizeof(name), "%*s%s", level, "",
                             improvement_name_translation(pimprove));
                 pitem->topic = qstrdup(name);
-                pitem->text = qstrdup(empty);
                 category_nodes.append(pitem);
               }
             }
             improvement_iterate_end;
             break;
           case HELP_RULESET: {
-            int desc_len;
-            int len;
-
             pitem = new_help_item(HELP_RULESET);
             //           pitem->topic = qstrdup(_(game.control.name));
             fc_snprintf(name, sizeof(name), "%*s%s", level, "",
                         Q_(HELP_RULESET_ITEM));
             pitem->topic = qstrdup(name);
-            if (game.ruleset_description != nullptr) {
-              desc_len = qstrlen("\n\n") + qstrlen(game.ruleset_description);
-            } else {
-              desc_len = 0;
-            }
-            if (game.ruleset_summary != nullptr) {
-              if (game.control.version[0] != '\0') {
-                len = qstrlen(_(game.control.name)) + qstrlen(" ")
-                      + qstrlen(game.control.version) + qstrlen("\n\n")
-                      + qstrlen(_(game.ruleset_summary)) + 1;
-
-                pitem->text = new char[len + desc_len];
-                fc_snprintf(pitem->text, len, "%s %s\n\n%s",
-                            _(game.control.name), game.control.version,
-                            _(game.ruleset_summary));
-              } else {
-                len = qstrlen(_(game.control.name)) + qstrlen("\n\n")
-                      + qstrlen(_(game.ruleset_summary)) + 1;
-
-                pitem->text = new char[len + desc_len];
-                fc_snprintf(pitem->text, len, "%s\n\n%s",
-                            _(game.control.name), _(game.ruleset_summary));
-              }
-            } else {
-              const char *nodesc = _("Current ruleset contains no summary.");
-
-              if (game.control.version[0] != '\0') {
-                len = qstrlen(_(game.control.name)) + qstrlen(" ")
-                      + qstrlen(game.control.version) + qstrlen("\n\n")
-                      + qstrlen(nodesc) + 1;
-
-                pitem->text = new char[len + desc_len];
-                fc_snprintf(pitem->text, len, "%s %s\n\n%s",
-                            _(game.control.name), game.control.version,
-                            nodesc);
-              } else {
-                len = qstrlen(_(game.control.name)) + qstrlen("\n\n")
-                      + qstrlen(nodesc) + 1;
-
-                pitem->text = new char[len + desc_len];
-                fc_snprintf(pitem->text, len, "%s\n\n%s",
-                            _(game.control.name), nodesc);
-              }
-            }
-            if (game.ruleset_description != nullptr) {
-              fc_strlcat(pitem->text, "\n\n", len + desc_len);
-              fc_strlcat(pitem->text, game.ruleset_description,
-                         len + desc_len);
-            }
+            pitem->generate = help_text_ruleset;
             help_nodes->append(pitem);
           } break;
           case HELP_TILESET: {
@@ -977,7 +1025,6 @@ void boot_help_texts(const nation_set *nations_to_show,
                 fc_snprintf(name, sizeof(name), "%*s%s", level, "",
                             nation_plural_translation(&pnation));
                 pitem->topic = qstrdup(name);
-                pitem->text = qstrdup(empty);
                 category_nodes.append(pitem);
               }
             } // iterate over nations - pnation
@@ -985,20 +1032,13 @@ void boot_help_texts(const nation_set *nations_to_show,
           case HELP_MULTIPLIER:
             multipliers_iterate(pmul)
             {
-              help_text_buffer[0] = '\0';
               pitem = new_help_item(current_type);
               fc_snprintf(name, sizeof(name), "%*s%s", level, "",
                           name_translation_get(&pmul->name));
               pitem->topic = qstrdup(name);
-              if (pmul->helptext) {
-                const char *sep = "";
-                for (const auto &text : qAsConst(*pmul->helptext)) {
-                  cat_snprintf(help_text_buffer, sizeof(help_text_buffer),
-                               "%s%s", sep, qUtf8Printable(text));
-                  sep = "\n\n";
-                }
-              }
-              pitem->text = qstrdup(help_text_buffer);
+              pitem->generate = [pmul] {
+                return help_text_multiplier(pmul);
+              };
               help_nodes->append(pitem);
             }
             multipliers_iterate_end;
@@ -1012,27 +1052,9 @@ void boot_help_texts(const nation_set *nations_to_show,
                             effect_type_name(static_cast<effect_type>(i)));
                 pitem->topic = qstrdup(name);
 
-                QString all_text = _("The following rules contribute to the "
-                                     "value of this effect:\n");
-                effect_list_iterate(effects, peffect)
-                {
-                  if (requirement_vector_size(&peffect->reqs) == 0) {
-                    all_text += QString(_("* %1 by default\n"))
-                                    .arg(effect_type_unit_text(
-                                        peffect->type, peffect->value));
-                  } else {
-                    help_text_buffer[0] = '\0';
-                    get_effect_req_text(peffect, help_text_buffer,
-                                        sizeof(help_text_buffer));
-                    all_text += QString(_("* %1 with %2\n"))
-                                    .arg(effect_type_unit_text(
-                                        peffect->type, peffect->value))
-                                    .arg(help_text_buffer);
-                  }
-                }
-                effect_list_iterate_end;
-
-                pitem->text = qstrdup(qUtf8Printable(all_text));
+                pitem->generate = [i] {
+                  return help_text_effect(static_cast<effect_type>(i));
+                };
                 help_nodes->append(pitem);
               }
             }
@@ -1060,25 +1082,16 @@ void boot_help_texts(const nation_set *nations_to_show,
 
       paras = secfile_lookup_str_vec(sf, &npara, "%s.text", sec_name);
 
-      long_buffer[0] = '\0';
-      for (int i = 0; i < npara; i++) {
-        bool inserted;
-        const char *para = paras[i];
+      {
+        QStringList text;
 
-        if (strncmp(para, "$", 1) == 0) {
-          inserted = insert_generated_text(long_buffer, sizeof(long_buffer),
-                                           para + 1);
-        } else {
-          sz_strlcat(long_buffer, _(para));
-          inserted = true;
-        }
-        if (inserted && i != npara - 1) {
-          sz_strlcat(long_buffer, "\n\n");
+        for (int i = 0; i < npara; i++) {
+          text.append(QString::fromUtf8(paras[i]));
         }
+        pitem->generate = [text] { return help_text_from_paras(text); };
       }
       delete[] paras;
       paras = nullptr;
-      pitem->text = qstrdup(long_buffer);
       help_nodes->append(pitem);
     }
     section_list_iterate_end;
@@ -1089,7 +1102,7 @@ void boot_help_texts(const nation_set *nations_to_show,
   secfile_check_unused(sf);
   secfile_destroy(sf);
   booted = true;
-  qDebug("Booted help texts ok");
+  qDebug("Booted help texts ok (%lld ms)", timer.elapsed());
 }
 
 /**
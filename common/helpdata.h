@@ -12,6 +12,10 @@
       \____/        ********************************************************/
 #pragma once
 
+#include <QString>
+
+#include <functional>
+
 #include "fc_types.h"
 
 struct nation_set;
@@ -68,8 +72,13 @@ enum help_page_type {
 #define HELP_MULTIPLIER_ITEM N_("Policies")
 
 struct help_item {
-  char *topic, *text;
+  char *topic;
+  /* Use help_item_text(): for most generated topics this stays nullptr
+   * until the text is first needed. */
+  mutable char *text;
   enum help_page_type type;
+  // Builds the text the first time it is asked for; may be empty.
+  mutable std::function<QString()> generate;
 };
 
 void boot_help_texts(const nation_set *nations_to_show,
@@ -77,6 +86,7 @@ void boot_help_texts(const nation_set *nations_to_show,
 void free_help_texts();
 
 struct help_item *new_help_item(help_page_type type);
+const char *help_item_text(const struct help_item *pitem);
 const struct help_item *
 get_help_item_spec(const char *name, enum help_page_type htype, int *pos);
 
@@ -9,7 +9,13 @@ received a copy of the GNU General Public License along with Freeciv21.
                               If not, see https://www.gnu.org/licenses/.
  */
 
+#include <algorithm>
 #include <cstdarg>
+#include <list>
+
+// Qt
+#include <QRunnable>
+#include <QThreadPool>
 
 #ifdef HAVE_MAPIMG_MAGICKWAND
 #include <wand/MagickWand.h>
@@ -336,11 +342,37 @@ struct img {
     int y;
   } imgsize; // image size
   const struct rgbcolor **map;
+
+  /* Offset of each pixel of the tile shape within 'map', and the size of
+   * the box around the shape. */
+  int pixel_offset[NUM_PIXEL];
+  struct {
+    int x;
+    int y;
+  } shapesize;
+
+  /* The game data used to draw and save the image, copied by
+   * img_capture() so that this can be done away from the main thread. */
+  struct player *pplayer; // the only displayed player, if any
+  bool borders;
+  bool fogofwar;
+  int player_count;
+  struct rgbcolor plrcolor[MAX_NUM_PLAYER_SLOTS];
+  struct {
+    bool alive;
+    bool allied;        // with 'pplayer'
+    bool shared_vision; // given to 'pplayer'
+  } plrinfo[MAX_NUM_PLAYER_SLOTS];
+  QStringList plrstr; // img_playerstr() of the displayed players
 };
 
 static struct img *img_new(struct mapdef *mapdef, int topo, int xsize,
                            int ysize);
 static void img_destroy(struct img *pimg);
+static void img_capture(struct img *pimg);
+static void img_alloc_map(struct img *pimg);
+static const struct rgbcolor *img_color_player(const struct img *pimg,
+                                               int plr_id);
 static inline void img_set_pixel(struct img *pimg, const int mindex,
                                  const struct rgbcolor *pcolor);
 static inline int img_index(const int x, const int y,
@@ -361,6 +393,29 @@ static bool img_save_magickwand(const struct img *pimg,
 static bool img_filename(const char *mapimgfile, enum imageformat format,
                          char *filename, size_t filename_len);
 static void img_createmap(struct img *pimg);
+static void img_createmap_rows(struct img *pimg, int first, int last);
+
+// == map image batches ==
+struct mapimg_batch_image {
+  struct mapdef def; // a copy; the definition may change while drawing
+  char mapimgfile[MAX_LEN_PATH];
+  struct img *pimg;
+};
+
+struct mapimg_batch {
+  std::list<mapimg_batch_image> images;
+  QByteArray path;
+  bool with_path;
+};
+
+static void mapimg_batch_push(struct mapimg_batch *batch,
+                              struct mapdef *pmapdef, const char *savename);
+
+// Worker threads for img_createmap()
+Q_GLOBAL_STATIC(QThreadPool, mapimg_pool)
+
+// Below this number of map rows, a band of rows is not worth a thread.
+#define MAPIMG_MIN_ROWS 16
 
 // == image toolkits ==
 typedef bool (*img_save_func)(const struct img *pimg,
@@ -413,7 +468,8 @@ static const struct toolkit *img_toolkit_get(enum imagetool tool);
 // == logging ==
 #define MAX_LEN_ERRORBUF 1024
 
-static char error_buffer[MAX_LEN_ERRORBUF] = "\0";
+// One per thread, as images may be drawn on a background thread.
+static thread_local char error_buffer[MAX_LEN_ERRORBUF] = "\0";
 static void mapimg_log(const char *file, const char *function, int line,
                        const char *format, ...)
     fc__attribute((__format__(__printf__, 4, 5)));
@@ -1274,13 +1330,55 @@ bool mapimg_id2str(int id, char *str, size_t str_len)
 bool mapimg_create(struct mapdef *pmapdef, bool force, const char *savename,
                    const char *path)
 {
-  struct img *pimg;
-  char mapimgfile[MAX_LEN_PATH];
-  bool ret = true;
-#ifdef FREECIV_DEBUG
-  civtimer *timer_cpu, *timer_user;
-#endif
+  struct mapimg_batch *batch = mapimg_batch_new(path);
+  bool ret = mapimg_batch_add(batch, pmapdef, force, savename)
+             && mapimg_batch_draw(batch);
+
+  mapimg_batch_destroy(batch);
 
+  return ret;
+}
+
+/**
+   Create an empty batch of map images, to be saved in 'path'.
+ */
+struct mapimg_batch *mapimg_batch_new(const char *path)
+{
+  auto *batch = new mapimg_batch;
+
+  batch->with_path = (path != nullptr);
+  if (path != nullptr) {
+    batch->path = path;
+  }
+
+  return batch;
+}
+
+/**
+   Destroy a batch of map images.
+ */
+void mapimg_batch_destroy(struct mapimg_batch *batch)
+{
+  if (batch == nullptr) {
+    return;
+  }
+
+  for (auto &image : batch->images) {
+    img_destroy(image.pimg);
+  }
+  delete batch;
+}
+
+/**
+   Add the images of the map definition to the batch, see mapimg_create().
+   This takes from the game everything needed to draw and save them, except
+   for the tile data which is read through the mapimg_tile_*() callbacks.
+   These must stay usable until mapimg_batch_draw() returns, as must the
+   map, the rulesets and the players.
+ */
+bool mapimg_batch_add(struct mapimg_batch *batch, struct mapdef *pmapdef,
+                      bool force, const char *savename)
+{
   if (map_is_empty()) {
     MAPIMG_LOG(_("map not yet created"));
 
@@ -1304,13 +1402,6 @@ bool mapimg_create(struct mapdef *pmapdef, bool force, const char *savename,
     return true;
   }
 
-#ifdef FREECIV_DEBUG
-  timer_cpu = timer_new(TIMER_CPU, TIMER_ACTIVE);
-  timer_start(timer_cpu);
-  timer_user = timer_new(TIMER_USER, TIMER_ACTIVE);
-  timer_start(timer_user);
-#endif // FREECIV_DEBUG
-
   // create map
   switch (pmapdef->player.show) {
   case SHOW_PLRNAME: // display player given by name
@@ -1318,15 +1409,7 @@ bool mapimg_create(struct mapdef *pmapdef, bool force, const char *savename,
   case SHOW_NONE:    // no player one the map
   case SHOW_ALL:     // show all players in one map
   case SHOW_PLRBV:   // display player(s) given by bitvector
-    generate_save_name(savename, mapimgfile, sizeof(mapimgfile),
-                       mapimg_generate_name(pmapdef));
-
-    pimg = img_new(pmapdef, CURRENT_TOPOLOGY, wld.map.xsize, wld.map.ysize);
-    img_createmap(pimg);
-    if (!img_save(pimg, mapimgfile, path)) {
-      ret = false;
-    }
-    img_destroy(pimg);
+    mapimg_batch_push(batch, pmapdef, savename);
     break;
   case SHOW_EACH:  // one map for each player
   case SHOW_HUMAN: // one map for each human player
@@ -1342,25 +1425,53 @@ bool mapimg_create(struct mapdef *pmapdef, bool force, const char *savename,
       BV_CLR_ALL(pmapdef->player.checked_plrbv);
       BV_SET(pmapdef->player.checked_plrbv, player_index(pplayer));
 
-      generate_save_name(savename, mapimgfile, sizeof(mapimgfile),
-                         mapimg_generate_name(pmapdef));
-
-      pimg =
-          img_new(pmapdef, CURRENT_TOPOLOGY, wld.map.xsize, wld.map.ysize);
-      img_createmap(pimg);
-      if (!img_save(pimg, mapimgfile, path)) {
-        ret = false;
-      }
-      img_destroy(pimg);
-
-      if (!ret) {
-        break;
-      }
+      mapimg_batch_push(batch, pmapdef, savename);
     }
     players_iterate_end;
     break;
   }
 
+  return true;
+}
+
+/**
+   Return the number of images in the batch.
+ */
+int mapimg_batch_size(const struct mapimg_batch *batch)
+{
+  return batch->images.size();
+}
+
+/**
+   Draw and save the images of the batch. Unlike the other functions, this
+   may be called away from the main thread, but only on one thread at a
+   time. Returns FALSE if one of the images could not be saved; the error
+   is then available with mapimg_error() on the same thread.
+ */
+bool mapimg_batch_draw(struct mapimg_batch *batch)
+{
+  const char *path = batch->with_path ? batch->path.constData() : nullptr;
+  bool ret = true;
+#ifdef FREECIV_DEBUG
+  civtimer *timer_cpu, *timer_user;
+
+  timer_cpu = timer_new(TIMER_CPU, TIMER_ACTIVE);
+  timer_start(timer_cpu);
+  timer_user = timer_new(TIMER_USER, TIMER_ACTIVE);
+  timer_start(timer_user);
+#endif // FREECIV_DEBUG
+
+  for (auto &image : batch->images) {
+    img_createmap(image.pimg);
+    if (!img_save(image.pimg, image.mapimgfile, path)) {
+      ret = false;
+    }
+
+    // Done with the image; give the memory back early.
+    img_destroy(image.pimg);
+    image.pimg = nullptr;
+  }
+
 #ifdef FREECIV_DEBUG
   log_debug("Image generation time: %g seconds (%g apparent)",
             timer_read_seconds(timer_cpu), timer_read_seconds(timer_user));
@@ -1396,6 +1507,7 @@ bool mapimg_colortest(const char *savename, const char *path)
 
   pimg = img_new(pmapdef, 0, SIZE_X + 2,
                  SIZE_Y * (max_playercolor / SIZE_X) + 2);
+  img_alloc_map(pimg);
 
   pixel = pimg->pixel_tile(nullptr, nullptr, false);
 
@@ -1734,6 +1846,24 @@ static char *mapimg_generate_name(struct mapdef *pmapdef)
   return mapstr;
 }
 
+/**
+   Add one image of the map definition, as currently set up, to the batch.
+ */
+static void mapimg_batch_push(struct mapimg_batch *batch,
+                              struct mapdef *pmapdef, const char *savename)
+{
+  batch->images.emplace_back();
+
+  auto &image = batch->images.back();
+
+  image.def = *pmapdef;
+  generate_save_name(savename, image.mapimgfile, sizeof(image.mapimgfile),
+                     mapimg_generate_name(pmapdef));
+  image.pimg =
+      img_new(&image.def, CURRENT_TOPOLOGY, wld.map.xsize, wld.map.ysize);
+  img_capture(image.pimg);
+}
+
 /*
  * ==============================================
  * map definitions (internal functions)
@@ -1812,7 +1942,7 @@ static const struct toolkit *img_toolkit_get(enum imagetool tool)
 static struct img *img_new(struct mapdef *mapdef, int topo, int xsize,
                            int ysize)
 {
-  auto *pimg = new img;
+  auto *pimg = new img();
 
   pimg->def = mapdef;
   pimg->turn = game.info.turn;
@@ -1889,10 +2019,19 @@ static struct img *img_new(struct mapdef *mapdef, int topo, int xsize,
     pimg->base_coor = base_coor_rect;
   }
 
-  // Here the map image is saved as an array of RGB color values.
-  pimg->map = new const rgbcolor *[pimg->imgsize.x * pimg->imgsize.y]();
-  // Initialise map.
-  memset(pimg->map, 0, pimg->imgsize.x * pimg->imgsize.y);
+  for (int i = 0; i < NUM_PIXEL; i++) {
+    pimg->pixel_offset[i] =
+        pimg->tileshape->y[i] * pimg->imgsize.x + pimg->tileshape->x[i];
+    pimg->shapesize.x = MAX(pimg->shapesize.x, pimg->tileshape->x[i] + 1);
+    pimg->shapesize.y = MAX(pimg->shapesize.y, pimg->tileshape->y[i] + 1);
+  }
+
+  for (auto &color : pimg->plrcolor) {
+    color = *imgcolor_special(IMGCOLOR_ERROR);
+  }
+
+  // The map itself is allocated by img_alloc_map().
+  pimg->map = nullptr;
 
   return pimg;
 }
@@ -1910,6 +2049,71 @@ static void img_destroy(struct img *pimg)
   }
 }
 
+/**
+   Allocate the map of the image, where it is saved as an array of RGB
+   color values.
+ */
+static void img_alloc_map(struct img *pimg)
+{
+  fc_assert_ret(pimg->map == nullptr);
+
+  pimg->map = new const rgbcolor *[pimg->imgsize.x * pimg->imgsize.y]();
+}
+
+/**
+   Copy the player data needed to draw and save the image.
+ */
+static void img_capture(struct img *pimg)
+{
+  const struct mapdef *pmapdef = pimg->def;
+  bool only_one = (bvplayers_count(pmapdef) == 1);
+
+  pimg->borders = (game.info.borders > 0);
+  pimg->fogofwar = game.info.fogofwar;
+  pimg->player_count = player_count();
+
+  players_iterate(pplayer)
+  {
+    int i = player_index(pplayer);
+
+    pimg->plrcolor[i] = *imgcolor_player(i);
+    pimg->plrinfo[i].alive = pplayer->is_alive;
+
+    if (BV_ISSET(pmapdef->player.checked_plrbv, i)) {
+      if (only_one && pimg->pplayer == nullptr) {
+        // only one player; used for 'known' and 'fogofwar'
+        pimg->pplayer = pplayer;
+      }
+      pimg->plrstr.append(QString::fromUtf8(img_playerstr(pplayer)));
+    }
+  }
+  players_iterate_end;
+
+  if (pimg->pplayer != nullptr) {
+    players_iterate(pplayer)
+    {
+      int i = player_index(pplayer);
+
+      pimg->plrinfo[i].allied = pplayers_allied(pplayer, pimg->pplayer);
+      pimg->plrinfo[i].shared_vision =
+          gives_shared_vision(pplayer, pimg->pplayer);
+    }
+    players_iterate_end;
+  }
+}
+
+/**
+   Return the color of the player, as copied by img_capture().
+ */
+static const struct rgbcolor *img_color_player(const struct img *pimg,
+                                               int plr_id)
+{
+  fc_assert_ret_val(plr_id >= 0 && plr_id < MAX_NUM_PLAYER_SLOTS,
+                    imgcolor_special(IMGCOLOR_ERROR));
+
+  return &pimg->plrcolor[plr_id];
+}
+
 /**
    Set the color of one pixel.
  */
@@ -1951,12 +2155,38 @@ static void img_plot(struct img *pimg, int x, int y,
 
   pimg->base_coor(pimg, &base_x, &base_y, x, y);
 
-  for (i = 0; i < NUM_PIXEL; i++) {
-    if (BV_ISSET(pixel, i)) {
-      mindex = img_index(base_x + pimg->tileshape->x[i],
-                         base_y + pimg->tileshape->y[i], pimg);
-      img_set_pixel(pimg, mindex, pcolor);
+  if (base_x < 0 || base_y < 0
+      || base_x + pimg->shapesize.x > pimg->imgsize.x
+      || base_y + pimg->shapesize.y > pimg->imgsize.y) {
+    // Part of the tile is outside of the image.
+    for (i = 0; i < NUM_PIXEL; i++) {
+      if (BV_ISSET(pixel, i)) {
+        mindex = img_index(base_x + pimg->tileshape->x[i],
+                           base_y + pimg->tileshape->y[i], pimg);
+        img_set_pixel(pimg, mindex, pcolor);
+      }
     }
+    return;
+  }
+
+  /* The pixels of a tile shape are listed row by row, without holes in a
+   * row: fill each run of set pixels within a row at once. */
+  const struct rgbcolor **base = pimg->map + img_index(base_x, base_y, pimg);
+
+  for (i = 0; i < NUM_PIXEL;) {
+    int last = i + 1;
+
+    if (!BV_ISSET(pixel, i)) {
+      i = last;
+      continue;
+    }
+    while (last < NUM_PIXEL && BV_ISSET(pixel, last)
+           && pimg->tileshape->y[last] == pimg->tileshape->y[i]) {
+      last++;
+    }
+    std::fill(base + pimg->pixel_offset[i],
+              base + pimg->pixel_offset[last - 1] + 1, pcolor);
+    i = last;
   }
 }
 
@@ -2038,7 +2268,7 @@ static bool img_save_magickwand(const struct img *pimg,
                                 const char *mapimgfile)
 {
   const struct rgbcolor *pcolor = nullptr;
-  struct player *pplr_now = nullptr, *pplr_only = nullptr;
+  const struct player *pplr_only = pimg->pplayer;
   bool ret = true;
   char imagefile[MAX_LEN_PATH];
   char str_color[32], comment[2048] = "", title[258];
@@ -2078,22 +2308,12 @@ static bool img_save_magickwand(const struct img *pimg,
 
   textoffset = 0;
   if (withplr) {
-    if (bvplayers_count(pimg->def) == 1) {
-      // only one player
-      for (i = 0; i < player_slot_count(); i++) {
-        if (BV_ISSET(pimg->def->player.checked_plrbv, i)) {
-          pplr_only = player_by_number(i);
-          break;
-        }
-      }
-    }
-
     if (pplr_only) {
       magickwand_size_t plr_color_square = IMG_TEXT_HEIGHT;
 
       textoffset += IMG_TEXT_HEIGHT + IMG_BORDER_HEIGHT;
 
-      pcolor = imgcolor_player(player_index(pplr_only));
+      pcolor = img_color_player(pimg, player_index(pplr_only));
       SET_COLOR(str_color, pcolor);
 
       // Show the color of the selected player.
@@ -2112,8 +2332,9 @@ static bool img_save_magickwand(const struct img *pimg,
     }
 
     // Show a line displaying the colors of alive players
-    plrwidth = map_width / MIN(map_width, player_count());
-    plroffset = (map_width - MIN(map_width, plrwidth * player_count())) / 2;
+    plrwidth = map_width / MIN(map_width, pimg->player_count);
+    plroffset =
+        (map_width - MIN(map_width, plrwidth * pimg->player_count)) / 2;
 
     imw = NewPixelRegionIterator(mw, IMG_BORDER_WIDTH,
                                  IMG_BORDER_HEIGHT + IMG_TEXT_HEIGHT
@@ -2126,16 +2347,15 @@ static bool img_save_magickwand(const struct img *pimg,
       // x coordinate
       for (x = plroffset; x < map_width; x++) {
         i = (x - plroffset) / plrwidth;
-        pplr_now = player_by_number(i);
 
-        if (i > player_count() || pplr_now == nullptr
-            || !pplr_now->is_alive) {
+        if (i > pimg->player_count || i >= MAX_NUM_PLAYER_SLOTS
+            || !pimg->plrinfo[i].alive) {
           continue;
         }
 
         if (BV_ISSET(pimg->def->player.checked_plrbv, i)) {
           // The selected player is alive - display it.
-          pcolor = imgcolor_player(i);
+          pcolor = img_color_player(pimg, i);
           SET_COLOR(str_color, pcolor);
           PixelSetColor(pmw[x], str_color);
         } else if (pplr_only != nullptr) {
@@ -2151,9 +2371,9 @@ static bool img_save_magickwand(const struct img *pimg,
            *                # # #       # # #
            *   shared      allied      shared vision
            *   vision                   + allied */
-          if ((pplayers_allied(pplr_now, pplr_only) && (x + y) % 2 == 0)
-              || (y % 2 == 0 && gives_shared_vision(pplr_now, pplr_only))) {
-            pcolor = imgcolor_player(i);
+          if ((pimg->plrinfo[i].allied && (x + y) % 2 == 0)
+              || (y % 2 == 0 && pimg->plrinfo[i].shared_vision)) {
+            pcolor = img_color_player(pimg, i);
             SET_COLOR(str_color, pcolor);
             PixelSetColor(pmw[x], str_color);
           }
@@ -2209,18 +2429,8 @@ static bool img_save_magickwand(const struct img *pimg,
 
   cat_snprintf(comment, sizeof(comment), "map definition: %s\n",
                pimg->def->maparg);
-  if (BV_ISSET_ANY(pimg->def->player.checked_plrbv)) {
-    players_iterate(pplayer)
-    {
-      if (!BV_ISSET(pimg->def->player.checked_plrbv,
-                    player_index(pplayer))) {
-        continue;
-      }
-
-      pcolor = imgcolor_player(player_index(pplayer));
-      cat_snprintf(comment, sizeof(comment), "%s\n", img_playerstr(pplayer));
-    }
-    players_iterate_end;
+  for (const auto &plrstr : pimg->plrstr) {
+    cat_snprintf(comment, sizeof(comment), "%s\n", qUtf8Printable(plrstr));
   }
   MagickCommentImage(mw, comment);
 
@@ -2276,16 +2486,9 @@ static bool img_save_ppm(const struct img *pimg, const char *mapimgfile)
   if (pimg->def->colortest) {
     fprintf(fp, "# color test\n");
   } else if (BV_ISSET_ANY(pimg->def->player.checked_plrbv)) {
-    players_iterate(pplayer)
-    {
-      if (!BV_ISSET(pimg->def->player.checked_plrbv,
-                    player_index(pplayer))) {
-        continue;
-      }
-
-      fprintf(fp, "# %s\n", img_playerstr(pplayer));
+    for (const auto &plrstr : pimg->plrstr) {
+      fprintf(fp, "# %s\n", qUtf8Printable(plrstr));
     }
-    players_iterate_end;
   } else {
     fprintf(fp, "# no players\n");
   }
@@ -2353,34 +2556,58 @@ static const char *img_playerstr(const struct player *pplayer)
 /**
    Create the map considering the options (terrain, player(s), cities,
    units, borders, known, fogofwar, ...).
+
+   The rows of the map are split into bands that are drawn on worker
+   threads. Each pixel belongs to a single tile, so the bands write to
+   different parts of the image and the result does not depend on the
+   number of threads.
  */
 static void img_createmap(struct img *pimg)
+{
+  const int rows = wld.map.ysize;
+  const int bands = std::min(mapimg_pool->maxThreadCount() * 4,
+                             std::max(1, rows / MAPIMG_MIN_ROWS));
+
+  if (pimg->map == nullptr) {
+    img_alloc_map(pimg);
+  }
+
+  for (int b = 1; b < bands; b++) {
+    const int first = rows * b / bands;
+    const int last = rows * (b + 1) / bands;
+
+    mapimg_pool->start(QRunnable::create(
+        [pimg, first, last] { img_createmap_rows(pimg, first, last); }));
+  }
+  // The calling thread does its share too.
+  img_createmap_rows(pimg, 0, rows / bands);
+  mapimg_pool->waitForDone();
+}
+
+/**
+   Draw the tiles of the native rows [first, last) of the map, see
+   img_createmap().
+ */
+static void img_createmap_rows(struct img *pimg, int first, int last)
 {
   const struct rgbcolor *pcolor;
   bv_pixel pixel;
   int player_id;
-  struct player *pplayer = nullptr;
+  struct player *pplayer = pimg->pplayer;
   struct player *plr_tile = nullptr, *plr_city = nullptr,
                 *plr_unit = nullptr;
   enum known_type tile_knowledge = TILE_UNKNOWN;
   struct terrain *pterrain = nullptr;
   bool plr_knowledge = pimg->def->layers[MAPIMG_LAYER_KNOWLEDGE];
 
-  whole_map_iterate(&(wld.map), ptile)
-  {
-    if (bvplayers_count(pimg->def) == 1) {
-      // only one player; get player id for 'known' and 'fogofwar'
-      players_iterate(aplayer)
-      {
-        if (BV_ISSET(pimg->def->player.checked_plrbv,
-                     player_index(aplayer))) {
-          pplayer = aplayer;
-          tile_knowledge =
-              mapimg.mapimg_tile_known(ptile, pplayer, plr_knowledge);
-          break;
-        }
-      }
-      players_iterate_end;
+  for (int index = first * wld.map.xsize; index < last * wld.map.xsize;
+       index++) {
+    const struct tile *ptile = wld.map.tiles + index;
+
+    if (pplayer != nullptr) {
+      // only one player; get tile knowledge for 'known' and 'fogofwar'
+      tile_knowledge =
+          mapimg.mapimg_tile_known(ptile, pplayer, plr_knowledge);
     }
 
     // known tiles
@@ -2409,13 +2636,13 @@ static void img_createmap(struct img *pimg)
 
     // (land) area within borders and borders
     plr_tile = mapimg.mapimg_tile_owner(ptile, pplayer, plr_knowledge);
-    if (game.info.borders > 0 && nullptr != plr_tile) {
+    if (pimg->borders && nullptr != plr_tile) {
       player_id = player_index(plr_tile);
       if (pimg->def->layers[MAPIMG_LAYER_AREA] && !is_ocean(pterrain)
           && BV_ISSET(pimg->def->player.checked_plrbv, player_id)) {
         // the tile is land and inside the players borders
         pixel = pimg->pixel_tile(ptile, pplayer, plr_knowledge);
-        pcolor = imgcolor_player(player_id);
+        pcolor = img_color_player(pimg, player_id);
         img_plot_tile(pimg, ptile, pcolor, pixel);
       } else if (pimg->def->layers[MAPIMG_LAYER_BORDERS]
                  && (BV_ISSET(pimg->def->player.checked_plrbv, player_id)
@@ -2423,7 +2650,7 @@ static void img_createmap(struct img *pimg)
         /* plot borders if player is selected or view range of the one
          * displayed player */
         pixel = pimg->pixel_border(ptile, pplayer, plr_knowledge);
-        pcolor = imgcolor_player(player_id);
+        pcolor = img_color_player(pimg, player_id);
         img_plot_tile(pimg, ptile, pcolor, pixel);
       }
     }
@@ -2438,7 +2665,7 @@ static void img_createmap(struct img *pimg)
         /* plot cities if player is selected or view range of the one
          * displayed player */
         pixel = pimg->pixel_city(ptile, pplayer, plr_knowledge);
-        pcolor = imgcolor_player(player_id);
+        pcolor = img_color_player(pimg, player_id);
         img_plot_tile(pimg, ptile, pcolor, pixel);
       }
     } else if (pimg->def->layers[MAPIMG_LAYER_UNITS] && plr_unit) {
@@ -2448,20 +2675,19 @@ static void img_createmap(struct img *pimg)
         /* plot units if player is selected or view range of the one
          * displayed player */
         pixel = pimg->pixel_unit(ptile, pplayer, plr_knowledge);
-        pcolor = imgcolor_player(player_id);
+        pcolor = img_color_player(pimg, player_id);
         img_plot_tile(pimg, ptile, pcolor, pixel);
       }
     }
 
     // fogofwar; if only 1 player is plotted
-    if (game.info.fogofwar && pimg->def->layers[MAPIMG_LAYER_FOGOFWAR]
+    if (pimg->fogofwar && pimg->def->layers[MAPIMG_LAYER_FOGOFWAR]
         && pplayer != nullptr && tile_knowledge == TILE_KNOWN_UNSEEN) {
       pixel = pimg->pixel_fogofwar(ptile, pplayer, plr_knowledge);
       pcolor = nullptr;
       img_plot_tile(pimg, ptile, pcolor, pixel);
     }
   }
-  whole_map_iterate_end;
 }
 
 /*
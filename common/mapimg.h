@@ -31,6 +31,14 @@ received a copy of the GNU General Public License along with Freeciv21.
     mapimg_create()     ...
     mapimg_colortest()  ...
 
+  * Batches:
+
+    mapimg_batch_new()      Create an empty batch of map images.
+    mapimg_batch_add()      Add the images of a map image definition.
+    mapimg_batch_draw()     Draw and save the images. This may be done on
+                            another thread.
+    mapimg_batch_destroy()  Free the batch.
+
     These functions return TRUE on success and FALSE on error. In the later
     case the error message is available with mapimg_error().
 
@@ -108,6 +116,16 @@ bool mapimg_create(struct mapdef *pmapdef, bool force, const char *savename,
                    const char *path);
 bool mapimg_colortest(const char *savename, const char *path);
 
+// map images waiting to be drawn
+struct mapimg_batch;
+
+struct mapimg_batch *mapimg_batch_new(const char *path);
+void mapimg_batch_destroy(struct mapimg_batch *batch);
+bool mapimg_batch_add(struct mapimg_batch *batch, struct mapdef *pmapdef,
+                      bool force, const char *savename);
+int mapimg_batch_size(const struct mapimg_batch *batch);
+bool mapimg_batch_draw(struct mapimg_batch *batch);
+
 struct mapdef *mapimg_isvalid(int id);
 
 const QVector<QString> *mapimg_get_format_list();
@@ -567,8 +567,10 @@ void connection_common_close(struct connection *pconn)
   if (!pconn->used) {
     qCritical("WARNING: Trying to close already closed connection");
   } else {
-    pconn->sock->deleteLater();
-    pconn->sock = nullptr;
+    if (pconn->sock != nullptr) {
+      pconn->sock->deleteLater();
+      pconn->sock = nullptr;
+    }
     pconn->used = false;
     pconn->established = false;
 
@@ -216,6 +216,10 @@ struct connection {
        * but the closing has been postponed. */
       bool is_closing;
 
+      /* The client was offered to use its ruleset cache and didn't answer
+       * yet. See establish_new_connection(). */
+      bool ruleset_cache_offered;
+
       /* If we use delegation the original player (playing) is replaced. Save
        * it here to easily restore it. */
       struct {
@@ -241,6 +245,13 @@ struct connection {
    */
   void (*outgoing_packet_notify)(struct connection *pc, int packet_type,
                                  int size, int request_id);
+
+  /*
+   * When not nullptr, the packets sent to this connection are appended
+   * there instead of being sent.
+   */
+  QByteArray *packet_capture = nullptr;
+
   struct {
     struct genhash **sent;
     struct genhash **received;
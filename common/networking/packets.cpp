@@ -194,6 +194,11 @@ int send_packet_data(struct connection *pc, unsigned char *data, int len,
     pc->outgoing_packet_notify(pc, packet_type, len, result);
   }
 
+  if (pc->packet_capture != nullptr) {
+    pc->packet_capture->append(reinterpret_cast<const char *>(data), len);
+    return result;
+  }
+
   int size = len;
   if (conn_compression_frozen(pc)) {
     size_t old_size;
@@ -579,7 +584,7 @@ void packet_header_init(struct packet_header *packet_header)
    Set the packet header field lengths used after the login protocol,
    after the capability of the connection could be checked.
  */
-static inline void packet_header_set(struct packet_header *packet_header)
+void packet_header_set(struct packet_header *packet_header)
 {
   // Ensure we have values initialized in packet_header_init().
   fc_assert(packet_header->length == DIOT_UINT16);
@@ -104,6 +104,7 @@ const char *packet_name(enum packet_type type);
 bool packet_has_game_info_flag(enum packet_type type);
 
 void packet_header_init(struct packet_header *packet_header);
+void packet_header_set(struct packet_header *packet_header);
 void post_send_packet_server_join_reply(
     struct connection *pconn, const struct packet_server_join_reply *packet);
 void post_receive_packet_server_join_reply(
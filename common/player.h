@@ -360,8 +360,8 @@ struct player {
     struct {
       /* Only used at the client (the server is omniscient; ./client/). */
 
-      /* Corresponds to the result of
-         (player:server:private_map[tile_index]:seen_count[vlayer] != 0). */
+      /* Corresponds to (seen_count[vlayer] != 0) for the tile in the
+         server's per-player vision_maps, see server/maphand.cpp. */
       QBitArray *tile_vision[V_COUNT];
       enum mood_type mood;
 
@@ -8,6 +8,8 @@ _   ._       Copyright (c) 1996-2021 Freeciv21 and Freeciv contributors.
   :X:      received a copy of the GNU General Public License along with
   :X:              Freeciv21. If not, see https://www.gnu.org/licenses/.
  */
+#include <QtAlgorithms>
+
 // utility
 #include "fcintl.h"
 #include "iterator.h"
@@ -16,6 +18,7 @@ _   ._       Copyright (c) 1996-2021 Freeciv21 and Freeciv contributors.
 #include "support.h"
 
 // common
+#include "city.h"
 #include "fc_types.h"
 #include "game.h"
 #include "name_translation.h"
@@ -368,46 +371,73 @@ static bool research_allowed(
   return false;
 }
 
+/**
+   Sets 'dest' to the techs of 'techs' which are not in 'known' and returns
+   how many there are.
+
+   Helper for research_update().
+ */
+static int research_unknown_techs(bv_techs *dest, const bv_techs *techs,
+                                  const bv_techs *known)
+{
+  int count = 0;
+
+  for (size_t i = 0; i < sizeof(dest->vec); i++) {
+    dest->vec[i] = techs->vec[i] & ~known->vec[i];
+    count += qPopulationCount(dest->vec[i]);
+  }
+
+  return count;
+}
+
 /**
    Returns TRUE iff the given tech is ever reachable by the players sharing
-   the research as far as research_reqs are concerned.
+   the research as far as research_reqs are concerned. 'blocked' holds the
+   unknown techs which can never be researched, either because of their
+   research_reqs or because one of their requirements is invalid.
 
-   Helper for research_get_reachable().
+   Helper for research_update().
  */
-static bool research_get_reachable_rreqs(const struct research *presearch,
+static bool research_get_reachable_rreqs(const bv_techs *known,
+                                         const bv_techs *blocked,
                                          Tech_type_id tech)
 {
   bv_techs done;
-  std::vector<Tech_type_id> techs{tech};
+  Tech_type_id techs[A_LAST];
+  int count = 0;
+
+  if (!BV_CHECK_MASK(advance_by_number(tech)->all_reqs, *blocked)) {
+    // Nothing the search below could find.
+    return true;
+  }
+
   BV_CLR_ALL(done);
   BV_SET(done, A_NONE);
   BV_SET(done, tech);
+  techs[count++] = tech;
   /* Check that all recursive requirements have their research_reqs
    * in order. */
-  while (!techs.empty()) { // Iterate till there is no-more techs to check
-    auto iter_tech = techs[techs.size() - 1]; // Last Element
-    techs.pop_back();                         // Remove Last element
-    if (presearch->inventions[iter_tech].state == TECH_KNOWN) {
+  while (count > 0) {
+    Tech_type_id iter_tech = techs[--count];
+
+    if (BV_ISSET(*known, iter_tech)) {
       /* This tech is already reached. What is required to research it and
        * the techs it depends on is therefore irrelevant. */
       continue;
     }
 
-    if (!research_allowed(presearch, iter_tech, reqs_may_activate)) {
-      /* It will always be illegal to start researching this tech because
-       * of unchanging requirements. Since it isn't already known and can't
-       * be researched it must be unreachable. */
+    if (BV_ISSET(*blocked, iter_tech)) {
+      /* It will always be illegal to start researching this tech. Since
+       * it isn't already known and can't be researched it must be
+       * unreachable. */
       return false;
     }
 
-    // Check if required techs are research_reqs reachable.
     for (int req = 0; req < AR_SIZE; req++) {
       Tech_type_id req_tech = advance_required(iter_tech, tech_req(req));
 
-      if (valid_advance_by_number(req_tech) == nullptr) {
-        return false;
-      } else if (!BV_ISSET(done, req_tech)) {
-        techs.push_back(req_tech);
+      if (!BV_ISSET(done, req_tech)) {
+        techs[count++] = req_tech;
         BV_SET(done, req_tech);
       }
     }
@@ -417,63 +447,32 @@ static bool research_get_reachable_rreqs(const struct research *presearch,
 }
 
 /**
-   Returns TRUE iff the given tech is ever reachable by the players sharing
-   the research by checking tech tree limitations.
+   Returns the number of bulbs needed to research all the techs in
+   'required', each of them costing what 'bulbs' says. Missing costs are
+   calculated and stored into 'bulbs'.
 
    Helper for research_update().
  */
-static bool research_get_reachable(const struct research *presearch,
-                                   Tech_type_id tech)
+static int research_required_bulbs(const struct research *presearch,
+                                   const bv_techs *required, int *bulbs)
 {
-  if (valid_advance_by_number(tech) == nullptr) {
-    return false;
-  } else {
-    advance_root_req_iterate(advance_by_number(tech), proot)
-    {
-      if (advance_requires(proot, AR_ROOT) == proot) {
-        /* This tech requires itself; it can only be reached by special
-         * means (init_techs, lua script, ...).
-         * If you already know it, you can "reach" it; if not, not. (This
-         * case is needed for descendants of this tech.) */
-        if (presearch->inventions[advance_number(proot)].state
-            != TECH_KNOWN) {
-          return false;
-        }
-      } else {
-        for (int req = 0; req < AR_SIZE; req++) {
-          if (valid_advance(advance_requires(proot, tech_req(req)))
-              == nullptr) {
-            return false;
-          }
-        }
-      }
-    }
-    advance_root_req_iterate_end;
-  }
+  int total = 0;
 
-  // Check research reqs reachability.
-  return research_get_reachable_rreqs(presearch, tech);
-}
+  for (size_t i = 0; i < sizeof(required->vec); i++) {
+    unsigned int bits = required->vec[i];
 
-/**
-   Returns TRUE iff the players sharing 'presearch' already have got the
-   knowledge of all root requirement technologies for 'tech' (without which
-   it's impossible to gain 'tech').
+    while (bits != 0) {
+      Tech_type_id tech = i * 8 + qCountTrailingZeroBits(bits);
 
-   Helper for research_update().
- */
-static bool research_get_root_reqs_known(const struct research *presearch,
-                                         Tech_type_id tech)
-{
-  advance_root_req_iterate(advance_by_number(tech), proot)
-  {
-    if (presearch->inventions[advance_number(proot)].state != TECH_KNOWN) {
-      return false;
+      if (bulbs[tech] < 0) {
+        bulbs[tech] = research_total_bulbs_required(presearch, tech, false);
+      }
+      total += bulbs[tech];
+      bits &= bits - 1;
     }
   }
-  advance_root_req_iterate_end;
 
-  return true;
+  return total;
 }
 
 /**
@@ -482,34 +481,93 @@ static bool research_get_root_reqs_known(const struct research *presearch,
 
    Recalculate presearch->num_known_tech_with_flag
    Should always be called after research_invention_set().
+
+   The requirements of each tech are taken from the sets precalculated by
+   techs_precalc_reqs(), so that the tech tree is only walked when
+   research_reqs can make a tech unreachable.
  */
 void research_update(struct research *presearch)
 {
+  bv_techs known, blocked, bad_roots, unknown_roots;
+  int bulbs[A_LAST];
   int techs_researched;
 
+  // Advances change the outputs of the tiles worked by the cities.
+  city_tile_cache_invalidate_all();
+
+  BV_CLR_ALL(known);
+  advance_index_iterate(A_NONE, i)
+  {
+    if (TECH_KNOWN == presearch->inventions[i].state) {
+      BV_SET(known, i);
+    }
+  }
+  advance_index_iterate_end;
+
+  /* Find the techs which prevent the techs depending on them from being
+   * reached. */
+  BV_CLR_ALL(blocked);
+  BV_CLR_ALL(bad_roots);
+  advance_index_iterate(A_FIRST, i)
+  {
+    const struct advance *padvance = valid_advance_by_number(i);
+    bool broken = false;
+
+    bulbs[i] = -1;
+    if (nullptr == padvance) {
+      continue;
+    }
+
+    for (int req = 0; req < AR_SIZE; req++) {
+      if (nullptr
+          == valid_advance(advance_requires(padvance, tech_req(req)))) {
+        broken = true;
+      }
+    }
+
+    if (advance_requires(padvance, AR_ROOT) == padvance) {
+      /* This tech requires itself; it can only be reached by special
+       * means (init_techs, lua script, ...).
+       * If you already know it, you can "reach" it; if not, not. (This
+       * case is needed for descendants of this tech.) */
+      if (!BV_ISSET(known, i)) {
+        BV_SET(bad_roots, i);
+      }
+    } else if (broken) {
+      BV_SET(bad_roots, i);
+    }
+
+    if (!BV_ISSET(known, i)
+        && (broken
+            || !research_allowed(presearch, i, reqs_may_activate))) {
+      BV_SET(blocked, i);
+    }
+  }
+  advance_index_iterate_end;
+
   advance_index_iterate(A_FIRST, i)
   {
+    struct advance *padvance = advance_by_number(i);
     enum tech_state state = presearch->inventions[i].state;
-    bool root_reqs_known = true;
-    bool reachable = research_get_reachable(presearch, i);
+    bool reachable = (nullptr != valid_advance(padvance)
+                      && !BV_CHECK_MASK(padvance->root_reqs, bad_roots)
+                      && research_get_reachable_rreqs(&known, &blocked, i));
 
     /* Finding if the root reqs of an unreachable tech isn't redundant.
      * A tech can be unreachable via research but have known root reqs
      * because of unfilfilled research_reqs. Unfulfilled research_reqs
      * doesn't prevent the player from aquiring the tech by other means. */
-    root_reqs_known = research_get_root_reqs_known(presearch, i);
+    bool root_reqs_known = (0 == research_unknown_techs(
+                                     &unknown_roots, &padvance->root_reqs,
+                                     &known));
 
     if (reachable) {
       if (state != TECH_KNOWN) {
         // Update state.
         state =
             (root_reqs_known
-                     && (presearch->inventions[advance_required(i, AR_ONE)]
-                             .state
-                         == TECH_KNOWN)
-                     && (presearch->inventions[advance_required(i, AR_TWO)]
-                             .state
-                         == TECH_KNOWN)
+                     && BV_ISSET(known, advance_required(i, AR_ONE))
+                     && BV_ISSET(known, advance_required(i, AR_TWO))
                      && research_allowed(presearch, i, are_reqs_active)
                  ? TECH_PREREQS_KNOWN
                  : TECH_UNKNOWN);
@@ -530,17 +588,26 @@ void research_update(struct research *presearch)
       continue;
     }
 
+    presearch->inventions[i].num_required_techs = research_unknown_techs(
+        &presearch->inventions[i].required_techs, &padvance->all_reqs,
+        &known);
+
+    if (TECH_COST_CIV1CIV2 != game.info.tech_cost_style) {
+      // The cost of a tech doesn't depend on what is researched before.
+      presearch->inventions[i].bulbs_required = research_required_bulbs(
+          presearch, &presearch->inventions[i].required_techs, bulbs);
+      continue;
+    }
+
     techs_researched = presearch->techs_researched;
-    advance_req_iterate(valid_advance_by_number(i), preq)
+    advance_req_iterate(padvance, preq)
     {
       Tech_type_id j = advance_number(preq);
 
-      if (TECH_KNOWN == research_invention_state(presearch, j)) {
+      if (BV_ISSET(known, j)) {
         continue;
       }
 
-      BV_SET(presearch->inventions[i].required_techs, j);
-      presearch->inventions[i].num_required_techs++;
       presearch->inventions[i].bulbs_required +=
           research_total_bulbs_required(presearch, j, false);
       /* This is needed to get a correct result for the
@@ -584,18 +651,21 @@ void research_update(struct research *presearch)
 #endif // FREECIV_DEBUG
 
   for (int flag = 0; flag <= tech_flag_id_max(); flag++) {
-    // Iterate over all possible tech flags (0..max).
     presearch->num_known_tech_with_flag[flag] = 0;
-
-    advance_index_iterate(A_NONE, i)
-    {
-      if (TECH_KNOWN == research_invention_state(presearch, i)
-          && advance_has_flag(i, tech_flag_id(flag))) {
+  }
+  advance_index_iterate(A_NONE, i)
+  {
+    if (!BV_ISSET(known, i)) {
+      continue;
+    }
+    // Iterate over all possible tech flags (0..max).
+    for (int flag = 0; flag <= tech_flag_id_max(); flag++) {
+      if (advance_has_flag(i, tech_flag_id(flag))) {
         presearch->num_known_tech_with_flag[flag]++;
       }
     }
-    advance_index_iterate_end;
   }
+  advance_index_iterate_end;
 }
 
 /**
@@ -9,9 +9,9 @@
  */
 
 #include <cstdarg>
-#include <ctime>
 
 // Qt
+#include <QElapsedTimer>
 
 /* dependencies/lua */
 extern "C" {
@@ -37,17 +37,21 @@ extern "C" {
 #include "api_common_intl.h"
 #include "api_common_utilities.h"
 #include "luascript_func.h"
+#include "luascript_profile.h"
 #include "luascript_signal.h"
 #include "tolua_common_a_gen.h"
 
 #include "luascript.h"
 
 /**
-  Configuration for script execution time limits. Checkinterval is the
-  number of executed lua instructions between checking. Disabled if 0.
+  Configuration for script execution limits. Checkinterval is the number
+  of executed lua instructions between checking. Disabled if 0. While the
+  profiler runs, checks happen every profileinterval instructions and each
+  one takes a sample.
  */
-#define LUASCRIPT_MAX_EXECUTION_TIME_SEC 5.0
+#define LUASCRIPT_DEFAULT_MAX_MSEC 5000
 #define LUASCRIPT_CHECKINTERVAL 10000
+#define LUASCRIPT_PROFILEINTERVAL 1000
 
 // The name used for the freeciv lua struct saved in the lua state.
 #define LUASCRIPT_GLOBAL_VAR_NAME "__fcl"
@@ -106,8 +110,8 @@ static int luascript_report(struct fc_lua *fcl, int status,
 static void luascript_traceback_func_save(lua_State *L);
 static void luascript_traceback_func_push(lua_State *L);
 static void luascript_exec_check(lua_State *L, lua_Debug *ar);
-static void luascript_hook_start(lua_State *L);
-static void luascript_hook_end(lua_State *L);
+static void luascript_hook_start(struct fc_lua *fcl);
+static void luascript_hook_end(struct fc_lua *fcl);
 static void luascript_openlibs(lua_State *L, const luaL_Reg *llib);
 static void luascript_blacklist(lua_State *L, const char *lsymbols[]);
 
@@ -160,43 +164,59 @@ static void luascript_traceback_func_push(lua_State *L)
 }
 
 /**
-   Check currently excecuting lua function for execution time limit
+   Check currently excecuting lua function for execution limits, and take
+   a profile sample.
  */
 static void luascript_exec_check(lua_State *L, lua_Debug *ar)
 {
-  Q_UNUSED(ar)
-  lua_Number exec_clock;
+  struct fc_lua *fcl = luascript_get_fcl(L);
 
-  lua_getfield(L, LUA_REGISTRYINDEX, "freeciv_exec_clock");
-  exec_clock = lua_tonumber(L, -1);
-  lua_pop(L, 1);
-  if (static_cast<float>(clock() - exec_clock) / CLOCKS_PER_SEC
-      > LUASCRIPT_MAX_EXECUTION_TIME_SEC) {
+  fc_assert_ret(fcl != nullptr);
+
+  fcl->exec_instructions += fcl->exec_interval;
+  luascript_profile_sample(fcl, L, ar);
+
+  if (fcl->max_instructions > 0
+      && fcl->exec_instructions > fcl->max_instructions) {
+    luaL_error(L, "Instruction limit exceeded in script");
+  }
+  if (fcl->max_msec > 0 && fcl->exec_timer.hasExpired(fcl->max_msec)) {
     luaL_error(L, "Execution time limit exceeded in script");
   }
 }
 
 /**
-   Setup function execution guard
+   Setup function execution guard. Nested calls (a callback run by a signal
+   emitted from a script) count against the budget of the outermost one.
  */
-static void luascript_hook_start(lua_State *L)
+static void luascript_hook_start(struct fc_lua *fcl)
 {
 #if LUASCRIPT_CHECKINTERVAL
-  // Store clock timestamp in the registry
-  lua_pushnumber(L, clock());
-  lua_setfield(L, LUA_REGISTRYINDEX, "freeciv_exec_clock");
-  lua_sethook(L, luascript_exec_check, LUA_MASKCOUNT,
-              LUASCRIPT_CHECKINTERVAL);
+  if (fcl->exec_depth++ > 0) {
+    return;
+  }
+
+  fcl->exec_interval = luascript_profile_enabled(fcl)
+                           ? LUASCRIPT_PROFILEINTERVAL
+                           : LUASCRIPT_CHECKINTERVAL;
+  fcl->exec_instructions = 0;
+  fcl->exec_timer.start();
+  lua_sethook(fcl->state, luascript_exec_check, LUA_MASKCOUNT,
+              fcl->exec_interval);
 #endif
 }
 
 /**
    Clear function execution guard
  */
-static void luascript_hook_end(lua_State *L)
+static void luascript_hook_end(struct fc_lua *fcl)
 {
 #if LUASCRIPT_CHECKINTERVAL
-  lua_sethook(L, luascript_exec_check, 0, 0);
+  if (--fcl->exec_depth > 0) {
+    return;
+  }
+
+  lua_sethook(fcl->state, luascript_exec_check, 0, 0);
 #endif
 }
 
@@ -281,6 +301,9 @@ struct fc_lua *luascript_new(luascript_log_func_t output_fct,
   }
   fcl->output_fct = output_fct;
   fcl->caller = nullptr;
+  fcl->max_msec = LUASCRIPT_DEFAULT_MAX_MSEC;
+  fcl->max_instructions = 0;
+  luascript_profile_init(fcl);
 
   if (secured_environment) {
     luascript_openlibs(fcl->state, luascript_lualibs_secure);
@@ -342,6 +365,8 @@ void luascript_destroy(struct fc_lua *fcl)
     // Free signal data.
     luascript_signal_free(fcl);
 
+    luascript_profile_free(fcl);
+
     // Free lua state.
     if (fcl->state) {
       lua_gc(fcl->state, LUA_GCCOLLECT, 0); // Collected garbage
@@ -351,6 +376,20 @@ void luascript_destroy(struct fc_lua *fcl)
   }
 }
 
+/**
+   Set the limits of one call into the Lua instance. A call exceeding them
+   fails with an error. Use 0 to leave the wall time or the number of
+   executed instructions unlimited.
+ */
+void luascript_set_limits(struct fc_lua *fcl, int max_msec,
+                          qint64 max_instructions)
+{
+  fc_assert_ret(fcl != nullptr);
+
+  fcl->max_msec = MAX(0, max_msec);
+  fcl->max_instructions = MAX(0, max_instructions);
+}
+
 /**
  * Loads a script from a Qt resource file and executes it.
  */
@@ -596,9 +635,9 @@ int luascript_call(struct fc_lua *fcl, int narg, int nret, const char *code)
     lua_pop(fcl->state, 1); // pop non-function traceback
   }
 
-  luascript_hook_start(fcl->state);
+  luascript_hook_start(fcl);
   status = lua_pcall(fcl->state, narg, nret, traceback);
-  luascript_hook_end(fcl->state);
+  luascript_hook_end(fcl);
 
   if (status) {
     luascript_report(fcl, status, code);
@@ -658,6 +697,8 @@ bool luascript_callback_invoke(struct fc_lua *fcl, const char *callback_name,
                                va_list args)
 {
   bool stop_emission = false;
+  QElapsedTimer timer;
+  int status;
 
   fc_assert_ret_val(fcl, false);
   fc_assert_ret_val(fcl->state, false);
@@ -677,7 +718,10 @@ bool luascript_callback_invoke(struct fc_lua *fcl, const char *callback_name,
   luascript_push_args(fcl, nargs, parg_types, args);
 
   // Call the function with nargs arguments, return 1 results
-  if (luascript_call(fcl, nargs, 1, nullptr)) {
+  timer.start();
+  status = luascript_call(fcl, nargs, 1, nullptr);
+  luascript_profile_callback(fcl, callback_name, timer.nsecsElapsed());
+  if (status) {
     return false;
   }
 
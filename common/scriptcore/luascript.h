@@ -9,6 +9,7 @@
 **************************************************************************/
 #pragma once
 
+#include <QElapsedTimer>
 #include <QHash>
 #include <QVector>
 /* dependencies/tolua */
@@ -29,6 +30,7 @@ struct luascript_signal_hash;
 struct luascript_signal_name_list;
 struct connection;
 struct fc_lua;
+struct luascript_profile;
 
 typedef void (*luascript_log_func_t)(struct fc_lua *fcl, QtMsgType level,
                                      const char *format, ...)
@@ -45,6 +47,22 @@ struct fc_lua {
 
   QHash<QString, struct signal *> *signals_hash;
   QVector<QString> *signal_names;
+  // Signals by id, the index in signal_names
+  QVector<struct signal *> *signals_by_id;
+  // Signals by the address of the name string used to emit them
+  QHash<const char *, struct signal *> *signals_by_ptr;
+
+  // Execution limits of one outermost call. 0 means unlimited.
+  int max_msec;
+  qint64 max_instructions;
+
+  // State of the running outermost call.
+  int exec_depth;
+  int exec_interval; // instructions between two hook invocations
+  qint64 exec_instructions;
+  QElapsedTimer exec_timer;
+
+  struct luascript_profile *profile;
 };
 
 // Error functions for lua scripts.
@@ -59,6 +77,8 @@ struct fc_lua *luascript_new(luascript_log_func_t outputfct,
 void luascript_init(fc_lua *fcl);
 struct fc_lua *luascript_get_fcl(lua_State *L);
 void luascript_destroy(struct fc_lua *fcl);
+void luascript_set_limits(struct fc_lua *fcl, int max_msec,
+                          qint64 max_instructions);
 
 void luascript_common_a(lua_State *L);
 void luascript_common_z(lua_State *L);
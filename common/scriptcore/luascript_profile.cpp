@@ -0,0 +1,219 @@
+/*
+ Copyright (c) 1996-2020 Freeciv21 and Freeciv contributors. This file is
+ part of Freeciv21. Freeciv21 is free software: you can redistribute it
+ and/or modify it under the terms of the GNU  General Public License  as
+ published by the Free Software Foundation, either version 3 of the
+ License,  or (at your option) any later version. You should have received
+ a copy of the GNU General Public License along with Freeciv21. If not,
+ see https://www.gnu.org/licenses/.
+ */
+
+/**
+  Lua profiler.
+
+  While enabled, the instruction count hook that guards script execution
+  (see luascript_call()) fires more often and each time records a sample
+  for the running function and source line. Signal callbacks are timed as a
+  whole. The statistics are kept in periods (the server starts one every
+  turn) so that reports can cover the recent past only.
+ */
+
+#include <QHash>
+#include <QList>
+
+#include <algorithm>
+
+// utility
+#include "log.h"
+
+/* common/scriptcore */
+#include "luascript.h"
+
+#include "luascript_profile.h"
+
+// Number of periods kept in memory.
+#define LUASCRIPT_PROFILE_PERIODS 50
+
+struct luascript_profile_period {
+  QHash<QString, luascript_profile_stats> entries[LPK_COUNT];
+};
+
+struct luascript_profile {
+  bool enabled;
+  QList<luascript_profile_period> periods; // newest last
+};
+
+/**
+   Returns the period statistics are currently added to.
+ */
+static struct luascript_profile_period &
+profile_current(struct luascript_profile *profile)
+{
+  if (profile->periods.isEmpty()) {
+    profile->periods.append(luascript_profile_period());
+  }
+
+  return profile->periods.last();
+}
+
+/**
+   Create the profiler of a Lua instance. It starts disabled.
+ */
+void luascript_profile_init(struct fc_lua *fcl)
+{
+  fc_assert_ret(fcl != nullptr);
+
+  if (fcl->profile == nullptr) {
+    fcl->profile = new luascript_profile;
+    fcl->profile->enabled = false;
+  }
+}
+
+/**
+   Free the profiler of a Lua instance.
+ */
+void luascript_profile_free(struct fc_lua *fcl)
+{
+  if (fcl != nullptr) {
+    delete fcl->profile;
+    fcl->profile = nullptr;
+  }
+}
+
+/**
+   Start or stop collecting profile data. Collected data is kept.
+ */
+void luascript_profile_set_enabled(struct fc_lua *fcl, bool enabled)
+{
+  fc_assert_ret(fcl != nullptr && fcl->profile != nullptr);
+
+  fcl->profile->enabled = enabled;
+}
+
+/**
+   Returns whether profile data is being collected.
+ */
+bool luascript_profile_enabled(const struct fc_lua *fcl)
+{
+  return fcl != nullptr && fcl->profile != nullptr
+         && fcl->profile->enabled;
+}
+
+/**
+   Drop all collected profile data.
+ */
+void luascript_profile_reset(struct fc_lua *fcl)
+{
+  fc_assert_ret(fcl != nullptr && fcl->profile != nullptr);
+
+  fcl->profile->periods.clear();
+}
+
+/**
+   Start a new period. The oldest one is dropped when there are too many.
+ */
+void luascript_profile_new_period(struct fc_lua *fcl)
+{
+  struct luascript_profile *profile;
+
+  fc_assert_ret(fcl != nullptr && fcl->profile != nullptr);
+
+  profile = fcl->profile;
+  if (!profile->enabled) {
+    return;
+  }
+
+  profile->periods.append(luascript_profile_period());
+  while (profile->periods.size() > LUASCRIPT_PROFILE_PERIODS) {
+    profile->periods.removeFirst();
+  }
+}
+
+/**
+   Record an instruction sample. Called from the count hook with the
+   activation record of the running function.
+ */
+void luascript_profile_sample(struct fc_lua *fcl, lua_State *L,
+                              lua_Debug *ar)
+{
+  if (!luascript_profile_enabled(fcl) || !lua_getinfo(L, "Sl", ar)) {
+    return;
+  }
+
+  auto &period = profile_current(fcl->profile);
+
+  period
+      .entries[LPK_FUNCTION][QStringLiteral("%1:%2").arg(
+          ar->short_src, QString::number(ar->linedefined))]
+      .samples++;
+  if (ar->currentline > 0) {
+    period
+        .entries[LPK_LINE][QStringLiteral("%1:%2").arg(
+            ar->short_src, QString::number(ar->currentline))]
+        .samples++;
+  }
+}
+
+/**
+   Record a completed invocation of the signal callback 'name'.
+ */
+void luascript_profile_callback(struct fc_lua *fcl, const char *name,
+                                qint64 nsecs)
+{
+  if (!luascript_profile_enabled(fcl)) {
+    return;
+  }
+
+  auto &stats =
+      profile_current(fcl->profile).entries[LPK_HANDLER][QString(name)];
+
+  stats.calls++;
+  stats.nsecs += nsecs;
+}
+
+/**
+   Returns at most 'count' entries of the given kind, summed over the last
+   'periods' periods and sorted with the most expensive first. Handlers are
+   sorted by time, other entries by samples.
+ */
+QVector<luascript_profile_entry>
+luascript_profile_top(const struct fc_lua *fcl,
+                      enum luascript_profile_kind kind, int periods,
+                      int count)
+{
+  QHash<QString, luascript_profile_stats> sum;
+  QVector<luascript_profile_entry> top;
+
+  fc_assert_ret_val(fcl != nullptr && fcl->profile != nullptr, top);
+  fc_assert_ret_val(kind >= 0 && kind < LPK_COUNT, top);
+
+  const auto &all = fcl->profile->periods;
+  for (int i = std::max(0, all.size() - periods); i < all.size(); i++) {
+    for (auto it = all[i].entries[kind].cbegin();
+         it != all[i].entries[kind].cend(); ++it) {
+      auto &stats = sum[it.key()];
+
+      stats.calls += it.value().calls;
+      stats.nsecs += it.value().nsecs;
+      stats.samples += it.value().samples;
+    }
+  }
+
+  top.reserve(sum.size());
+  for (auto it = sum.cbegin(); it != sum.cend(); ++it) {
+    top.append({it.key(), it.value()});
+  }
+  std::sort(top.begin(), top.end(),
+            [kind](const luascript_profile_entry &a,
+                   const luascript_profile_entry &b) {
+              if (kind == LPK_HANDLER) {
+                return a.stats.nsecs > b.stats.nsecs;
+              }
+              return a.stats.samples > b.stats.samples;
+            });
+  if (top.size() > count) {
+    top.resize(count);
+  }
+
+  return top;
+}
@@ -0,0 +1,57 @@
+/**************************************************************************
+ Copyright (c) 1996-2020 Freeciv21 and Freeciv contributors. This file is
+ part of Freeciv21. Freeciv21 is free software: you can redistribute it
+ and/or modify it under the terms of the GNU  General Public License  as
+ published by the Free Software Foundation, either version 3 of the
+ License,  or (at your option) any later version. You should have received
+ a copy of the GNU General Public License along with Freeciv21. If not,
+ see https://www.gnu.org/licenses/.
+**************************************************************************/
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+/* dependencies/lua */
+extern "C" {
+#include "lua.h"
+}
+
+struct fc_lua;
+
+// What a profile entry is attributed to.
+enum luascript_profile_kind {
+  LPK_HANDLER,  // signal callback, by Lua function name
+  LPK_FUNCTION, // Lua function, by source and line of its definition
+  LPK_LINE,     // source line
+  LPK_COUNT
+};
+
+struct luascript_profile_stats {
+  int calls = 0;      // completed handler invocations
+  qint64 nsecs = 0;   // wall time of the handler invocations
+  qint64 samples = 0; // instruction samples taken in the entry
+};
+
+struct luascript_profile_entry {
+  QString name;
+  struct luascript_profile_stats stats;
+};
+
+void luascript_profile_init(struct fc_lua *fcl);
+void luascript_profile_free(struct fc_lua *fcl);
+
+void luascript_profile_set_enabled(struct fc_lua *fcl, bool enabled);
+bool luascript_profile_enabled(const struct fc_lua *fcl);
+void luascript_profile_reset(struct fc_lua *fcl);
+void luascript_profile_new_period(struct fc_lua *fcl);
+
+void luascript_profile_sample(struct fc_lua *fcl, lua_State *L,
+                              lua_Debug *ar);
+void luascript_profile_callback(struct fc_lua *fcl, const char *name,
+                                qint64 nsecs);
+
+QVector<luascript_profile_entry>
+luascript_profile_top(const struct fc_lua *fcl,
+                      enum luascript_profile_kind kind, int periods,
+                      int count);
@@ -32,7 +32,14 @@
     return false
 
   If the value is 'true' the current signal emission will be stopped.
+
+  Each signal gets an integer id when it is created. Signals are almost
+  always emitted with a string literal as name, so name lookups are cached
+  by the address of the string and only confirmed with a strcmp(). A
+  signal with no callback costs nothing more than that lookup.
  */
+#include <QElapsedTimer>
+
 // utility
 #include "deprecations.h"
 
@@ -44,7 +51,8 @@
 
 static struct signal_callback *signal_callback_new(const char *name);
 static void signal_callback_destroy(struct signal_callback *pcallback);
-static struct signal *signal_new(int nargs, enum api_types *parg_types);
+static struct signal *signal_new(int id, const char *name, int nargs,
+                                 enum api_types *parg_types);
 static void signal_destroy(struct signal *psignal);
 
 /**
@@ -70,14 +78,20 @@ static void signal_callback_destroy(struct signal_callback *pcallback)
 /**
    Create a new signal.
  */
-static struct signal *signal_new(int nargs, enum api_types *parg_types)
+static struct signal *signal_new(int id, const char *name, int nargs,
+                                 enum api_types *parg_types)
 {
   auto *psignal = new struct signal;
 
+  psignal->id = id;
+  psignal->name = fc_strdup(name);
   psignal->nargs = nargs;
   psignal->arg_types = parg_types;
   psignal->callbacks = new QList<signal_callback *>;
   psignal->depr_msg = nullptr;
+  psignal->emits = 0;
+  psignal->calls = 0;
+  psignal->nsecs = 0;
 
   return psignal;
 }
@@ -87,6 +101,7 @@ static struct signal *signal_new(int nargs, enum api_types *parg_types)
  */
 static void signal_destroy(struct signal *psignal)
 {
+  delete[] psignal->name;
   delete[] psignal->arg_types;
   delete[] psignal->depr_msg;
   while (!psignal->callbacks->isEmpty()) {
@@ -97,6 +112,54 @@ static void signal_destroy(struct signal *psignal)
   delete psignal;
 }
 
+/**
+   Find a signal by name, see the comment at the top of the file.
+ */
+static struct signal *signal_lookup(struct fc_lua *fcl,
+                                    const char *signal_name)
+{
+  struct signal *psignal =
+      fcl->signals_by_ptr->value(signal_name, nullptr);
+
+  if (psignal != nullptr && strcmp(psignal->name, signal_name) == 0) {
+    return psignal;
+  }
+
+  psignal = fcl->signals_hash->value(signal_name, nullptr);
+  if (psignal != nullptr) {
+    fcl->signals_by_ptr->insert(signal_name, psignal);
+  }
+
+  return psignal;
+}
+
+/**
+   Invoke all the callback functions attached to a given signal.
+ */
+static void signal_emit(struct fc_lua *fcl, struct signal *psignal,
+                        va_list args)
+{
+  psignal->emits++;
+
+  for (auto *pcallback : qAsConst(*psignal->callbacks)) {
+    QElapsedTimer timer;
+    bool stop;
+    va_list args_cb;
+
+    va_copy(args_cb, args);
+    timer.start();
+    stop = luascript_callback_invoke(fcl, pcallback->name, psignal->nargs,
+                                     psignal->arg_types, args_cb);
+    psignal->calls++;
+    psignal->nsecs += timer.nsecsElapsed();
+    va_end(args_cb);
+
+    if (stop) {
+      break;
+    }
+  }
+}
+
 /**
    Invoke all the callback functions attached to a given signal.
  */
@@ -108,19 +171,9 @@ void luascript_signal_emit_valist(struct fc_lua *fcl,
   fc_assert_ret(fcl);
   fc_assert_ret(fcl->signals_hash);
 
-  psignal = fcl->signals_hash->value(signal_name, nullptr);
+  psignal = signal_lookup(fcl, signal_name);
   if (psignal) {
-    for (auto *pcallback : qAsConst(*psignal->callbacks)) {
-      va_list args_cb;
-
-      va_copy(args_cb, args);
-      if (luascript_callback_invoke(fcl, pcallback->name, psignal->nargs,
-                                    psignal->arg_types, args_cb)) {
-        va_end(args_cb);
-        break;
-      }
-      va_end(args_cb);
-    }
+    signal_emit(fcl, psignal, args);
   } else {
     luascript_log(fcl, LOG_ERROR,
                   "Signal \"%s\" does not exist, so cannot "
@@ -129,6 +182,82 @@ void luascript_signal_emit_valist(struct fc_lua *fcl,
   }
 }
 
+/**
+   Invoke all the callback functions attached to the signal with the given
+   id.
+ */
+void luascript_signal_emit_id_valist(struct fc_lua *fcl, int signal_id,
+                                     va_list args)
+{
+  fc_assert_ret(fcl);
+  fc_assert_ret(fcl->signals_by_id);
+  fc_assert_ret(signal_id >= 0 && signal_id < fcl->signals_by_id->size());
+
+  signal_emit(fcl, fcl->signals_by_id->at(signal_id), args);
+}
+
+/**
+   Return the id of the signal with the given name, or -1 if there is no
+   such signal.
+ */
+int luascript_signal_id(struct fc_lua *fcl, const char *signal_name)
+{
+  struct signal *psignal;
+
+  fc_assert_ret_val(fcl, -1);
+  fc_assert_ret_val(fcl->signals_hash, -1);
+
+  psignal = signal_lookup(fcl, signal_name);
+
+  return psignal != nullptr ? psignal->id : -1;
+}
+
+/**
+   Returns whether any callback is connected to the signal with the given
+   id. When there is none, callers can skip preparing the arguments.
+ */
+bool luascript_signal_has_callbacks(struct fc_lua *fcl, int signal_id)
+{
+  fc_assert_ret_val(fcl, false);
+  fc_assert_ret_val(fcl->signals_by_id, false);
+
+  if (signal_id < 0 || signal_id >= fcl->signals_by_id->size()) {
+    return false;
+  }
+
+  return !fcl->signals_by_id->at(signal_id)->callbacks->isEmpty();
+}
+
+/**
+   Return the signal with the given id, or nullptr.
+ */
+const struct signal *luascript_signal_get(struct fc_lua *fcl, int signal_id)
+{
+  fc_assert_ret_val(fcl, nullptr);
+  fc_assert_ret_val(fcl->signals_by_id, nullptr);
+
+  if (signal_id < 0 || signal_id >= fcl->signals_by_id->size()) {
+    return nullptr;
+  }
+
+  return fcl->signals_by_id->at(signal_id);
+}
+
+/**
+   Reset the emission and timing statistics of all signals.
+ */
+void luascript_signal_stats_reset(struct fc_lua *fcl)
+{
+  fc_assert_ret(fcl);
+  fc_assert_ret(fcl->signals_by_id);
+
+  for (auto *psignal : qAsConst(*fcl->signals_by_id)) {
+    psignal->emits = 0;
+    psignal->calls = 0;
+    psignal->nsecs = 0;
+  }
+}
+
 /**
    Invoke all the callback functions attached to a given signal.
  */
@@ -167,9 +296,11 @@ static struct signal *luascript_signal_create_valist(struct fc_lua *fcl,
     for (i = 0; i < nargs; i++) {
       *(parg_types + i) = api_types(va_arg(args, int));
     }
-    created = signal_new(nargs, parg_types);
+    created = signal_new(fcl->signals_by_id->size(), signal_name, nargs,
+                         parg_types);
     fcl->signals_hash->insert(signal_name, created);
     fcl->signal_names->append(sn);
+    fcl->signals_by_id->append(created);
 
     return created;
   }
@@ -305,6 +436,8 @@ void luascript_signal_init(struct fc_lua *fcl)
   if (nullptr == fcl->signals_hash) {
     fcl->signals_hash = new QHash<QString, struct signal *>;
     fcl->signal_names = new QVector<QString>;
+    fcl->signals_by_id = new QVector<struct signal *>;
+    fcl->signals_by_ptr = new QHash<const char *, struct signal *>;
   }
 }
 
@@ -321,8 +454,12 @@ void luascript_signal_free(struct fc_lua *fcl)
   }
   delete fcl->signals_hash;
   delete fcl->signal_names;
+  delete fcl->signals_by_id;
+  delete fcl->signals_by_ptr;
   fcl->signals_hash = nullptr;
   fcl->signal_names = nullptr;
+  fcl->signals_by_id = nullptr;
+  fcl->signals_by_ptr = nullptr;
 }
 
 /**
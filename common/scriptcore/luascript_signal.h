@@ -23,10 +23,17 @@ struct signal_callback {
 
 // Signal datastructure.
 struct signal {
+  int id;                              // index in fc_lua::signals_by_id
+  char *name;                          // signal name
   int nargs;                           // number of arguments to pass
   enum api_types *arg_types;           // argument types
   QList<signal_callback *> *callbacks; // connected callbacks
   char *depr_msg; // deprecation message to show if handler added
+
+  // Statistics
+  int emits;       // times the signal was emitted
+  int calls;       // times a callback was invoked
+  qint64 nsecs;    // time spent in the callbacks
 };
 
 void luascript_signal_init(struct fc_lua *fcl);
@@ -35,6 +42,13 @@ void luascript_signal_free(struct fc_lua *fcl);
 void luascript_signal_emit_valist(struct fc_lua *fcl,
                                   const char *signal_name, va_list args);
 void luascript_signal_emit(struct fc_lua *fcl, const char *signal_name, ...);
+int luascript_signal_id(struct fc_lua *fcl, const char *signal_name);
+bool luascript_signal_has_callbacks(struct fc_lua *fcl, int signal_id);
+void luascript_signal_emit_id_valist(struct fc_lua *fcl, int signal_id,
+                                     va_list args);
+const struct signal *luascript_signal_get(struct fc_lua *fcl,
+                                          int signal_id);
+void luascript_signal_stats_reset(struct fc_lua *fcl);
 signal_deprecator *luascript_signal_create(struct fc_lua *fcl,
                                            const char *signal_name,
                                            int nargs, ...);
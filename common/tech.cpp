@@ -201,6 +201,40 @@ bool advance_has_flag(Tech_type_id tech, enum tech_flag_id flag)
   return BV_ISSET(advance_by_number(tech)->flags, flag);
 }
 
+/**
+   Precalculate the requirement sets of every technology, so that
+   research_update() can work on bitvectors instead of walking the tech
+   tree again for every technology. Must be called once the requirements
+   of all the technologies are known.
+ */
+void techs_precalc_reqs()
+{
+  advance_iterate(A_NONE, padvance)
+  {
+    BV_CLR_ALL(padvance->all_reqs);
+    BV_CLR_ALL(padvance->root_reqs);
+  }
+  advance_iterate_end;
+
+  advance_iterate(A_FIRST, padvance)
+  {
+    advance_req_iterate(padvance, preq)
+    {
+      BV_SET(padvance->all_reqs, advance_number(preq));
+    }
+    advance_req_iterate_end;
+
+    advance_root_req_iterate(padvance, proot)
+    {
+      if (nullptr != proot) {
+        BV_SET(padvance->root_reqs, advance_number(proot));
+      }
+    }
+    advance_root_req_iterate_end;
+  }
+  advance_iterate_end;
+}
+
 /**
    Function to precalculate needed data for technologies.
  */
@@ -209,6 +243,8 @@ void techs_precalc_data()
   fc_assert_msg(tech_cost_style_is_valid(game.info.tech_cost_style),
                 "Invalid tech_cost_style %d", game.info.tech_cost_style);
 
+  techs_precalc_reqs();
+
   advance_iterate(A_FIRST, padvance)
   {
     int num_reqs = 0;
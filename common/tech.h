@@ -110,6 +110,8 @@ struct tech_class {
   int cost_pct;
 };
 
+BV_DEFINE(bv_techs, A_LAST);
+
 struct advance {
   Tech_type_id item_number;
   struct name_translation name;
@@ -142,9 +144,15 @@ struct advance {
    * itself. Precalculated at server then send to client.
    */
   int num_reqs;
-};
 
-BV_DEFINE(bv_techs, A_LAST);
+  /*
+   * This technology and all its requirements, as advance_req_iterate()
+   * visits them, and its root requirements, as advance_root_req_iterate()
+   * visits them. Precalculated by techs_precalc_reqs() at both ends.
+   */
+  bv_techs all_reqs;
+  bv_techs root_reqs;
+};
 
 /* General advance/technology accessor functions. */
 Tech_type_id advance_count();
@@ -213,6 +221,7 @@ void techs_init();
 void techs_free();
 
 void techs_precalc_data();
+void techs_precalc_reqs();
 
 // Iteration
 
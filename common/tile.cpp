@@ -17,6 +17,7 @@
 #include "support.h"
 
 // common
+#include "city.h"
 #include "fc_interface.h"
 #include "game.h"
 #include "map.h"
@@ -61,11 +62,25 @@ void tile_set_owner(struct tile *ptile, struct player *pplayer,
   if (BORDERS_DISABLED != game.info.borders
       // City tiles are always owned by the city owner.
       || (tile_city(ptile) != nullptr || ptile->owner != nullptr)) {
+    if (ptile->owner != pplayer) {
+      city_tile_cache_tile_changed(ptile);
+    }
     ptile->owner = pplayer;
     ptile->claimer = claimer;
   }
 }
 
+/**
+   Set the owner of the extras on a tile (may be nullptr).
+ */
+void tile_set_extras_owner(struct tile *ptile, struct player *pplayer)
+{
+  if (ptile->extras_owner != pplayer) {
+    city_tile_cache_tile_changed(ptile);
+  }
+  ptile->extras_owner = pplayer;
+}
+
 /**
    Return the city on this tile (or nullptr), checking for city center.
  */
@@ -132,6 +147,9 @@ void tile_set_terrain(struct tile *ptile, struct terrain *pterrain)
       TILE_XY(ptile), terrain_rule_name(pterrain), terrain_number(pterrain),
       city_name_get(tile_city(ptile)), tile_city(ptile)->id);
 
+  if (ptile->terrain != pterrain) {
+    city_tile_cache_tile_changed(ptile);
+  }
   ptile->terrain = pterrain;
   if (ptile->resource != nullptr) {
     if (nullptr != pterrain
@@ -355,7 +373,8 @@ const struct resource_type *tile_resource(const struct tile *ptile)
 void tile_set_resource(struct tile *ptile, struct extra_type *presource)
 {
   if (presource == ptile->resource) {
-    return; // No change
+    // No change, e.g. a tile_info packet sending the same resource again
+    return;
   }
 
   if (ptile->resource != nullptr) {
@@ -367,6 +386,8 @@ void tile_set_resource(struct tile *ptile, struct extra_type *presource)
     }
   }
 
+  // The outputs read the resource itself, not only the extras
+  city_tile_cache_tile_changed(ptile);
   ptile->resource = presource;
 }
 
@@ -1022,8 +1043,9 @@ bool tile_has_visible_extra(const struct tile *ptile,
  */
 void tile_add_extra(struct tile *ptile, const struct extra_type *pextra)
 {
-  if (pextra != nullptr) {
+  if (pextra != nullptr && !BV_ISSET(ptile->extras, extra_index(pextra))) {
     BV_SET(ptile->extras, extra_index(pextra));
+    city_tile_cache_tile_changed(ptile);
   }
 }
 
@@ -1032,8 +1054,9 @@ void tile_add_extra(struct tile *ptile, const struct extra_type *pextra)
  */
 void tile_remove_extra(struct tile *ptile, const struct extra_type *pextra)
 {
-  if (pextra != nullptr) {
+  if (pextra != nullptr && BV_ISSET(ptile->extras, extra_index(pextra))) {
     BV_CLR(ptile->extras, extra_index(pextra));
+    city_tile_cache_tile_changed(ptile);
   }
 }
 
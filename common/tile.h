@@ -80,6 +80,7 @@ void tile_set_continent(struct tile *ptile, Continent_id val);
 void tile_set_owner(struct tile *ptile, struct player *pplayer,
                     struct tile *claimer);
 #define tile_claimer(_tile) ((_tile)->claimer)
+void tile_set_extras_owner(struct tile *ptile, struct player *pplayer);
 
 #define tile_resource(_tile) ((_tile)->resource)
 static inline bool tile_resource_is_valid(const struct tile *ptile)
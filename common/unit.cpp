@@ -41,9 +41,15 @@ const Activity_type_id tile_changing_activities[] = {
     ACTIVITY_PLANT,   ACTIVITY_TRANSFORM, ACTIVITY_POLLUTION,
     ACTIVITY_FALLOUT, ACTIVITY_LAST};
 
+/* Unit list links are invalidated by any change to their list, so the
+ * iterator keeps, for each level, the transport, the current unit and its
+ * position in the transport's cargo. The body may then load or unload
+ * units like with unit_list_iterate(). */
 struct cargo_iter {
   struct iterator vtable;
-  const struct unit_list_link *links[GAME_TRANSPORT_MAX_RECURSIVE];
+  const struct unit *trans[GAME_TRANSPORT_MAX_RECURSIVE];
+  struct unit *cargo[GAME_TRANSPORT_MAX_RECURSIVE];
+  int pos[GAME_TRANSPORT_MAX_RECURSIVE];
   int depth;
 };
 #define CARGO_ITER(iter) ((struct cargo_iter *) (iter))
@@ -2460,7 +2466,7 @@ static void *cargo_iter_get(const struct iterator *it)
 {
   const struct cargo_iter *iter = CARGO_ITER(it);
 
-  return unit_list_link_data(iter->links[iter->depth - 1]);
+  return iter->cargo[iter->depth - 1];
 }
 
 /**
@@ -2469,27 +2475,45 @@ static void *cargo_iter_get(const struct iterator *it)
 static void cargo_iter_next(struct iterator *it)
 {
   struct cargo_iter *iter = CARGO_ITER(it);
-  const struct unit_list_link *piter = iter->links[iter->depth - 1];
-  const struct unit_list_link *pnext;
+  struct unit *pcargo = iter->cargo[iter->depth - 1];
+  const struct unit_list *plist = unit_transport_cargo(pcargo);
 
   // Variant 1: unit has cargo.
-  pnext = unit_list_head(unit_transport_cargo(unit_list_link_data(piter)));
-  if (nullptr != pnext) {
-    fc_assert(iter->depth < ARRAY_SIZE(iter->links));
-    iter->links[iter->depth++] = pnext;
+  if (nullptr != plist && 0 < unit_list_size(plist)) {
+    fc_assert(iter->depth < ARRAY_SIZE(iter->cargo));
+    iter->trans[iter->depth] = pcargo;
+    iter->cargo[iter->depth] = unit_list_get(plist, 0);
+    iter->pos[iter->depth] = 0;
+    iter->depth++;
     return;
   }
 
   do {
     // Variant 2: there are other cargo units at same level.
-    pnext = unit_list_link_next(piter);
-    if (nullptr != pnext) {
-      iter->links[iter->depth - 1] = pnext;
+    int level = iter->depth - 1;
+    int pos = iter->pos[level];
+
+    plist = unit_transport_cargo(iter->trans[level]);
+    if (pos >= unit_list_size(plist)
+        || unit_list_get(plist, pos) != iter->cargo[level]) {
+      // The list changed: find the unit again, or take the one in its place
+      int size = unit_list_size(plist);
+      int i;
+
+      for (i = 0; i < size && unit_list_get(plist, i) != iter->cargo[level];
+           i++) {
+        // Nothing.
+      }
+      pos = (i < size ? i : pos - 1);
+    }
+    if (pos + 1 < unit_list_size(plist)) {
+      iter->pos[level] = pos + 1;
+      iter->cargo[level] = unit_list_get(plist, pos + 1);
       return;
     }
 
     // Variant 3: return to previous level, and do same tests.
-    piter = iter->links[iter->depth-- - 2];
+    iter->depth--;
   } while (0 < iter->depth);
 }
 
@@ -2512,8 +2536,10 @@ struct iterator *cargo_iter_init(struct cargo_iter *iter,
   it->get = cargo_iter_get;
   it->next = cargo_iter_next;
   it->valid = cargo_iter_valid;
-  iter->links[0] = unit_list_head(unit_transport_cargo(ptrans));
-  iter->depth = (nullptr != iter->links[0] ? 1 : 0);
+  iter->trans[0] = ptrans;
+  iter->cargo[0] = unit_list_front(unit_transport_cargo(ptrans));
+  iter->pos[0] = 0;
+  iter->depth = (nullptr != iter->cargo[0] ? 1 : 0);
 
   return it;
 }
@@ -9,14 +9,421 @@
                   see https://www.gnu.org/licenses/.
  */
 
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
 // utility
 #include "log.h"
+#include "rand.h"
 
 // common
 #include "game.h"
 #include "movement.h"
 #include "unitlist.h"
 
+/**
+   Create a new empty unit list.
+ */
+struct unit_list *unit_list_new() { return unit_list_new_full(nullptr); }
+
+/**
+   Create a new empty unit list with a free callback.
+ */
+struct unit_list *unit_list_new_full(unit_list_free_fn_t free_data_func)
+{
+  auto *plist = new unit_list;
+
+  plist->units.append(nullptr);
+  plist->units.append(nullptr);
+  plist->free_data_func = free_data_func;
+
+  return plist;
+}
+
+/**
+   Free a unit list.
+ */
+void unit_list_destroy(struct unit_list *tthis)
+{
+  if (nullptr == tthis) {
+    return;
+  }
+
+  unit_list_clear(tthis);
+  delete tthis;
+}
+
+/**
+   Duplicate a unit list.
+ */
+struct unit_list *unit_list_copy(const struct unit_list *tthis)
+{
+  return unit_list_copy_full(tthis, nullptr, tthis->free_data_func);
+}
+
+/**
+   Duplicate a unit list with a free callback and a function to copy each
+   unit.
+ */
+struct unit_list *unit_list_copy_full(const struct unit_list *tthis,
+                                      unit_list_copy_fn_t copy_data_func,
+                                      unit_list_free_fn_t free_data_func)
+{
+  struct unit_list *pcopy = unit_list_new_full(free_data_func);
+
+  if (nullptr != tthis) {
+    if (nullptr != copy_data_func) {
+      unit_list_iterate(tthis, punit)
+      {
+        unit_list_append(pcopy, copy_data_func(punit));
+      }
+      unit_list_iterate_end;
+    } else {
+      pcopy->units = tthis->units;
+    }
+  }
+
+  return pcopy;
+}
+
+/**
+   Removes the unit at position 'idx' and calls the free callback on it.
+   The unit is detached before, for avoiding re-entrant code.
+ */
+static void unit_list_remove_at(struct unit_list *tthis, int idx)
+{
+  struct unit *punit = tthis->units[idx + 1];
+
+  tthis->units.remove(idx + 1);
+  if (nullptr != tthis->free_data_func) {
+    tthis->free_data_func(punit);
+  }
+}
+
+/**
+   Remove all units from the list.
+ */
+void unit_list_clear(struct unit_list *tthis)
+{
+  fc_assert_ret(nullptr != tthis);
+
+  if (0 == unit_list_size(tthis)) {
+    return;
+  }
+
+  if (nullptr != tthis->free_data_func) {
+    // Detach the units before freeing them, for avoiding re-entrant code.
+    auto units = tthis->units;
+
+    tthis->units.resize(2);
+    tthis->units[1] = nullptr;
+    for (int i = 1; i < units.size() - 1; i++) {
+      tthis->free_data_func(units[i]);
+    }
+  } else {
+    tthis->units.resize(2);
+    tthis->units[1] = nullptr;
+  }
+}
+
+/**
+   Remove all duplicates from every group of consecutive equal units.
+ */
+void unit_list_unique(struct unit_list *tthis)
+{
+  unit_list_unique_full(tthis, nullptr);
+}
+
+/**
+   Remove all duplicates from every group of consecutive equal units, the
+   units being equal if 'comp_data_func' returns TRUE.
+ */
+void unit_list_unique_full(struct unit_list *tthis,
+                           unit_list_comp_fn_t comp_data_func)
+{
+  fc_assert_ret(nullptr != tthis);
+
+  // Keep the last unit of each group, like genlist_unique_full().
+  for (int i = 0; i < unit_list_size(tthis) - 1;) {
+    struct unit *punit = tthis->units[i + 1];
+    struct unit *pnext = tthis->units[i + 2];
+
+    if (nullptr != comp_data_func ? comp_data_func(punit, pnext)
+                                  : punit == pnext) {
+      unit_list_remove_at(tthis, i);
+    } else {
+      i++;
+    }
+  }
+}
+
+/**
+   Insert a unit at the given position. -1 or a position out of range
+   appends it.
+ */
+void unit_list_insert(struct unit_list *tthis, struct unit *punit, int idx)
+{
+  fc_assert_ret(nullptr != tthis);
+
+  if (0 > idx || idx >= unit_list_size(tthis)) {
+    unit_list_append(tthis, punit);
+  } else {
+    tthis->units.insert(idx + 1, punit);
+  }
+}
+
+/**
+   Returns the position of the link in the list.
+ */
+static int unit_list_link_index(const struct unit_list *tthis,
+                                const struct unit_list_link *plink)
+{
+  return reinterpret_cast<struct unit *const *>(plink)
+         - tthis->units.constData() - 1;
+}
+
+/**
+   Insert a unit after the link. If plink is nullptr, prepend it.
+ */
+void unit_list_insert_after(struct unit_list *tthis, struct unit *punit,
+                            struct unit_list_link *plink)
+{
+  fc_assert_ret(nullptr != tthis);
+
+  tthis->units.insert(
+      nullptr != plink ? unit_list_link_index(tthis, plink) + 2 : 1, punit);
+}
+
+/**
+   Insert a unit before the link. If plink is nullptr, append it.
+ */
+void unit_list_insert_before(struct unit_list *tthis, struct unit *punit,
+                             struct unit_list_link *plink)
+{
+  fc_assert_ret(nullptr != tthis);
+
+  if (nullptr != plink) {
+    tthis->units.insert(unit_list_link_index(tthis, plink) + 1, punit);
+  } else {
+    unit_list_append(tthis, punit);
+  }
+}
+
+/**
+   Search 'punit' in the list, and remove it. Returns TRUE on success.
+ */
+bool unit_list_remove(struct unit_list *tthis, const struct unit *punit)
+{
+  fc_assert_ret_val(nullptr != tthis, false);
+
+  for (int i = 0; i < unit_list_size(tthis); i++) {
+    if (tthis->units[i + 1] == punit) {
+      unit_list_remove_at(tthis, i);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+   Remove the first unit which fits the conditional function. Returns TRUE
+   on success.
+ */
+bool unit_list_remove_if(struct unit_list *tthis,
+                         unit_list_cond_fn_t cond_data_func)
+{
+  fc_assert_ret_val(nullptr != tthis, false);
+
+  if (nullptr != cond_data_func) {
+    for (int i = 0; i < unit_list_size(tthis); i++) {
+      if (cond_data_func(tthis->units[i + 1])) {
+        unit_list_remove_at(tthis, i);
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+/**
+   Remove 'punit' from the whole list. Returns the number of removed units.
+ */
+int unit_list_remove_all(struct unit_list *tthis, const struct unit *punit)
+{
+  int count = 0;
+
+  fc_assert_ret_val(nullptr != tthis, 0);
+
+  for (int i = 0; i < unit_list_size(tthis);) {
+    if (tthis->units[i + 1] == punit) {
+      unit_list_remove_at(tthis, i);
+      count++;
+    } else {
+      i++;
+    }
+  }
+
+  return count;
+}
+
+/**
+   Remove all units which fit the conditional function. Returns the number
+   of removed units.
+ */
+int unit_list_remove_all_if(struct unit_list *tthis,
+                            unit_list_cond_fn_t cond_data_func)
+{
+  int count = 0;
+
+  fc_assert_ret_val(nullptr != tthis, 0);
+
+  if (nullptr != cond_data_func) {
+    for (int i = 0; i < unit_list_size(tthis);) {
+      if (cond_data_func(tthis->units[i + 1])) {
+        unit_list_remove_at(tthis, i);
+        count++;
+      } else {
+        i++;
+      }
+    }
+  }
+
+  return count;
+}
+
+/**
+   Remove the unit pointed by 'plink'.
+
+   NB: After calling this function no link of the list is usable anymore.
+ */
+void unit_list_erase(struct unit_list *tthis, struct unit_list_link *plink)
+{
+  fc_assert_ret(nullptr != tthis);
+
+  if (nullptr != plink) {
+    unit_list_remove_at(tthis, unit_list_link_index(tthis, plink));
+  }
+}
+
+/**
+   Remove the first unit of the list.
+ */
+void unit_list_pop_front(struct unit_list *tthis)
+{
+  fc_assert_ret(nullptr != tthis);
+
+  if (0 < unit_list_size(tthis)) {
+    unit_list_remove_at(tthis, 0);
+  }
+}
+
+/**
+   Remove the last unit of the list.
+ */
+void unit_list_pop_back(struct unit_list *tthis)
+{
+  fc_assert_ret(nullptr != tthis);
+
+  if (0 < unit_list_size(tthis)) {
+    unit_list_remove_at(tthis, unit_list_size(tthis) - 1);
+  }
+}
+
+/**
+   Return the link of the first unit equal to 'punit'.
+ */
+struct unit_list_link *unit_list_search(const struct unit_list *tthis,
+                                        const struct unit *punit)
+{
+  fc_assert_ret_val(nullptr != tthis, nullptr);
+
+  for (int i = 0; i < unit_list_size(tthis); i++) {
+    if (tthis->units[i + 1] == punit) {
+      return unit_list_link_get(tthis, i);
+    }
+  }
+
+  return nullptr;
+}
+
+/**
+   Return the link of the first unit which fits the conditional function.
+ */
+struct unit_list_link *
+unit_list_search_if(const struct unit_list *tthis,
+                    unit_list_cond_fn_t cond_data_func)
+{
+  fc_assert_ret_val(nullptr != tthis, nullptr);
+
+  if (nullptr != cond_data_func) {
+    for (int i = 0; i < unit_list_size(tthis); i++) {
+      if (cond_data_func(tthis->units[i + 1])) {
+        return unit_list_link_get(tthis, i);
+      }
+    }
+  }
+
+  return nullptr;
+}
+
+/**
+   Sort the list. This uses qsort() like genlist_sort(), so that a given
+   list is sorted the same way.
+ */
+void unit_list_sort(struct unit_list *tthis,
+                    int (*compar)(const struct unit *const *,
+                                  const struct unit *const *))
+{
+  fc_assert_ret(nullptr != tthis);
+
+  if (1 < unit_list_size(tthis)) {
+    qsort(tthis->units.data() + 1, unit_list_size(tthis),
+          sizeof(struct unit *),
+          reinterpret_cast<int (*)(const void *, const void *)>(compar));
+  }
+}
+
+/**
+   Randomize the order of the units. This draws the same random numbers as
+   genlist_shuffle().
+ */
+void unit_list_shuffle(struct unit_list *tthis)
+{
+  const int n = unit_list_size(tthis);
+  std::vector<struct unit *> units;
+  std::vector<int> shuffle;
+
+  if (n <= 1) {
+    return;
+  }
+
+  units.assign(tthis->units.constData() + 1,
+               tthis->units.constData() + 1 + n);
+  shuffle.resize(n);
+  for (int i = 0; i < n; i++) {
+    shuffle[i] = i;
+  }
+
+  std::shuffle(shuffle.begin(), shuffle.end(), fc_rand_state());
+
+  for (int i = 0; i < n; i++) {
+    tthis->units[i + 1] = units[shuffle[i]];
+  }
+}
+
+/**
+   Reverse the order of the units in the list.
+ */
+void unit_list_reverse(struct unit_list *tthis)
+{
+  fc_assert_ret(nullptr != tthis);
+
+  std::reverse(tthis->units.begin() + 1, tthis->units.end() - 1);
+}
+
 /**
    Look for a unit with the given ID in the unit list.  Returns nullptr if
    none is found.
@@ -11,24 +11,300 @@
 
 #pragma once
 
+// utility
+#include "log.h"
+#include "support.h" // fc__warn_unused_result
+
 #include "fc_types.h"
 #include "unit.h"     // for diplomat_actions
 #include "unittype.h" // for unit_type_flag_id
 
+// Qt
+#include <QVarLengthArray>
+
 #include <vector>
 
-// get 'struct unit_list' and related functions:
-#define SPECLIST_TAG unit
-#define SPECLIST_TYPE struct unit
-#include "speclist.h"
+/* 'struct unit_list' and related functions.
+
+   Unit lists have the interface of a speclist (see utility/speclist.h) but
+   store their units contiguously, with room for a few units in the list
+   itself, and have no mutex. A link is a pointer to a slot of the array:
+   unlike genlist links, it is invalidated by any change to the list.
+   unit_list_iterate() and unit_list_both_iterate() follow the next unit
+   when the loop body changes the list, as genlist iteration does. */
+
+// Number of units stored without allocating memory.
+#define UNIT_LIST_PREALLOC 4
+
+// Dummy type. Actually a 'struct unit *' in unit_list::units.
+struct unit_list_link;
+
+typedef void (*unit_list_free_fn_t)(struct unit *);
+typedef struct unit *(*unit_list_copy_fn_t)(const struct unit *);
+typedef bool (*unit_list_comp_fn_t)(const struct unit *,
+                                    const struct unit *);
+typedef bool (*unit_list_cond_fn_t)(const struct unit *);
+
+struct unit_list {
+  /* The units between two nullptr, so that a link can tell whether it is
+   * the first or the last one. */
+  QVarLengthArray<struct unit *, UNIT_LIST_PREALLOC + 2> units;
+  unit_list_free_fn_t free_data_func;
+};
+
+struct unit_list *unit_list_new() fc__warn_unused_result;
+struct unit_list *unit_list_new_full(unit_list_free_fn_t free_data_func)
+    fc__warn_unused_result;
+void unit_list_destroy(struct unit_list *tthis);
+struct unit_list *
+unit_list_copy(const struct unit_list *tthis) fc__warn_unused_result;
+struct unit_list *
+unit_list_copy_full(const struct unit_list *tthis,
+                    unit_list_copy_fn_t copy_data_func,
+                    unit_list_free_fn_t free_data_func)
+    fc__warn_unused_result;
+void unit_list_clear(struct unit_list *tthis);
+void unit_list_unique(struct unit_list *tthis);
+void unit_list_unique_full(struct unit_list *tthis,
+                           unit_list_comp_fn_t comp_data_func);
+void unit_list_insert(struct unit_list *tthis, struct unit *punit, int idx);
+void unit_list_insert_after(struct unit_list *tthis, struct unit *punit,
+                            struct unit_list_link *plink);
+void unit_list_insert_before(struct unit_list *tthis, struct unit *punit,
+                             struct unit_list_link *plink);
+bool unit_list_remove(struct unit_list *tthis, const struct unit *punit);
+bool unit_list_remove_if(struct unit_list *tthis,
+                         unit_list_cond_fn_t cond_data_func);
+int unit_list_remove_all(struct unit_list *tthis, const struct unit *punit);
+int unit_list_remove_all_if(struct unit_list *tthis,
+                            unit_list_cond_fn_t cond_data_func);
+void unit_list_erase(struct unit_list *tthis, struct unit_list_link *plink);
+void unit_list_pop_front(struct unit_list *tthis);
+void unit_list_pop_back(struct unit_list *tthis);
+struct unit_list_link *unit_list_search(const struct unit_list *tthis,
+                                        const struct unit *punit);
+struct unit_list_link *
+unit_list_search_if(const struct unit_list *tthis,
+                    unit_list_cond_fn_t cond_data_func);
+void unit_list_sort(struct unit_list *tthis,
+                    int (*compar)(const struct unit *const *,
+                                  const struct unit *const *));
+void unit_list_shuffle(struct unit_list *tthis);
+void unit_list_reverse(struct unit_list *tthis);
+
+/**
+   Push back a unit into the list.
+ */
+inline void unit_list_append(struct unit_list *tthis, struct unit *punit)
+{
+  fc_assert_ret(nullptr != tthis);
+  tthis->units.last() = punit;
+  tthis->units.append(nullptr);
+}
+
+/**
+   Push front a unit into the list.
+ */
+inline void unit_list_prepend(struct unit_list *tthis, struct unit *punit)
+{
+  fc_assert_ret(nullptr != tthis);
+  tthis->units.insert(1, punit);
+}
+
+/**
+   Return the number of units in the list.
+ */
+inline int unit_list_size(const struct unit_list *tthis)
+{
+  fc_assert_ret_val(nullptr != tthis, 0);
+  return tthis->units.size() - 2;
+}
+
+/**
+   Return the link at the given position, nullptr if out of range. -1 is
+   the last unit.
+ */
+inline struct unit_list_link *
+unit_list_link_get(const struct unit_list *tthis, int idx)
+{
+  fc_assert_ret_val(nullptr != tthis, nullptr);
+  if (-1 == idx) {
+    idx = unit_list_size(tthis) - 1;
+  }
+  if (0 > idx || idx >= unit_list_size(tthis)) {
+    return nullptr;
+  }
+  return reinterpret_cast<struct unit_list_link *>(
+      const_cast<struct unit **>(tthis->units.constData() + idx + 1));
+}
+
+/**
+   Return the head link of the list.
+ */
+inline struct unit_list_link *unit_list_head(const struct unit_list *tthis)
+{
+  return nullptr != tthis ? unit_list_link_get(tthis, 0) : nullptr;
+}
+
+/**
+   Return the tail link of the list.
+ */
+inline struct unit_list_link *unit_list_tail(const struct unit_list *tthis)
+{
+  return nullptr != tthis ? unit_list_link_get(tthis, -1) : nullptr;
+}
+
+/**
+   Return the unit of the link.
+ */
+inline struct unit *unit_list_link_data(const struct unit_list_link *plink)
+{
+  return nullptr != plink
+             ? *reinterpret_cast<struct unit *const *>(plink)
+             : nullptr;
+}
+
+/**
+   Return the previous link.
+ */
+fc__warn_unused_result inline struct unit_list_link *
+unit_list_link_prev(const struct unit_list_link *plink)
+{
+  auto slot = reinterpret_cast<struct unit *const *>(plink) - 1;
+
+  return nullptr != *slot ? reinterpret_cast<struct unit_list_link *>(
+             const_cast<struct unit **>(slot))
+                          : nullptr;
+}
+
+/**
+   Return the next link.
+ */
+fc__warn_unused_result inline struct unit_list_link *
+unit_list_link_next(const struct unit_list_link *plink)
+{
+  auto slot = reinterpret_cast<struct unit *const *>(plink) + 1;
+
+  return nullptr != *slot ? reinterpret_cast<struct unit_list_link *>(
+             const_cast<struct unit **>(slot))
+                          : nullptr;
+}
+
+/**
+   Return the unit at the given position in the list.
+ */
+inline struct unit *unit_list_get(const struct unit_list *tthis, int idx)
+{
+  return unit_list_link_data(unit_list_link_get(tthis, idx));
+}
+
+/**
+   Return the first unit of the list.
+ */
+inline struct unit *unit_list_front(const struct unit_list *tthis)
+{
+  return unit_list_link_data(unit_list_head(tthis));
+}
+
+/**
+   Return the last unit of the list.
+ */
+inline struct unit *unit_list_back(const struct unit_list *tthis)
+{
+  return unit_list_link_data(unit_list_tail(tthis));
+}
+
+/**
+   Iteration helper. 'last' is the unit returned previously at position
+   '*pos' (nullptr and -1 to start) and '*next' the unit that followed it
+   at that time. Moves '*pos' to that next unit, wherever the loop body
+   moved it, and returns it (nullptr at the end of the list).
+
+   As with genlist iteration, the body may remove the current unit, and
+   insert or remove any unit but the next one. If the next unit was removed
+   anyway, iteration resumes with the unit after the current one.
+ */
+inline struct unit *unit_list_iterate_next(const struct unit_list *tthis,
+                                           int *pos,
+                                           const struct unit *last,
+                                           const struct unit **next)
+{
+  int size, i = *pos;
+  struct unit *const *units;
+
+  if (nullptr == tthis) {
+    return nullptr;
+  }
+
+  size = tthis->units.size() - 2;
+  units = tthis->units.constData() + 1;
+  if (-1 == i) {
+    i = 0;
+  } else if (nullptr == *next) {
+    // The previous unit was the last one.
+    return nullptr;
+  } else if (i + 1 < size && units[i + 1] == *next) {
+    i++;
+  } else {
+    // Units were inserted or removed before the next one: look for it.
+    int j;
+
+    for (j = 0; j < size && units[j] != *next; j++) {
+      // Nothing.
+    }
+    if (j < size) {
+      i = j;
+    } else if (i < size && units[i] == last) {
+      // The next unit was removed, but not the current one.
+      i++;
+    }
+  }
+  *pos = i;
+  if (i >= size) {
+    return nullptr;
+  }
+  *next = i + 1 < size ? units[i + 1] : nullptr;
+
+  return units[i];
+}
+
+#ifdef FREECIV_DEBUG
+#define UNIT_LIST_CHECK(ARG_list)                                           \
+  fc_assert_action(nullptr != ARG_list, break)
+#else
+#define UNIT_LIST_CHECK(ARG_list) // Nothing.
+#endif // FREECIV_DEBUG
 
 #define unit_list_iterate(unitlist, punit)                                  \
-  TYPED_LIST_ITERATE(struct unit, unitlist, punit)
-#define unit_list_iterate_end LIST_ITERATE_END
+  do {                                                                      \
+    const struct unit_list *punit##_iter_list = (unitlist);                 \
+    const struct unit *punit##_iter_next = nullptr;                         \
+    struct unit *punit = nullptr;                                           \
+    int punit##_iter_pos = -1;                                              \
+    UNIT_LIST_CHECK(punit##_iter_list);                                     \
+    while (nullptr                                                          \
+           != (punit = unit_list_iterate_next(punit##_iter_list,            \
+                                              &punit##_iter_pos, punit,     \
+                                              &punit##_iter_next))) {
+#define unit_list_iterate_end                                               \
+  }                                                                         \
+  }                                                                         \
+  while (false)                                                             \
+    ;
 #define unit_list_both_iterate(unitlist, plink, punit)                      \
-  TYPED_LIST_BOTH_ITERATE(struct unit_list_link, struct unit, unitlist,     \
-                          plink, punit)
-#define unit_list_both_iterate_end LIST_BOTH_ITERATE_END
+  do {                                                                      \
+    const struct unit_list *punit##_iter_list = (unitlist);                 \
+    const struct unit *punit##_iter_next = nullptr;                         \
+    struct unit *punit = nullptr;                                           \
+    int punit##_iter_pos = -1;                                              \
+    UNIT_LIST_CHECK(punit##_iter_list);                                     \
+    while (nullptr                                                          \
+           != (punit = unit_list_iterate_next(punit##_iter_list,            \
+                                              &punit##_iter_pos, punit,     \
+                                              &punit##_iter_next))) {       \
+      struct unit_list_link *plink =                                        \
+          unit_list_link_get(punit##_iter_list, punit##_iter_pos);
+#define unit_list_both_iterate_end unit_list_iterate_end
 
 #define unit_list_iterate_safe(unitlist, _unit)                             \
   {                                                                         \
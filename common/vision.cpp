@@ -34,6 +34,10 @@ struct vision *vision_new(struct player *pplayer, struct tile *ptile)
   vision->radius_sq[V_MAIN] = -1;
   vision->radius_sq[V_INVIS] = -1;
   vision->radius_sq[V_SUBSURFACE] = -1;
+  vision->except_tile = nullptr;
+  vision->except_radius_sq[V_MAIN] = -1;
+  vision->except_radius_sq[V_INVIS] = -1;
+  vision->except_radius_sq[V_SUBSURFACE] = -1;
 
   return vision;
 }
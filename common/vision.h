@@ -64,6 +64,15 @@
   note that for all the code in the middle both the new and the old
   vision sources are active.  The same process applies when transferring
   a unit or city between players, etc.
+
+  When the new source belongs to the same player, vision_move_sight may be
+  used instead of vision_change_sight to fill it out.  It only counts the
+  sight points of the tiles the old source does not already see; the old
+  source hands the other ones over, and clearing it later only removes
+  the tiles that the new source does not see.  The whole circle is still
+  walked, with a distance check per tile, but the seen counts, fogging and
+  unit notifications are only updated for the tiles entering and leaving
+  the sight, which are the expensive part of moving a unit.
 ****************************************************************************/
 
 /* Invariants: V_MAIN vision ranges must always be more than V_INVIS
@@ -88,6 +97,12 @@ struct vision {
 
   // The radius of the vision source.
   v_radius_t radius_sq;
+
+  /* Set by vision_move_sight(): the sight points within except_radius_sq
+   * of except_tile were handed over to another vision source. The tiles
+   * there are still visited when the sight changes, but left alone. */
+  struct tile *except_tile;
+  v_radius_t except_radius_sq;
 };
 
 // Initialize a vision radius array.
@@ -39,6 +39,7 @@
 #include "advbuilding.h"
 #include "advcity.h"
 #include "advtools.h"
+#include "autoexplorer.h"
 
 // ai
 #include "handicaps.h"
@@ -745,6 +746,7 @@ void adv_data_close(struct player *pplayer)
   fc_assert_ret(nullptr != adv);
 
   adv_data_phase_done(pplayer);
+  explorer_fields_free(pplayer);
 
   delete[] adv->government_want;
   adv->government_want = nullptr;
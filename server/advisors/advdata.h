@@ -9,6 +9,8 @@
 **************************************************************************/
 #pragma once
 
+#include <vector>
+
 // utility
 #include "bitvector.h"
 #include "support.h" // bool type
@@ -26,6 +28,8 @@
  * start of every turn.
  */
 
+struct explorer_field;
+
 enum adv_improvement_status {
   ADV_IMPR_CALCULATE,      // Calculate exactly its effect
   ADV_IMPR_CALCULATE_FULL, // Calculate including tile changes
@@ -65,6 +69,8 @@ struct adv_data {
     bool *continent; // are we done exploring this continent?
     bool land_done;  // nothing more on land to explore anywhere
     bool sea_done;   // nothing more to explore at sea
+    // Unknown tiles around each tile, see autoexplorer.cpp
+    std::vector<struct explorer_field *> fields;
   } explore;
 
   /* This struct is used for statistical unit building, eg to ensure
@@ -10,8 +10,10 @@
  */
 
 #include <cmath> // log
+#include <vector>
 
 // utility
+#include "bitvector.h"
 #include "log.h"
 
 // common
@@ -30,6 +32,7 @@
 #include "srv_log.h"
 
 /* server/advisors */
+#include "advdata.h"
 #include "advgoto.h"
 
 // ai
@@ -194,12 +197,176 @@ static bool explorer_goto(struct unit *punit, struct tile *ptile)
 
 #define BEST_POSSIBLE_SCORE (HUT_SCORE + BEST_NORMAL_TILE)
 
+/* The score of the unknown tiles around every tile of the map, as seen by
+ * the units of a player with a given class and vision radius. It is kept
+ * up to date incrementally: only the tiles around those whose known status
+ * or terrain changed are updated. */
+struct explorer_field {
+  struct unit_class *pclass;
+  int radius_sq;
+  QBitArray known;          // player's tile_known at the last update
+  std::vector<int> value;   // score of each tile on its own
+  std::vector<int> score;   // sum of 'value' over the vision circle
+};
+
+/**
+   Returns the score an unknown tile adds to the tiles it can be seen from,
+   or 0 if the tile is known. This is never 0 for unknown tiles.
+ */
+static int explorer_tile_value(struct tile *ptile, struct player *pplayer,
+                               struct unit_class *pclass)
+{
+  int native;
+
+  if (map_is_known(ptile, pplayer)) {
+    return 0;
+  }
+
+  native = likely_native(ptile, pplayer, pclass);
+  return native * SAME_TER_SCORE + (100 - native) * DIFF_TER_SCORE;
+}
+
+/**
+   Recalculates the value of the tile, and updates the score of the tiles
+   it can be seen from.
+ */
+static void explorer_field_refresh(struct explorer_field *field,
+                                   struct player *pplayer,
+                                   struct tile *ptile)
+{
+  int index = tile_index(ptile);
+  int delta = explorer_tile_value(ptile, pplayer, field->pclass)
+              - field->value[index];
+
+  if (delta == 0) {
+    return;
+  }
+  field->value[index] += delta;
+  circle_iterate(&(wld.map), ptile, field->radius_sq, pcenter)
+  {
+    field->score[tile_index(pcenter)] += delta;
+  }
+  circle_iterate_end;
+}
+
+/**
+   Brings the field up to date with what the player knows of the map.
+ */
+static void explorer_field_sync(struct explorer_field *field,
+                                struct player *pplayer)
+{
+  QBitArray known = *pplayer->tile_known;
+
+  if (known.size() != MAP_INDEX_SIZE) {
+    // Nothing is known.
+    known = QBitArray(MAP_INDEX_SIZE);
+  }
+
+  if (field->known.size() != known.size()) {
+    // First use, or the map has changed.
+    field->value.assign(MAP_INDEX_SIZE, 0);
+    field->score.assign(MAP_INDEX_SIZE, 0);
+    whole_map_iterate(&(wld.map), ptile)
+    {
+      explorer_field_refresh(field, pplayer, ptile);
+    }
+    whole_map_iterate_end;
+  } else {
+    /* The value of a tile depends on whether it is known, and on the number
+     * of known tiles next to it. */
+    bitarray_iterate(known ^ field->known, [field, pplayer](int tindex) {
+      struct tile *ptile = index_to_tile(&(wld.map), tindex);
+
+      explorer_field_refresh(field, pplayer, ptile);
+      adjc_iterate(&(wld.map), ptile, padjc)
+      {
+        explorer_field_refresh(field, pplayer, padjc);
+      }
+      adjc_iterate_end;
+    });
+  }
+
+  field->known = known;
+}
+
+/**
+   Returns the up to date field for units of the given class and vision
+   radius owned by the player, creating it on first use.
+ */
+static struct explorer_field *explorer_field_get(struct player *pplayer,
+                                                 struct unit_class *pclass,
+                                                 int radius_sq)
+{
+  struct adv_data *adv = pplayer->server.adv;
+  struct explorer_field *field = nullptr;
+
+  for (auto *pfield : adv->explore.fields) {
+    if (pfield->pclass == pclass && pfield->radius_sq == radius_sq) {
+      field = pfield;
+      break;
+    }
+  }
+  if (field == nullptr) {
+    field = new explorer_field;
+    field->pclass = pclass;
+    field->radius_sq = radius_sq;
+    adv->explore.fields.push_back(field);
+  }
+
+  explorer_field_sync(field, pplayer);
+
+  return field;
+}
+
+/**
+   Updates the explorer fields of all players after the terrain or extras
+   of the tile changed, since that can change whether it is native. The
+   value of an unknown tile is guessed from the tiles next to it, so they
+   are updated as well.
+ */
+void explorer_tile_changed(struct tile *ptile)
+{
+  players_iterate(pplayer)
+  {
+    if (pplayer->server.adv == nullptr) {
+      continue;
+    }
+    for (auto *field : pplayer->server.adv->explore.fields) {
+      if (field->known.size() != MAP_INDEX_SIZE) {
+        continue;
+      }
+      explorer_field_refresh(field, pplayer, ptile);
+      adjc_iterate(&(wld.map), ptile, padjc)
+      {
+        explorer_field_refresh(field, pplayer, padjc);
+      }
+      adjc_iterate_end;
+    }
+  }
+  players_iterate_end;
+}
+
+/**
+   Frees the explorer fields of the player.
+ */
+void explorer_fields_free(struct player *pplayer)
+{
+  for (auto *field : pplayer->server.adv->explore.fields) {
+    delete field;
+  }
+  pplayer->server.adv->explore.fields.clear();
+}
+
+/**
+   Returns how desirable it is for the unit to explore the tile, see above.
+   The score of the unknown tiles in sight is read from 'field'.
+ */
 static int explorer_desirable(struct tile *ptile, struct player *pplayer,
-                              struct unit *punit)
+                              struct unit *punit,
+                              const struct explorer_field *field)
 {
-  int radius_sq = unit_type_get(punit)->vision_radius_sq;
-  int desirable = 0;
-  int unknown = 0;
+  int radius_sq = field->radius_sq;
+  int desirable;
 
   /* First do some checks that would make a tile completely non-desirable.
    * If we're a barbarian and the tile has a hut, don't go there. */
@@ -213,35 +380,27 @@ static int explorer_desirable(struct tile *ptile, struct player *pplayer,
     return 0;
   }
 
-  circle_iterate(&(wld.map), ptile, radius_sq, ptile1)
-  {
-    int native = likely_native(ptile1, pplayer, unit_class_get(punit));
-
-    if (!map_is_known(ptile1, pplayer)) {
-      unknown++;
-
-      /* FIXME: we should add OWN_CITY_SCORE to desirable if the tile
-       * can be harvested by a city of ours. Just calculating this each
-       * time becomes rather expensive. Jason Short suggests:
-       * It should be easy to generate this information once, for
-       * the entire world.  It can be used by everyone and only
-       * sometimes needs to be recalculated (actually all changes
-       * only require local recalculation, but that could be unstable). */
-
-      desirable +=
-          (native * SAME_TER_SCORE + (100 - native) * DIFF_TER_SCORE);
-    } else {
-      if (is_tiles_adjacent(ptile, ptile1)) {
+  /* FIXME: we should add OWN_CITY_SCORE to desirable if an unknown tile
+   * can be harvested by a city of ours. This could be kept in the field
+   * as well. */
+  desirable = field->score[tile_index(ptile)];
+
+  if (desirable > 0) {
+    adjc_iterate(&(wld.map), ptile, ptile1)
+    {
+      if (sq_map_distance(ptile, ptile1) <= radius_sq
+          && map_is_known(ptile1, pplayer)) {
+        int native =
+            is_native_tile_to_class(unit_class_get(punit), ptile1) ? 100 : 0;
+
         /* we don't value staying offshore from land,
          * only adjacent. Otherwise destroyers do the wrong thing. */
         desirable += (native * KNOWN_SAME_TER_SCORE
                       + (100 - native) * KNOWN_DIFF_TER_SCORE);
       }
     }
-  }
-  circle_iterate_end;
-
-  if (unknown <= 0) {
+    adjc_iterate_end;
+  } else {
     // We make sure we'll uncover at least one unexplored tile.
     desirable = 0;
   }
@@ -291,6 +450,7 @@ enum unit_move_result manage_auto_explorer(struct unit *punit)
   // Path-finding stuff
   struct pf_map *pfm;
   struct pf_parameter parameter;
+  struct explorer_field *field;
 
 #define DIST_FACTOR 0.6
 
@@ -306,6 +466,9 @@ enum unit_move_result manage_auto_explorer(struct unit *punit)
 
   TIMING_LOG(AIT_EXPLORER, TIMER_START);
 
+  field = explorer_field_get(pplayer, unit_class_get(punit),
+                             unit_type_get(punit)->vision_radius_sq);
+
   pft_fill_unit_parameter(&parameter, punit);
   parameter.get_TB = no_fights_or_unknown;
   // When exploring, even AI should pretend to not cheat.
@@ -320,7 +483,7 @@ enum unit_move_result manage_auto_explorer(struct unit *punit)
     // Our callback should insure this.
     fc_assert_action(map_is_known(ptile, pplayer), continue);
 
-    desirable = explorer_desirable(ptile, pplayer, punit);
+    desirable = explorer_desirable(ptile, pplayer, punit, field);
 
     if (desirable <= 0) {
       // Totally non-desirable tile. No need to continue.
@@ -12,6 +12,10 @@
 **************************************************************************/
 #pragma once
 
+struct player;
+struct tile;
 struct unit;
 
 enum unit_move_result manage_auto_explorer(struct unit *punit);
+void explorer_tile_changed(struct tile *ptile);
+void explorer_fields_free(struct player *pplayer);
@@ -12,6 +12,10 @@
       \____/        ********************************************************/
 
 #include <QBitArray>
+#include <QVector>
+
+#include <algorithm>
+#include <vector>
 
 #include "bitvector.h"
 #include "fcintl.h"
@@ -43,6 +47,7 @@
 #include "vision.h"
 
 /* common/aicore */
+#include "caravan.h"
 #include "cm.h"
 
 /* common/scriptcore */
@@ -83,6 +88,28 @@ static struct city_list *arrange_workers_queue = nullptr;
 // Suppress sending cities during game_load() and end_phase()
 static bool send_city_suppressed = false;
 
+/* The parts of the city info packet that are kept between two calls to
+ * package_city(), see enum city_info_part. */
+struct city_info_cache {
+  std::vector<int> nation_id;
+  std::vector<citizens> nation_citizens;
+  bv_imprs improvements;
+
+  // The trade route packets last broadcast to the owner.
+  std::vector<struct packet_traderoute_info> routes;
+  const struct player *routes_owner;
+};
+
+// Counters of the city info work saved, reset at each turn end.
+static struct {
+  int packed;
+  int parts_reused;
+  int routes_skipped;
+} city_info_stats;
+
+// Upper bound of the size of a traderoute_info packet on the wire.
+#define TRADEROUTE_INFO_WIRE_SIZE 16
+
 static bool city_workers_queue_remove(struct city *pcity);
 
 static void announce_trade_route_removal(struct city *pc1, struct city *pc2,
@@ -174,11 +201,33 @@ void city_thaw_workers_queue()
     return;
   }
 
-  city_list_iterate(arrange_workers_queue, pcity)
-  {
-    city_thaw_workers(pcity);
+  if (game.server.threaded_arrange) {
+    struct city_list *arrange = city_list_new();
+
+    city_list_iterate(arrange_workers_queue, pcity)
+    {
+      if (pcity->server.workers_frozen == 1
+          && pcity->server.needs_arrange) {
+        /* Same as city_thaw_workers(), but the arrangement is done for
+         * all the cities at once. */
+        pcity->server.workers_frozen--;
+        city_refresh(pcity); // Citizen count sanity
+        city_list_append(arrange, pcity);
+      } else {
+        city_thaw_workers(pcity);
+      }
+    }
+    city_list_iterate_end;
+
+    auto_arrange_workers_list(arrange);
+    city_list_destroy(arrange);
+  } else {
+    city_list_iterate(arrange_workers_queue, pcity)
+    {
+      city_thaw_workers(pcity);
+    }
+    city_list_iterate_end;
   }
-  city_list_iterate_end;
 
   city_list_destroy(arrange_workers_queue);
   arrange_workers_queue = nullptr;
@@ -1191,6 +1240,7 @@ bool transfer_city(struct player *ptaker, struct city *pcity,
 
   pcity->owner = ptaker;
   pcity->capital = CAPITAL_NOT;
+  caravan_search_cache_clear();
   // Recover half of HP
   pcity->hp = city_max_hp(pcity) / 2;
   map_claim_ownership(pcenter, ptaker, pcenter, true);
@@ -1542,6 +1592,7 @@ void create_city(struct player *pplayer, struct tile *ptile,
   game.server.mutexes.city_list->lock();
   idex_register_city(&wld, pcity);
   game.server.mutexes.city_list->unlock();
+  caravan_search_cache_clear();
 
   if (city_list_size(pplayer->cities) == 0) {
     /* Free initial buildings, or at least a palace if they were
@@ -1656,7 +1707,7 @@ void create_city(struct player *pplayer, struct tile *ptile,
 
   sanity_check_city(pcity);
 
-  script_server_signal_emit("city_built", pcity);
+  script_server_signal_emit_id(SCRIPT_SIGNAL_CITY_BUILT, pcity);
 
   CALL_FUNC_EACH_AI(city_created, pcity);
   CALL_PLR_AI_FUNC(city_got, pplayer, pplayer, pcity);
@@ -1850,6 +1901,7 @@ void remove_city(struct city *pcity)
   pcity->server.vision = nullptr;
   script_server_remove_exported_object(pcity);
   adv_city_free(pcity);
+  city_info_cache_free(pcity);
 
   // Remove city from the map.
   tile_set_worked(pcenter, nullptr);
@@ -1874,6 +1926,7 @@ void remove_city(struct city *pcity)
   game.server.mutexes.city_list->lock();
   game_remove_city(&wld, pcity);
   game.server.mutexes.city_list->unlock();
+  caravan_search_cache_clear();
 
   // Remove any extras that were only there because the city was there.
   extra_type_iterate(pextra)
@@ -2181,6 +2234,94 @@ void refresh_dumb_city(struct city *pcity)
    * information. */
 }
 
+/**
+   Returns the city info cache of the city, creating it if needed. All of
+   it is dirty when it is created.
+ */
+static struct city_info_cache *city_info_cache_get(struct city *pcity)
+{
+  if (pcity->server.info_cache == nullptr) {
+    pcity->server.info_cache = new city_info_cache();
+    pcity->server.info_dirty = CITY_INFO_CITIZENS | CITY_INFO_IMPROVEMENTS;
+  }
+
+  return pcity->server.info_cache;
+}
+
+/**
+   Frees the city info cache of the city.
+ */
+void city_info_cache_free(struct city *pcity)
+{
+  delete pcity->server.info_cache;
+  pcity->server.info_cache = nullptr;
+}
+
+/**
+   Returns whether the trade route packets differ from the ones last
+   broadcast to the owner of the city.
+ */
+static bool city_info_routes_changed(struct city *pcity,
+                                     struct traderoute_packet_list *routes)
+{
+  struct city_info_cache *cache = city_info_cache_get(pcity);
+  size_t i = 0;
+
+  if (cache->routes_owner != city_owner(pcity)
+      || cache->routes.size()
+             != static_cast<size_t>(traderoute_packet_list_size(routes))) {
+    return true;
+  }
+
+  traderoute_packet_list_iterate(routes, route_packet)
+  {
+    const struct packet_traderoute_info &sent = cache->routes[i++];
+
+    if (sent.index != route_packet->index
+        || sent.partner != route_packet->partner
+        || sent.value != route_packet->value
+        || sent.direction != route_packet->direction
+        || sent.goods != route_packet->goods) {
+      return true;
+    }
+  }
+  traderoute_packet_list_iterate_end;
+
+  return false;
+}
+
+/**
+   Remembers the trade route packets just broadcast to the owner of the
+   city.
+ */
+static void city_info_routes_sent(struct city *pcity,
+                                  struct traderoute_packet_list *routes)
+{
+  struct city_info_cache *cache = city_info_cache_get(pcity);
+
+  cache->routes.clear();
+  traderoute_packet_list_iterate(routes, route_packet)
+  {
+    cache->routes.push_back(*route_packet);
+  }
+  traderoute_packet_list_iterate_end;
+  cache->routes_owner = city_owner(pcity);
+}
+
+/**
+   Logs how much of the city info work was saved during the turn, and
+   resets the counters.
+ */
+void city_info_turn_stats()
+{
+  qDebug("City info: %d packed, %d parts reused, %d route packets "
+         "(about %d bytes) not sent",
+         city_info_stats.packed, city_info_stats.parts_reused,
+         city_info_stats.routes_skipped,
+         city_info_stats.routes_skipped * TRADEROUTE_INFO_WIRE_SIZE);
+  city_info_stats = {};
+}
+
 /**
    Broadcast info about a city to all players who observe the tile.
    If the player can see the city we update the city info first.
@@ -2195,20 +2336,32 @@ static void broadcast_city_info(struct city *pcity)
   struct packet_city_short_info sc_pack;
   struct player *powner = city_owner(pcity);
   struct traderoute_packet_list *routes = traderoute_packet_list_new();
+  bool send_routes;
 
   // Send to everyone who can see the city.
   package_city(pcity, &packet, routes, false);
+  send_routes = city_info_routes_changed(pcity, routes);
+  /* This does not walk the sites of map_get_player_sites():
+   * player_can_see_city_externals() is always true, so every player gets
+   * the city and the index could not narrow the loop. */
   players_iterate(pplayer)
   {
     if (can_player_see_city_internals(pplayer, pcity)) {
       if (!send_city_suppressed || pplayer != powner) {
         update_dumb_city(powner, pcity);
         lsend_packet_city_info(powner->connections, &packet, false);
-        traderoute_packet_list_iterate(routes, route_packet)
-        {
-          lsend_packet_traderoute_info(powner->connections, route_packet);
+        if (send_routes) {
+          traderoute_packet_list_iterate(routes, route_packet)
+          {
+            lsend_packet_traderoute_info(powner->connections,
+                                         route_packet);
+          }
+          traderoute_packet_list_iterate_end;
+          city_info_routes_sent(pcity, routes);
+        } else {
+          city_info_stats.routes_skipped +=
+              traderoute_packet_list_size(routes);
         }
-        traderoute_packet_list_iterate_end;
       }
     } else {
       if (player_can_see_city_externals(pplayer, pcity)) {
@@ -2242,6 +2395,9 @@ static void broadcast_city_info(struct city *pcity)
 /**
    Send to each client information about the cities it knows about.
    dest may not be nullptr
+
+   Players only get the sites of their private map (see
+   map_get_player_sites()), observers the real cities.
  */
 void send_all_known_cities(struct conn_list *dest)
 {
@@ -2253,13 +2409,23 @@ void send_all_known_cities(struct conn_list *dest)
     if (!pplayer && !pconn->observer) {
       continue;
     }
-    whole_map_iterate(&(wld.map), ptile)
-    {
-      if (!pplayer || nullptr != map_get_player_site(ptile, pplayer)) {
-        send_city_info_at_tile(pplayer, pconn->self, nullptr, ptile);
+    if (!pplayer) {
+      cities_iterate(pcity)
+      {
+        send_city_info_at_tile(nullptr, pconn->self, pcity,
+                               city_tile(pcity));
       }
+      cities_iterate_end;
+      continue;
+    }
+
+    /* send_city_info_at_tile() may remove an outdated site: iterate over a
+     * copy. */
+    const std::set<int> sites = map_get_player_sites(pplayer);
+    for (int tindex : sites) {
+      send_city_info_at_tile(pplayer, pconn->self, nullptr,
+                             index_to_tile(&(wld.map), tindex));
     }
-    whole_map_iterate_end;
   }
   conn_list_iterate_end;
   conn_list_do_unbuffer(dest);
@@ -2269,25 +2435,42 @@ void send_all_known_cities(struct conn_list *dest)
 /**
    Send to each client information about the buildings it owns.
    dest may not be nullptr
+
+   The building list of each player in dest is rebuilt from a single pass
+   over the buildings of the map.
  */
 void send_all_known_buildings(struct conn_list *dest)
 {
+  QVector<struct building *> by_username[256];
+  bv_player done;
+
+  building_list_iterate(wld.map.buildings, pbuilding)
+  {
+    by_username[static_cast<unsigned char>(pbuilding->username)].append(
+        pbuilding);
+  }
+  building_list_iterate_end;
+
+  BV_CLR_ALL(done);
   conn_list_do_buffer(dest);
   conn_list_iterate(dest, pconn)
   {
     struct player *pplayer = pconn->playing;
 
-    if (!pplayer || pconn->observer) {
+    if (!pplayer || pconn->observer
+        || BV_ISSET(done, player_index(pplayer))) {
       continue;
     }
-    building_list_iterate(wld.map.buildings, pbuilding)
-    {
-      if (pplayer->username[0] == pbuilding->username) {
-        send_building_info(pplayer, pbuilding);
-        building_list_append(pplayer->buildings, pbuilding);
-      }
+    BV_SET(done, player_index(pplayer));
+
+    const auto &owned =
+        by_username[static_cast<unsigned char>(pplayer->username[0])];
+
+    building_list_clear(pplayer->buildings);
+    for (auto *pbuilding : owned) {
+      send_building_info(pplayer, pbuilding);
+      building_list_append(pplayer->buildings, pbuilding);
     }
-    building_list_iterate_end;
   }
   conn_list_iterate_end;
   conn_list_do_unbuffer(dest);
@@ -2489,9 +2672,12 @@ void send_city_info_at_tile(struct player *pviewer, struct conn_list *dest,
 void package_city(struct city *pcity, struct packet_city_info *packet,
                   struct traderoute_packet_list *routes, bool dipl_invest)
 {
+  struct city_info_cache *cache = city_info_cache_get(pcity);
   int i;
   int ppl = 0;
 
+  city_info_stats.packed++;
+
   packet->id = pcity->id;
   packet->owner = player_number(city_owner(pcity));
   packet->tile = tile_index(city_tile(pcity));
@@ -2521,7 +2707,15 @@ void package_city(struct city *pcity, struct packet_city_info *packet,
 
   // The nationality of the citizens.
   packet->nationalities_count = 0;
-  if (game.info.citizen_nationality) {
+  if (game.info.citizen_nationality
+      && !(pcity->server.info_dirty & CITY_INFO_CITIZENS)) {
+    packet->nationalities_count = cache->nation_id.size();
+    std::copy(cache->nation_id.begin(), cache->nation_id.end(),
+              packet->nation_id);
+    std::copy(cache->nation_citizens.begin(), cache->nation_citizens.end(),
+              packet->nation_citizens);
+    city_info_stats.parts_reused++;
+  } else if (game.info.citizen_nationality) {
     int cit = 0;
 
     player_slots_iterate(pslot)
@@ -2542,6 +2736,14 @@ void package_city(struct city *pcity, struct packet_city_info *packet,
     player_slots_iterate_end;
 
     fc_assert(cit == packet->size);
+
+    cache->nation_id.assign(packet->nation_id,
+                            packet->nation_id
+                                + packet->nationalities_count);
+    cache->nation_citizens.assign(packet->nation_citizens,
+                                  packet->nation_citizens
+                                      + packet->nationalities_count);
+    pcity->server.info_dirty &= ~CITY_INFO_CITIZENS;
   }
 
   packet->history = pcity->history;
@@ -2671,14 +2873,22 @@ void package_city(struct city *pcity, struct packet_city_info *packet,
     memset(&packet->cm_parameter, 0, sizeof(packet->cm_parameter));
   }
 
-  BV_CLR_ALL(packet->improvements);
-  improvement_iterate(pimprove)
-  {
-    if (city_has_building(pcity, pimprove)) {
-      BV_SET(packet->improvements, improvement_index(pimprove));
+  if (!(pcity->server.info_dirty & CITY_INFO_IMPROVEMENTS)) {
+    packet->improvements = cache->improvements;
+    city_info_stats.parts_reused++;
+  } else {
+    BV_CLR_ALL(packet->improvements);
+    improvement_iterate(pimprove)
+    {
+      if (city_has_building(pcity, pimprove)) {
+        BV_SET(packet->improvements, improvement_index(pimprove));
+      }
     }
+    improvement_iterate_end;
+
+    cache->improvements = packet->improvements;
+    pcity->server.info_dirty &= ~CITY_INFO_IMPROVEMENTS;
   }
-  improvement_iterate_end;
 }
 
 /**
@@ -2720,7 +2930,7 @@ bool update_dumb_city(struct player *pplayer, struct city *pcity)
 
   if (nullptr == pdcity) {
     pdcity = vision_site_new_from_city(pcity);
-    change_playertile_site(map_get_player_tile(pcenter, pplayer), pdcity);
+    map_set_player_site(pcenter, pplayer, pdcity);
   } else if (pdcity->location != pcenter) {
     qCritical("Trying to update bad city (wrong location) "
               "at %i,%i for player %s",
@@ -2772,12 +2982,8 @@ void reality_check_city(struct player *pplayer, struct tile *ptile)
     struct city *pcity = tile_city(ptile);
 
     if (!pcity || pcity->id != pdcity->identity) {
-      struct player_tile *playtile = map_get_player_tile(ptile, pplayer);
-
       dlsend_packet_city_remove(pplayer->connections, pdcity->identity);
-      fc_assert_ret(playtile->site == pdcity);
-      playtile->site = nullptr;
-      vision_site_destroy(pdcity);
+      map_set_player_site(ptile, pplayer, nullptr);
     }
   }
 }
@@ -2790,12 +2996,8 @@ void remove_dumb_city(struct player *pplayer, struct tile *ptile)
   struct vision_site *pdcity = map_get_player_city(ptile, pplayer);
 
   if (pdcity) {
-    struct player_tile *playtile = map_get_player_tile(ptile, pplayer);
-
     dlsend_packet_city_remove(pplayer->connections, pdcity->identity);
-    fc_assert_ret(playtile->site == pdcity);
-    playtile->site = nullptr;
-    vision_site_destroy(pdcity);
+    map_set_player_site(ptile, pplayer, nullptr);
   }
 }
 
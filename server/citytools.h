@@ -53,6 +53,8 @@ void send_all_known_buildings(struct conn_list *dest);
 void send_player_cities(struct player *pplayer);
 void package_city(struct city *pcity, struct packet_city_info *packet,
                   struct traderoute_packet_list *routes, bool dipl_invest);
+void city_info_cache_free(struct city *pcity);
+void city_info_turn_stats();
 
 void send_building_info(struct player *dest, struct building *pbuilding);
 void send_player_buildings(struct player *pplayer);
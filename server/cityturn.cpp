@@ -14,6 +14,11 @@
 #include <cmath> // exp, sqrt
 #include <cstring>
 
+// Qt
+#include <QHash>
+#include <QMap>
+#include <QThreadPool>
+
 // utility
 #include "fcintl.h"
 #include "log.h"
@@ -74,6 +79,9 @@
 // Queue for pending city_refresh()
 static struct city_list *city_refresh_queue = nullptr;
 
+// Worker threads for auto_arrange_workers_list()
+Q_GLOBAL_STATIC(QThreadPool, arrange_pool)
+
 /* The game is currently considering to remove the listed units because of
  * missing gold upkeep. A unit ends up here if it has gold upkeep that
  * can't be payed. A random unit in the list will be removed until the
@@ -207,16 +215,44 @@ void city_refresh_queue_processing()
     return;
   }
 
-  city_list_iterate(city_refresh_queue, pcity)
-  {
-    if (pcity->server.needs_refresh) {
-      if (city_refresh(pcity)) {
-        auto_arrange_workers(pcity);
+  if (game.server.threaded_arrange) {
+    struct city_list *refreshed = city_list_new();
+    struct city_list *arrange = city_list_new();
+
+    // Refresh everything first, so the arrangements can run together
+    city_list_iterate(city_refresh_queue, pcity)
+    {
+      if (pcity->server.needs_refresh) {
+        city_list_append(refreshed, pcity);
+        if (city_refresh(pcity)) {
+          city_list_append(arrange, pcity);
+        }
       }
+    }
+    city_list_iterate_end;
+
+    auto_arrange_workers_list(arrange);
+
+    city_list_iterate(refreshed, pcity)
+    {
       send_city_info(city_owner(pcity), pcity);
     }
+    city_list_iterate_end;
+
+    city_list_destroy(arrange);
+    city_list_destroy(refreshed);
+  } else {
+    city_list_iterate(city_refresh_queue, pcity)
+    {
+      if (pcity->server.needs_refresh) {
+        if (city_refresh(pcity)) {
+          auto_arrange_workers(pcity);
+        }
+        send_city_info(city_owner(pcity), pcity);
+      }
+    }
+    city_list_iterate_end;
   }
-  city_list_iterate_end;
 
   city_list_destroy(city_refresh_queue);
   city_refresh_queue = nullptr;
@@ -354,20 +390,11 @@ static void set_default_city_manager(struct cm_parameter *cmp,
 }
 
 /**
-   Call sync_cities() to send the affected cities to the clients.
+   Get the city ready for a CM query and fill in the parameter to use.
  */
-void auto_arrange_workers(struct city *pcity)
+static void arrange_workers_prepare(struct city *pcity,
+                                    struct cm_parameter *cmp)
 {
-  struct cm_parameter cmp;
-
-  /* See comment in freeze_workers(): we can't rearrange while
-   * workers are frozen (i.e. multiple updates need to be done). */
-  if (pcity->server.workers_frozen > 0) {
-    pcity->server.needs_arrange = true;
-    return;
-  }
-  TIMING_LOG(AIT_CITIZEN_ARRANGE, TIMER_START);
-
   /* Freeze the workers and make sure all the tiles around the city
    * are up to date.  Then thaw, but hackishly make sure that thaw
    * doesn't call us recursively, which would waste time. */
@@ -384,36 +411,41 @@ void auto_arrange_workers(struct city *pcity)
 
   sanity_check_city(pcity);
 
-  cm_init_parameter(&cmp);
+  cm_init_parameter(cmp);
 
   if (pcity->cm_parameter) {
-    cm_copy_parameter(&cmp, pcity->cm_parameter);
+    cm_copy_parameter(cmp, pcity->cm_parameter);
   } else {
-    set_default_city_manager(&cmp, pcity);
+    set_default_city_manager(cmp, pcity);
   }
+}
 
-  /* This must be after city_refresh() so that the result gets created for
-   * the right city radius */
-  auto cmr = cm_result_new(pcity);
-  cm_query_result(pcity, &cmp, cmr, false);
+/**
+   Run the CM on the city, relaxing the parameter until some valid result
+   is found. Only the city itself is touched and nothing is logged, so
+   this may run on a worker thread. Returns TRUE if the player-defined
+   parameter of the city could not be fulfilled. '*emergency' is set when
+   only the emergency parameter gave a result.
+ */
+static bool arrange_workers_query(struct city *pcity,
+                                  struct cm_parameter *cmp,
+                                  std::unique_ptr<cm_result> &cmr,
+                                  bool *emergency)
+{
+  bool player_param_failed = false;
+
+  /* The lattice is shared by all the retries below. */
+  struct cm_state *cms = cm_state_init(pcity, false);
+  cm_state_query(cms, cmp, cmr, false);
 
   if (!cmr->found_a_valid) {
-    if (pcity->cm_parameter) {
-      // If player-defined parameters fail, cancel and notify player.
-      delete pcity->cm_parameter;
-      pcity->cm_parameter = nullptr;
+    player_param_failed = (pcity->cm_parameter != nullptr);
 
-      notify_player(city_owner(pcity), city_tile(pcity), E_CITY_CMA_RELEASE,
-                    ftc_server,
-                    _("The citizen governor can't fulfill the requirements "
-                      "for %s. Passing back control."),
-                    city_link(pcity));
-    }
     // Drop surpluses and try again.
-    cmp.minimal_surplus[O_FOOD] = 0;
-    cmp.minimal_surplus[O_SHIELD] = 0;
-    cmp.minimal_surplus[O_GOLD] = -FC_INFINITY;
-    cm_query_result(pcity, &cmp, cmr, false);
+    cmp->minimal_surplus[O_FOOD] = 0;
+    cmp->minimal_surplus[O_SHIELD] = 0;
+    cmp->minimal_surplus[O_GOLD] = -FC_INFINITY;
+    cm_state_query(cms, cmp, cmr, false);
   }
   if (!cmr->found_a_valid) {
     /* Emergency management.  Get _some_ result.  This doesn't use
@@ -421,18 +453,44 @@ void auto_arrange_workers(struct city *pcity)
      * above. */
     output_type_iterate(o)
     {
-      cmp.minimal_surplus[o] =
-          MIN(cmp.minimal_surplus[o], MIN(pcity->surplus[o], 0));
+      cmp->minimal_surplus[o] =
+          MIN(cmp->minimal_surplus[o], MIN(pcity->surplus[o], 0));
     }
     output_type_iterate_end;
-    cmp.require_happy = false;
-    cmp.allow_disorder = !is_ai(city_owner(pcity));
-    cm_query_result(pcity, &cmp, cmr, false);
+    cmp->require_happy = false;
+    cmp->allow_disorder = !is_ai(city_owner(pcity));
+    cm_state_query(cms, cmp, cmr, false);
   }
-  if (!cmr->found_a_valid) {
+  *emergency = !cmr->found_a_valid;
+  if (*emergency) {
+    cm_init_emergency_parameter(cmp);
+    cm_state_query(cms, cmp, cmr, true);
+  }
+  cm_state_free(cms);
+
+  return player_param_failed;
+}
+
+/**
+   Apply the result of arrange_workers_query() to the city.
+ */
+static void arrange_workers_apply(struct city *pcity,
+                                  const std::unique_ptr<cm_result> &cmr,
+                                  bool player_param_failed, bool emergency)
+{
+  if (emergency) {
     CITY_LOG(LOG_DEBUG, pcity, "emergency management");
-    cm_init_emergency_parameter(&cmp);
-    cm_query_result(pcity, &cmp, cmr, true);
+  }
+  if (player_param_failed) {
+    // If player-defined parameters fail, cancel and notify player.
+    delete pcity->cm_parameter;
+    pcity->cm_parameter = nullptr;
+
+    notify_player(city_owner(pcity), city_tile(pcity), E_CITY_CMA_RELEASE,
+                  ftc_server,
+                  _("The citizen governor can't fulfill the requirements "
+                    "for %s. Passing back control."),
+                  city_link(pcity));
   }
   fc_assert_ret(cmr->found_a_valid);
 
@@ -451,7 +509,176 @@ void auto_arrange_workers(struct city *pcity)
      * by trying to arrange workers more. */
   }
   sanity_check_city(pcity);
+}
+
+/**
+   Call sync_cities() to send the affected cities to the clients.
+ */
+void auto_arrange_workers(struct city *pcity)
+{
+  struct cm_parameter cmp;
+  bool player_param_failed, emergency;
+
+  /* See comment in freeze_workers(): we can't rearrange while
+   * workers are frozen (i.e. multiple updates need to be done). */
+  if (pcity->server.workers_frozen > 0) {
+    pcity->server.needs_arrange = true;
+    return;
+  }
+  TIMING_LOG(AIT_CITIZEN_ARRANGE, TIMER_START);
 
+  arrange_workers_prepare(pcity, &cmp);
+
+  /* This must be after city_refresh() so that the result gets created for
+   * the right city radius */
+  auto cmr = cm_result_new(pcity);
+  player_param_failed = arrange_workers_query(pcity, &cmp, cmr, &emergency);
+  arrange_workers_apply(pcity, cmr, player_param_failed, emergency);
+
+  TIMING_LOG(AIT_CITIZEN_ARRANGE, TIMER_STOP);
+}
+
+// One city of auto_arrange_workers_list()
+struct arrange_job {
+  struct city *pcity;
+  struct cm_parameter cmp;
+  std::unique_ptr<cm_result> cmr;
+  bool player_param_failed;
+  bool emergency;
+  bool on_main_thread;
+};
+
+/**
+   Arrange the workers of all the listed cities, like
+   auto_arrange_workers() does for one. With the 'threaded_arrange'
+   setting the CM searches run on a thread pool.
+
+   The cities are split into groups that share no workable tile and no
+   trade route, so that arranging one can't change what another sees.
+   Each round takes the next city of every group, queries them all in
+   parallel and then applies the results on the main thread. The results
+   are thus applied in another order than the list's. This only gives the
+   same as calling auto_arrange_workers() on each city in turn for cities
+   that don't depend on each other in ways the grouping doesn't see.
+
+   The cities are prepared and refreshed on the main thread, which brings
+   the shared tile cache state up to date. The worker threads then only
+   read it.
+ */
+void auto_arrange_workers_list(struct city_list *cities)
+{
+  std::vector<struct city *> order;
+  std::vector<int> radius_sq, parent;
+  QHash<int, int> by_tile, by_id;
+  QMap<int, std::vector<int>> groups;
+  size_t rounds = 0;
+
+  if (!game.server.threaded_arrange || city_list_size(cities) < 2) {
+    city_list_iterate(cities, pcity) { auto_arrange_workers(pcity); }
+    city_list_iterate_end;
+    return;
+  }
+
+  city_list_iterate(cities, pcity)
+  {
+    by_id.insert(pcity->id, order.size());
+    parent.push_back(order.size());
+    radius_sq.push_back(city_map_radius_sq_get(pcity));
+    order.push_back(pcity);
+  }
+  city_list_iterate_end;
+
+  // Union-find, the root of a group is its first city in the list.
+  auto find = [&parent](int i) {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  };
+  auto unite = [&parent, &find](int a, int b) {
+    a = find(a);
+    b = find(b);
+    if (a != b) {
+      parent[MAX(a, b)] = MIN(a, b);
+    }
+  };
+
+  for (int i = 0; i < static_cast<int>(order.size()); i++) {
+    struct city *pcity = order[i];
+
+    city_tile_iterate(radius_sq[i], city_tile(pcity), ptile)
+    {
+      auto other = by_tile.constFind(tile_index(ptile));
+
+      if (other != by_tile.constEnd()) {
+        unite(i, *other);
+      } else {
+        by_tile.insert(tile_index(ptile), i);
+      }
+    }
+    city_tile_iterate_end;
+
+    trade_routes_iterate(pcity, proute)
+    {
+      auto other = by_id.constFind(proute->partner);
+
+      if (other != by_id.constEnd()) {
+        unite(i, *other);
+      }
+    }
+    trade_routes_iterate_end;
+  }
+
+  for (int i = 0; i < static_cast<int>(order.size()); i++) {
+    groups[find(i)].push_back(i);
+    rounds = MAX(rounds, groups[find(i)].size());
+  }
+
+  TIMING_LOG(AIT_CITIZEN_ARRANGE, TIMER_START);
+  for (size_t round = 0; round < rounds; round++) {
+    std::vector<arrange_job> jobs;
+
+    for (const auto &group : qAsConst(groups)) {
+      arrange_job job;
+
+      if (round >= group.size()) {
+        continue;
+      }
+      job.pcity = order[group[round]];
+      if (job.pcity->server.workers_frozen > 0) {
+        job.pcity->server.needs_arrange = true;
+        continue;
+      }
+      arrange_workers_prepare(job.pcity, &job.cmp);
+      job.cmr = cm_result_new(job.pcity);
+      job.player_param_failed = false;
+      /* The radius may have grown when preparing; the city could then
+       * reach tiles of another group. */
+      job.on_main_thread =
+          (city_map_radius_sq_get(job.pcity) > radius_sq[group[round]]);
+      jobs.push_back(std::move(job));
+    }
+
+    for (auto &job : jobs) {
+      if (!job.on_main_thread) {
+        arrange_pool->start(QRunnable::create([&job] {
+          job.player_param_failed = arrange_workers_query(
+              job.pcity, &job.cmp, job.cmr, &job.emergency);
+        }));
+      }
+    }
+    arrange_pool->waitForDone();
+
+    for (auto &job : jobs) {
+      if (job.on_main_thread) {
+        job.player_param_failed = arrange_workers_query(
+            job.pcity, &job.cmp, job.cmr, &job.emergency);
+      }
+      arrange_workers_apply(job.pcity, job.cmr, job.player_param_failed,
+                            job.emergency);
+    }
+  }
   TIMING_LOG(AIT_CITIZEN_ARRANGE, TIMER_STOP);
 }
 
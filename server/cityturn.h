@@ -25,6 +25,7 @@ void city_refresh_queue_add(struct city *pcity);
 void city_refresh_queue_processing();
 
 void auto_arrange_workers(struct city *pcity); // will arrange the workers
+void auto_arrange_workers_list(struct city_list *cities);
 void apply_cmresult_to_city(struct city *pcity,
                             const std::unique_ptr<cm_result> &cmr);
 
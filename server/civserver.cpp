@@ -195,6 +195,10 @@ int main(int argc, char *argv[])
        _("Use FILE as logfile"),
        // TRANS: Command-line argument
        _("FILE")},
+      {"logsize",
+       _("Start a new logfile when it grows larger than SIZE megabytes"),
+       // TRANS: Command-line argument
+       _("SIZE")},
       {{"M", "Metaserver"},
        _("Set ADDR as metaserver address"),
        // TRANS: Command-line argument
@@ -265,6 +269,17 @@ int main(int argc, char *argv[])
   if (parser.isSet(QStringLiteral("log"))) {
     srvarg.log_filename = parser.value(QStringLiteral("log"));
   }
+  if (parser.isSet(QStringLiteral("logsize"))) {
+    bool conversion_ok;
+    int size = parser.value(QStringLiteral("logsize")).toInt(&conversion_ok);
+
+    if (!conversion_ok || size < 0) {
+      qFatal(_("Invalid log size %s"),
+             qUtf8Printable(parser.value(QStringLiteral("logsize"))));
+      exit(EXIT_FAILURE);
+    }
+    log_set_rotation(static_cast<qint64>(size) * 1024 * 1024);
+  }
   fc_assert_set_fatal(parser.isSet(QStringLiteral("Fatal")));
   if (parser.isSet(QStringLiteral("Ranklog"))) {
     srvarg.ranklog_filename = parser.value(QStringLiteral("Ranklog"));
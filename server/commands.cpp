@@ -84,6 +84,7 @@ static struct command commands[] = {
                "list colors\n"
                "list connections\n"
                "list delegations\n"
+               "list events\n"
                "list ignored users\n"
                "list map image definitions\n"
                "list players\n"
@@ -98,6 +99,7 @@ static struct command commands[] = {
         " - the player colors,\n"
         " - connections to the server,\n"
         " - all player delegations,\n"
+        " - the size of the event cache,\n"
         " - your ignore list,\n"
         " - the list of defined map images,\n"
         " - the list of the players in the game,\n"
@@ -621,6 +623,7 @@ static struct command commands[] = {
         "lua unsafe-cmd <script line>\n"
         "lua file <script file>\n"
         "lua unsafe-file <script file>\n"
+        "lua signals [reset]\n"
         "lua <script line> (deprecated)"),
      N_("Evaluate a line of Freeciv21 script or a Freeciv script file in "
         "the current game."),
@@ -628,7 +631,22 @@ static struct command commands[] = {
         "ruleset. This instance doesn't restrict access to Lua functions "
         "that can be used to hack the computer running the Freeciv21 "
         "server. Access to it is therefore limited to the console and "
-        "connections with cmdlevel 'hack'"),
+        "connections with cmdlevel 'hack'.\n"
+        "'lua signals' lists how often each script signal was emitted and "
+        "how much time its handlers took; 'lua signals reset' clears these "
+        "statistics."),
+     nullptr, CMD_ECHO_ADMINS, VCF_NONE, 0},
+    {"luaprofile", ALLOW_ADMIN,
+     // TRANS: translate text between <> only
+     N_("luaprofile on|off|reset\n"
+        "luaprofile [number of turns]"),
+     N_("Profile the ruleset and scenario scripts."),
+     N_("While the profiler is on, the server records the time spent in "
+        "each script signal handler and periodically samples which Lua "
+        "function and source line is running. Without arguments, or with "
+        "a number of turns (5 by default), the command shows the most "
+        "expensive handlers, functions and lines of that many recent "
+        "turns. Profiling slows scripts down slightly."),
      nullptr, CMD_ECHO_ADMINS, VCF_NONE, 0},
     {"kick", ALLOW_CTRL,
      // TRANS: translate text between <>
@@ -94,6 +94,7 @@ enum command_id {
   CMD_RESET,
   CMD_DEFAULT,
   CMD_LUA,
+  CMD_LUAPROFILE,
   CMD_KICK,
   CMD_DELEGATE,
   CMD_AICMD,
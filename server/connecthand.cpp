@@ -38,6 +38,7 @@
 #include "diplhand.h"
 #include "edithand.h"
 #include "gamehand.h"
+#include "hand_gen.h"
 #include "maphand.h"
 #include "meta.h"
 #include "notify.h"
@@ -54,6 +55,8 @@
 static bool connection_attach_real(struct connection *pconn,
                                    struct player *pplayer, bool observing,
                                    bool connecting);
+static void join_new_connection(struct connection *pconn,
+                                bool send_ruleset_data);
 
 /**
    Set the access level of a connection, and re-send some needed info.  If
@@ -108,7 +111,8 @@ static void restore_access_level(struct connection *pconn)
         pconn->username == player->username
 
    Here we send initial packets:
-   - ruleset datas.
+   - ruleset datas, unless the client has them in its ruleset cache (it
+       is asked first when it has the "ruleset-cache" capability).
    - server settings.
    - scenario info.
    - game info.
@@ -120,13 +124,7 @@ static void restore_access_level(struct connection *pconn)
  */
 void establish_new_connection(struct connection *pconn)
 {
-  struct conn_list *dest = pconn->self;
-  struct player *pplayer;
   struct packet_server_join_reply packet;
-  struct packet_chat_msg connect_info;
-  char hostname[512];
-  bool delegation_error = false;
-  struct packet_set_topology topo_packet;
 
   // zero out the password
   memset(pconn->server.password, 0, sizeof(pconn->server.password));
@@ -148,6 +146,56 @@ void establish_new_connection(struct connection *pconn)
   pconn->server.delegation.playing = nullptr;
   pconn->server.delegation.observer = false;
 
+  if (has_capability("ruleset-cache", pconn->capability)) {
+    /* The client may have the rulesets already. It joins the game once it
+     * answered, see handle_ruleset_cache_reply(). */
+    pconn->server.ruleset_cache_offered = true;
+    dsend_packet_ruleset_cache_offer(pconn, ruleset_cache_hash());
+    return;
+  }
+
+  join_new_connection(pconn, true);
+}
+
+/**
+   Handle the answer of a client to the ruleset cache offer made in
+   establish_new_connection(). The rulesets are sent unless the client has
+   them already.
+ */
+void handle_ruleset_cache_reply(struct connection *pconn, const char *hash,
+                                bool cached)
+{
+  if (!pconn->server.ruleset_cache_offered) {
+    qCritical("Unexpected ruleset cache reply from %s.",
+              conn_description(pconn));
+    return;
+  }
+
+  if (0 != strcmp(hash, ruleset_cache_hash())) {
+    // The rulesets were changed since the offer was made. Ask again.
+    dsend_packet_ruleset_cache_offer(pconn, ruleset_cache_hash());
+    return;
+  }
+  pconn->server.ruleset_cache_offered = false;
+
+  join_new_connection(pconn, !cached);
+}
+
+/**
+   Second part of establish_new_connection(): add the connection to the
+   game and send it the initial packets. The rulesets are only sent when
+   'send_ruleset_data' is TRUE.
+ */
+static void join_new_connection(struct connection *pconn,
+                                bool send_ruleset_data)
+{
+  struct conn_list *dest = pconn->self;
+  struct player *pplayer;
+  struct packet_chat_msg connect_info;
+  char hostname[512];
+  bool delegation_error = false;
+  struct packet_set_topology topo_packet;
+
   conn_list_append(game.est_connections, pconn);
   if (conn_list_size(game.est_connections) == 1) {
     /* First connection
@@ -175,7 +223,9 @@ void establish_new_connection(struct connection *pconn)
         qUtf8Printable(pconn->addr));
 
   conn_compression_freeze(pconn);
-  send_rulesets(dest);
+  if (send_ruleset_data) {
+    send_rulesets(dest);
+  }
   send_server_setting_control(pconn);
   send_server_settings(dest);
   send_scenario_info(dest);
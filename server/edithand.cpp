@@ -131,6 +131,7 @@ static void check_edited_tile_terrains()
   if (need_continents_reassigned) {
     assign_continent_numbers();
     send_all_known_tiles(nullptr);
+    map_borders_invalidate();
     need_continents_reassigned = false;
   }
 
@@ -346,7 +347,8 @@ void handle_edit_tile_extra(struct connection *pc, int tile, int id,
   conn_list_do_buffer(game.est_connections);
   square_iterate(&(wld.map), ptile_center, size - 1, ptile)
   {
-    ptile->extras_owner = plr_eowner;
+    tile_set_extras_owner(ptile, plr_eowner);
+    map_borders_tile_changed(ptile);
     edit_tile_extra_handling(ptile, extra_by_number(id), removal, true);
   }
   square_iterate_end;
@@ -392,7 +394,8 @@ void handle_edit_tile(struct connection *pc,
   }
 
   if (ptile->extras_owner != eowner) {
-    ptile->extras_owner = eowner;
+    tile_set_extras_owner(ptile, eowner);
+    map_borders_tile_changed(ptile);
     changed = true;
   }
 
@@ -58,16 +58,14 @@ static float hmap_pole_factor(struct tile *ptile)
  */
 void normalize_hmap_poles()
 {
-  whole_map_iterate(&(wld.map), ptile)
-  {
+  whole_map_iterate_parallel([](struct tile *ptile) {
     if (map_colatitude(ptile) <= 2.5 * ICE_BASE_LEVEL) {
       hmap(ptile) *= hmap_pole_factor(ptile);
     } else if (near_singularity(ptile)) {
       // Near map edge but not near pole.
       hmap(ptile) = 0;
     }
-  }
-  whole_map_iterate_end;
+  });
 }
 
 /**
@@ -76,8 +74,7 @@ void normalize_hmap_poles()
  */
 void renormalize_hmap_poles()
 {
-  whole_map_iterate(&(wld.map), ptile)
-  {
+  whole_map_iterate_parallel([](struct tile *ptile) {
     if (hmap(ptile) == 0) {
       // Nothing left to restore.
     } else if (map_colatitude(ptile) <= 2.5 * ICE_BASE_LEVEL) {
@@ -88,8 +85,7 @@ void renormalize_hmap_poles()
         hmap(ptile) /= factor;
       }
     }
-  }
-  whole_map_iterate_end;
+  });
 }
 
 /**
@@ -2238,7 +2238,7 @@ static void initworld(struct gen234_state *pstate)
     map_set_placed(ptile); // not a land tile
     BV_CLR_ALL(ptile->extras);
     tile_set_owner(ptile, nullptr, nullptr);
-    ptile->extras_owner = nullptr;
+    tile_set_extras_owner(ptile, nullptr);
   }
   whole_map_iterate_end;
 
@@ -3497,7 +3497,7 @@ static bool map_generate_fair_islands()
     tile_set_continent(ptile, 0);
     BV_CLR_ALL(ptile->extras);
     tile_set_owner(ptile, nullptr, nullptr);
-    ptile->extras_owner = nullptr;
+    tile_set_extras_owner(ptile, nullptr);
   }
   whole_map_iterate_end;
 
@@ -8,6 +8,13 @@ _   ._       Copyright (c) 1996-2021 Freeciv21 and Freeciv contributors.
   :X:      received a copy of the GNU General Public License along with
   :X:              Freeciv21. If not, see https://www.gnu.org/licenses/.
  */
+
+#include <algorithm>
+
+// Qt
+#include <QRunnable>
+#include <QThreadPool>
+
 // utility
 #include "fcintl.h"
 #include "log.h"
@@ -21,6 +28,12 @@ _   ._       Copyright (c) 1996-2021 Freeciv21 and Freeciv contributors.
 
 #include "mapgen_utils.h"
 
+// Worker threads for whole_map_ranges_parallel()
+Q_GLOBAL_STATIC(QThreadPool, mapgen_pool)
+
+// Below this number of tiles, a range is not worth a thread.
+#define MAPGEN_MIN_RANGE 4096
+
 /**
  Map that contains, according to circumstances, information on whether
  we have already placed terrain (special, hut) here.
@@ -157,6 +170,41 @@ void adjust_int_map_filtered(int *int_map, int int_map_max, void *data,
   }
 }
 
+/**
+   Calls 'func' with consecutive ranges [first, last) of tile indexes that
+   together cover the whole map, from worker threads, and waits for all of
+   them.
+
+   'func' may read anything but must only write data belonging to the
+   tiles of its range, and must not use the random number generator: then
+   the result is the same as a serial pass, whatever the number of threads,
+   and a given map seed still gives the same map.
+ */
+void whole_map_ranges_parallel(
+    const std::function<void(int first, int last)> &func)
+{
+  const int size = MAP_INDEX_SIZE;
+  const int ranges =
+      std::min(mapgen_pool->maxThreadCount() * 4,
+               std::max(1, size / MAPGEN_MIN_RANGE));
+
+  if (ranges <= 1) {
+    func(0, size);
+    return;
+  }
+
+  for (int r = 1; r < ranges; r++) {
+    const int first = static_cast<qint64>(size) * r / ranges;
+    const int last = static_cast<qint64>(size) * (r + 1) / ranges;
+
+    mapgen_pool->start(
+        QRunnable::create([&func, first, last] { func(first, last); }));
+  }
+  // The calling thread does its share too.
+  func(0, size / ranges);
+  mapgen_pool->waitForDone();
+}
+
 /**
    Apply a Gaussian diffusion filter on the map. The size of the map is
    MAP_INDEX_SIZE and the map is indexed by native_pos_to_index function.
@@ -179,8 +227,7 @@ void smooth_int_map(int *int_map, bool zeroes_at_edges)
   source_map = int_map;
 
   do {
-    whole_map_iterate(&(wld.map), ptile)
-    {
+    whole_map_iterate_parallel([=](struct tile *ptile) {
       float N = 0, D = 0;
 
       axis_iterate(&(wld.map), ptile, pnear, i, 2, axe)
@@ -193,8 +240,7 @@ void smooth_int_map(int *int_map, bool zeroes_at_edges)
         D = 1;
       }
       target_map[tile_index(ptile)] = N / D;
-    }
-    whole_map_iterate_end;
+    });
 
     if (MAP_IS_ISOMETRIC) {
       weight = weight_isometric;
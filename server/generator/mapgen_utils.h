@@ -10,6 +10,11 @@
 **************************************************************************/
 #pragma once
 
+#include <functional>
+
+// common
+#include "map.h"
+
 #define MG_UNUSED mapgen_terrain_property_invalid()
 
 void generator_free();
@@ -104,6 +109,21 @@ void adjust_int_map_filtered(int *int_map, int int_map_max, void *data,
       (bool (*)(const struct tile *ptile, const void *data)) nullptr)
 void smooth_int_map(int *int_map, bool zeroes_at_edges);
 
+// parallel passes
+void whole_map_ranges_parallel(
+    const std::function<void(int first, int last)> &func);
+
+/* Calls 'func' with every tile of the map, from worker threads. See
+ * whole_map_ranges_parallel(). */
+template <typename F> void whole_map_iterate_parallel(F func)
+{
+  whole_map_ranges_parallel([&func](int first, int last) {
+    for (int i = first; i < last; i++) {
+      func(index_to_tile(&(wld.map), i));
+    }
+  });
+}
+
 // placed_map tool
 void create_placed_map();
 void destroy_placed_map();
@@ -349,15 +349,13 @@ bool create_start_positions(enum map_startpos mode,
   tile_value = new int[MAP_INDEX_SIZE]();
 
   // get the tile value
-  whole_map_iterate(&(wld.map), value_tile)
-  {
+  whole_map_iterate_parallel([tile_value_aux](struct tile *value_tile) {
     tile_value_aux[tile_index(value_tile)] = get_tile_value(value_tile);
-  }
-  whole_map_iterate_end;
+  });
 
   // select the best tiles
-  whole_map_iterate(&(wld.map), value_tile)
-  {
+  whole_map_iterate_parallel([tile_value_aux,
+                              tile_value](struct tile *value_tile) {
     int this_tile_value = tile_value_aux[tile_index(value_tile)];
     int lcount = 0, bcount = 0;
 
@@ -376,8 +374,7 @@ bool create_start_positions(enum map_startpos mode,
       this_tile_value = 0;
     }
     tile_value[tile_index(value_tile)] = 100 * this_tile_value;
-  }
-  whole_map_iterate_end;
+  });
   // get an average value
   smooth_int_map(tile_value, true);
 
@@ -119,8 +119,7 @@ void create_tmap(bool real)
   fc_assert_ret(nullptr == temperature_map);
 
   temperature_map = new int[MAP_INDEX_SIZE];
-  whole_map_iterate(&(wld.map), ptile)
-  {
+  whole_map_iterate_parallel([real](struct tile *ptile) {
     // the base temperature is equal to base map_colatitude
     int t = map_colatitude(ptile);
 
@@ -139,8 +138,7 @@ void create_tmap(bool real)
 
       tmap(ptile) = t * (1.0 + temperate) * (1.0 + height);
     }
-  }
-  whole_map_iterate_end;
+  });
   // adjust to get well sizes frequencies
   /* Notice: if colatitude is loaded from a scenario never call adjust.
              Scenario may have an odd colatitude distribution and adjust will
@@ -149,19 +147,21 @@ void create_tmap(bool real)
     adjust_int_map(temperature_map, MAX_COLATITUDE);
   }
   // now simplify to 4 base values
-  for (i = 0; i < MAP_INDEX_SIZE; i++) {
-    int t = temperature_map[i];
-
-    if (t >= TROPICAL_LEVEL) {
-      temperature_map[i] = TT_TROPICAL;
-    } else if (t >= COLD_LEVEL) {
-      temperature_map[i] = TT_TEMPERATE;
-    } else if (t >= 2 * ICE_BASE_LEVEL) {
-      temperature_map[i] = TT_COLD;
-    } else {
-      temperature_map[i] = TT_FROZEN;
+  whole_map_ranges_parallel([](int first, int last) {
+    for (int j = first; j < last; j++) {
+      int t = temperature_map[j];
+
+      if (t >= TROPICAL_LEVEL) {
+        temperature_map[j] = TT_TROPICAL;
+      } else if (t >= COLD_LEVEL) {
+        temperature_map[j] = TT_TEMPERATE;
+      } else if (t >= 2 * ICE_BASE_LEVEL) {
+        temperature_map[j] = TT_COLD;
+      } else {
+        temperature_map[j] = TT_FROZEN;
+      }
     }
-  }
+  });
 
   log_debug("%stemperature map ({f}rozen, {c}old, {m}edium, {t}ropical):",
             real ? "real " : "");
@@ -12,6 +12,14 @@
       \____/        ********************************************************/
 
 #include <QBitArray>
+#include <QHash>
+#include <QSet>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <set>
+#include <vector>
 
 // utility
 #include "bitvector.h"
@@ -47,6 +55,9 @@
 #include "unithand.h"
 #include "unittools.h"
 
+/* server/advisors */
+#include "autoexplorer.h"
+
 /* server/generator */
 #include "mapgen_utils.h"
 
@@ -57,6 +68,46 @@
 // Suppress send_tile_info() during game_load()
 static bool send_tile_suppressed = false;
 
+/* Inputs of a border source as of its last claim. When none of them
+ * changed, claiming again has no effect. See map_calculate_dirty_borders().
+ */
+struct border_source {
+  struct player *owner;
+  int radius_sq;
+  int strength;
+  int city_radius_sq; // region claimed permanently by a city
+  bool claim_ocean;
+  bool claim_ocean_limited;
+  bool unknown_tiles; // some tiles were skipped as unknown to the owner
+};
+
+// Border sources by tile index, and the ones that must claim again.
+static QHash<int, border_source> border_sources;
+static QSet<int> border_dirty;
+static bool border_sources_valid = false;
+static enum borders_mode border_sources_mode = BORDERS_DISABLED;
+
+/* Tile indexes of the vision sites in each player's private map, by player
+ * index. Kept by map_set_player_site() so that the known cities of a player
+ * can be listed without scanning the whole map. */
+static std::set<int> known_sites[MAX_NUM_PLAYER_SLOTS];
+
+/* Seen counts of the tiles for each player, by player index. They are kept
+ * out of struct player_tile in one dense array per vision layer, along with
+ * bitsets of the tiles with a non-zero count, so that fog checks don't load
+ * the private map and whole map passes can skip the tiles that don't
+ * matter a word at a time. Allocated by player_map_init(). */
+struct player_vision_map {
+  std::vector<short> seen_count[V_COUNT]; // by tile index
+  /* Without shared vision. If you build a city with an unknown square
+   * within city radius the square stays unknown, but the seen points are
+   * counted here and in seen_count. */
+  std::vector<short> own_seen[V_COUNT];
+  QBitArray seen[V_COUNT];                // seen_count[v] > 0
+  QBitArray own_seen_any;                 // own_seen[v] > 0 for some v
+};
+static struct player_vision_map vision_maps[MAX_NUM_PLAYER_SLOTS];
+
 static void player_tile_init(struct tile *ptile, struct player *pplayer);
 static void player_tile_free(struct tile *ptile, struct player *pplayer);
 static void give_tile_info_from_player_to_player(struct player *pfrom,
@@ -68,14 +119,18 @@ static void shared_vision_change_seen(struct player *pplayer,
                                       bool can_reveal_tiles);
 static void map_change_seen(struct player *pplayer, struct tile *ptile,
                             const v_radius_t change, bool can_reveal_tiles);
+static void map_vision_update_except(struct player *pplayer,
+                                     struct tile *ptile,
+                                     const v_radius_t old_radius_sq,
+                                     const v_radius_t new_radius_sq,
+                                     bool can_reveal_tiles,
+                                     const struct tile *except_tile,
+                                     const v_radius_t except_radius_sq);
 static void map_change_own_seen(struct player *pplayer, struct tile *ptile,
                                 const v_radius_t change);
 static inline int map_get_seen(const struct player *pplayer,
                                const struct tile *ptile,
                                enum vision_layer vlayer);
-static inline int map_get_own_seen(const struct player *pplayer,
-                                   const struct tile *ptile,
-                                   enum vision_layer vlayer);
 
 static bool is_claimable_ocean(struct tile *ptile, struct tile *source,
                                struct player *pplayer);
@@ -376,11 +431,11 @@ void give_map_from_player_to_player(struct player *pfrom,
 {
   buffer_shared_vision(pdest);
 
-  whole_map_iterate(&(wld.map), ptile)
-  {
-    give_tile_info_from_player_to_player(pfrom, pdest, ptile);
-  }
-  whole_map_iterate_end;
+  // Only tiles known to pfrom have something to give.
+  bitarray_iterate(*pfrom->tile_known, [pfrom, pdest](int tindex) {
+    give_tile_info_from_player_to_player(
+        pfrom, pdest, index_to_tile(&(wld.map), tindex));
+  });
 
   unbuffer_shared_vision(pdest);
   city_thaw_workers_queue();
@@ -395,13 +450,13 @@ void give_seamap_from_player_to_player(struct player *pfrom,
 {
   buffer_shared_vision(pdest);
 
-  whole_map_iterate(&(wld.map), ptile)
-  {
+  bitarray_iterate(*pfrom->tile_known, [pfrom, pdest](int tindex) {
+    struct tile *ptile = index_to_tile(&(wld.map), tindex);
+
     if (is_ocean_tile(ptile)) {
       give_tile_info_from_player_to_player(pfrom, pdest, ptile);
     }
-  }
-  whole_map_iterate_end;
+  });
 
   unbuffer_shared_vision(pdest);
   city_thaw_workers_queue();
@@ -658,6 +713,25 @@ static void shared_vision_change_seen(struct player *pplayer,
 void map_vision_update(struct player *pplayer, struct tile *ptile,
                        const v_radius_t old_radius_sq,
                        const v_radius_t new_radius_sq, bool can_reveal_tiles)
+{
+  map_vision_update_except(pplayer, ptile, old_radius_sq, new_radius_sq,
+                           can_reveal_tiles, nullptr, nullptr);
+}
+
+/**
+   As map_vision_update(), but the tiles within 'except_radius_sq' of
+   'except_tile' are left alone for each vision layer, and the tiles that
+   are left with no change at all are skipped. Every tile of the larger
+   circle is still visited and checked with sq_map_distance(); only the
+   seen count updates are saved.
+ */
+static void map_vision_update_except(struct player *pplayer,
+                                     struct tile *ptile,
+                                     const v_radius_t old_radius_sq,
+                                     const v_radius_t new_radius_sq,
+                                     bool can_reveal_tiles,
+                                     const struct tile *except_tile,
+                                     const v_radius_t except_radius_sq)
 {
   v_radius_t change;
   int max_radius;
@@ -692,6 +766,19 @@ void map_vision_update(struct player *pplayer, struct tile *ptile,
   vision_layer_iterate_end;
 #endif // FREECIV_DEBUG
 
+  /* The players sharing vision don't change while the circle is walked:
+   * look them up once rather than for every tile. */
+  struct player *receivers[MAX_NUM_PLAYER_SLOTS];
+  int nreceivers = 0;
+
+  players_iterate(pplayer2)
+  {
+    if (really_gives_vision(pplayer, pplayer2)) {
+      receivers[nreceivers++] = pplayer2;
+    }
+  }
+  players_iterate_end;
+
   buffer_shared_vision(pplayer);
   circle_dxyr_iterate(&(wld.map), ptile, max_radius, tile1, dx, dy, dr)
   {
@@ -706,7 +793,30 @@ void map_vision_update(struct player *pplayer, struct tile *ptile,
       }
     }
     vision_layer_iterate_end;
-    shared_vision_change_seen(pplayer, tile1, change, can_reveal_tiles);
+
+    bool apply = true;
+
+    if (except_tile != nullptr) {
+      const int except_dr = sq_map_distance(except_tile, tile1);
+
+      apply = false;
+      vision_layer_iterate(v)
+      {
+        if (except_dr <= except_radius_sq[v]) {
+          change[v] = 0;
+        }
+        apply = apply || 0 != change[v];
+      }
+      vision_layer_iterate_end;
+    }
+
+    if (apply) {
+      map_change_own_seen(pplayer, tile1, change);
+      map_change_seen(pplayer, tile1, change, can_reveal_tiles);
+      for (int i = 0; i < nreceivers; i++) {
+        map_change_seen(receivers[i], tile1, change, can_reveal_tiles);
+      }
+    }
   }
   circle_dxyr_iterate_end;
   unbuffer_shared_vision(pplayer);
@@ -741,70 +851,98 @@ void map_set_border_vision(struct player *pplayer, const bool is_enabled)
 }
 
 /**
-   Shows the area to the player.  Unless the tile is "seen", it will remain
-   fogged and units will be hidden.
-
-   Callers may wish to buffer_shared_vision before calling this function.
+   Shows the tile to one player that receives the vision, unless the player
+   already sees it.
  */
-void map_show_tile(struct player *src_player, struct tile *ptile)
+static void really_map_show_tile(struct player *pplayer, struct tile *ptile)
 {
   static int recurse = 0;
-
-  log_debug("Showing %i,%i to %s", TILE_XY(ptile), player_name(src_player));
+  struct city *pcity;
 
   fc_assert(recurse == 0);
   recurse++;
 
-  players_iterate(pplayer)
-  {
-    if (pplayer == src_player || really_gives_vision(src_player, pplayer)) {
-      struct city *pcity;
-
-      if (!map_is_known_and_seen(ptile, pplayer, V_MAIN)) {
-        map_set_known(ptile, pplayer);
+  if (!map_is_known_and_seen(ptile, pplayer, V_MAIN)) {
+    map_set_known(ptile, pplayer);
 
-        /* as the tile may be fogged send_tile_info won't always do this for
-         * us */
-        update_player_tile_knowledge(pplayer, ptile);
-        update_player_tile_last_seen(pplayer, ptile);
+    /* as the tile may be fogged send_tile_info won't always do this for
+     * us */
+    update_player_tile_knowledge(pplayer, ptile);
+    update_player_tile_last_seen(pplayer, ptile);
 
-        send_tile_info(pplayer->connections, ptile, false);
+    send_tile_info(pplayer->connections, ptile, false);
 
-        // remove old cities that exist no more
-        reality_check_city(pplayer, ptile);
+    // remove old cities that exist no more
+    reality_check_city(pplayer, ptile);
 
-        if ((pcity = tile_city(ptile))) {
-          // as the tile may be fogged send_city_info won't do this for us
-          update_dumb_city(pplayer, pcity);
-          send_city_info(pplayer, pcity);
-        }
+    if ((pcity = tile_city(ptile))) {
+      // as the tile may be fogged send_city_info won't do this for us
+      update_dumb_city(pplayer, pcity);
+      send_city_info(pplayer, pcity);
+    }
 
-        struct building *pbuilding = map_buildings_get(ptile);
-        if (pbuilding) {
-          send_building_info(pplayer, pbuilding);
-        }
+    struct building *pbuilding = map_buildings_get(ptile);
+    if (pbuilding) {
+      send_building_info(pplayer, pbuilding);
+    }
 
-        vision_layer_iterate(v)
+    vision_layer_iterate(v)
+    {
+      if (0 < map_get_seen(pplayer, ptile, v)) {
+        unit_list_iterate(ptile->units, punit)
         {
-          if (0 < map_get_seen(pplayer, ptile, v)) {
-            unit_list_iterate(ptile->units, punit)
-            {
-              if (v == unit_type_get(punit)->vlayer) {
-                send_unit_info(pplayer->connections, punit);
-              }
-            }
-            unit_list_iterate_end;
+          if (v == unit_type_get(punit)->vlayer) {
+            send_unit_info(pplayer->connections, punit);
           }
         }
-        vision_layer_iterate_end;
+        unit_list_iterate_end;
       }
     }
+    vision_layer_iterate_end;
   }
-  players_iterate_end;
 
   recurse--;
 }
 
+/**
+   Returns in 'receivers' the players that get to see what 'src_player'
+   is shown: 'src_player' and the players it gives shared vision to, in
+   player order. Returns the number of players.
+ */
+static int map_show_receivers(struct player *src_player,
+                              struct player **receivers)
+{
+  int nreceivers = 0;
+
+  players_iterate(pplayer)
+  {
+    if (pplayer == src_player || really_gives_vision(src_player, pplayer)) {
+      receivers[nreceivers++] = pplayer;
+    }
+  }
+  players_iterate_end;
+
+  return nreceivers;
+}
+
+/**
+   Shows the area to the player.  Unless the tile is "seen", it will remain
+   fogged and units will be hidden.
+
+   Callers may wish to buffer_shared_vision before calling this function.
+ */
+void map_show_tile(struct player *src_player, struct tile *ptile)
+{
+  struct player *receivers[MAX_NUM_PLAYER_SLOTS];
+  const int nreceivers = map_show_receivers(src_player, receivers);
+
+  log_debug("Showing %i,%i to %s", TILE_XY(ptile), player_name(src_player));
+
+  for (int i = 0; i < nreceivers; i++) {
+    really_map_show_tile(receivers[i], ptile);
+  }
+}
+
 /**
    Hides the area to the player.
 
@@ -863,11 +1001,16 @@ void map_hide_tile(struct player *src_player, struct tile *ptile)
 void map_show_circle(struct player *pplayer, struct tile *ptile,
                      int radius_sq)
 {
+  struct player *receivers[MAX_NUM_PLAYER_SLOTS];
+  const int nreceivers = map_show_receivers(pplayer, receivers);
+
   buffer_shared_vision(pplayer);
 
   circle_iterate(&(wld.map), ptile, radius_sq, tile1)
   {
-    map_show_tile(pplayer, tile1);
+    for (int i = 0; i < nreceivers; i++) {
+      really_map_show_tile(receivers[i], tile1);
+    }
   }
   circle_iterate_end;
 
@@ -880,10 +1023,23 @@ void map_show_circle(struct player *pplayer, struct tile *ptile,
  */
 void map_show_all(struct player *pplayer)
 {
+  struct player *receivers[MAX_NUM_PLAYER_SLOTS];
+  const int nreceivers = map_show_receivers(pplayer, receivers);
+
   buffer_shared_vision(pplayer);
 
-  whole_map_iterate(&(wld.map), ptile) { map_show_tile(pplayer, ptile); }
-  whole_map_iterate_end;
+  for (int i = 0; i < nreceivers; i++) {
+    struct player *receiver = receivers[i];
+    const QBitArray &seen = vision_maps[player_index(receiver)].seen[V_MAIN];
+
+    /* The tiles both known and seen are left alone by
+     * really_map_show_tile(); skip them a word at a time. */
+    bitarray_iterate(~(*receiver->tile_known & seen),
+                     [receiver](int tindex) {
+                       really_map_show_tile(
+                           receiver, index_to_tile(&(wld.map), tindex));
+                     });
+  }
 
   unbuffer_shared_vision(pplayer);
 }
@@ -906,8 +1062,15 @@ bool map_is_known_and_seen(const struct tile *ptile,
                            const struct player *pplayer,
                            enum vision_layer vlayer)
 {
-  return (map_is_known(ptile, pplayer)
-          && 0 < map_get_seen(pplayer, ptile, vlayer));
+  if (!map_is_known(ptile, pplayer)) {
+    return false;
+  }
+  if (vision_maps[player_index(pplayer)].seen[vlayer].testBit(
+          tile_index(ptile))) {
+    return true;
+  }
+  // Buildings may still make it seen.
+  return 0 < map_get_seen(pplayer, ptile, vlayer);
 }
 
 /**
@@ -927,7 +1090,18 @@ static inline int map_get_seen(const struct player *pplayer,
       return 1;
   }
   extra_type_by_cause_iterate_end;
-  return map_get_player_tile(ptile, pplayer)->seen_count[vlayer];
+  return map_get_seen_count(ptile, pplayer, vlayer);
+}
+
+/**
+   Returns the seen count of a tile for a player, including shared vision.
+ */
+int map_get_seen_count(const struct tile *ptile,
+                       const struct player *pplayer,
+                       enum vision_layer vlayer)
+{
+  return vision_maps[player_index(pplayer)]
+      .seen_count[vlayer][tile_index(ptile)];
 }
 
 /**
@@ -940,6 +1114,11 @@ void map_change_seen(struct player *pplayer, struct tile *ptile,
                      const v_radius_t change, bool can_reveal_tiles)
 {
   struct player_tile *plrtile = map_get_player_tile(ptile, pplayer);
+  struct player_vision_map &vmap = vision_maps[player_index(pplayer)];
+  const int tindex = tile_index(ptile);
+  auto seen_count = [&vmap, tindex](enum vision_layer v) -> short & {
+    return vmap.seen_count[v][tindex];
+  };
   bool revealing_tile = false;
 
 #ifdef FREECIV_DEBUG
@@ -948,7 +1127,7 @@ void map_change_seen(struct player *pplayer, struct tile *ptile,
   vision_layer_iterate(v)
   {
     log_debug("  vision layer %d is changing from %d to %d.", v,
-              plrtile->seen_count[v], plrtile->seen_count[v] + change[v]);
+              seen_count(v), seen_count(v) + change[v]);
   }
   vision_layer_iterate_end;
 #endif // FREECIV_DEBUG
@@ -957,7 +1136,7 @@ void map_change_seen(struct player *pplayer, struct tile *ptile,
    * we must remove all units before fog of war because clients expect
    * the tile is empty when it is fogged. */
   if (0 > change[V_INVIS]
-      && plrtile->seen_count[V_INVIS] == -change[V_INVIS]) {
+      && seen_count(V_INVIS) == -change[V_INVIS]) {
     log_debug("(%d, %d): hiding invisible units to player %s (nb %d).",
               TILE_XY(ptile), player_name(pplayer), player_number(pplayer));
 
@@ -971,7 +1150,7 @@ void map_change_seen(struct player *pplayer, struct tile *ptile,
     unit_list_iterate_end;
   }
   if (0 > change[V_SUBSURFACE]
-      && plrtile->seen_count[V_SUBSURFACE] == -change[V_SUBSURFACE]) {
+      && seen_count(V_SUBSURFACE) == -change[V_SUBSURFACE]) {
     log_debug("(%d, %d): hiding subsurface units to player %s (nb %d).",
               TILE_XY(ptile), player_name(pplayer), player_number(pplayer));
 
@@ -985,7 +1164,7 @@ void map_change_seen(struct player *pplayer, struct tile *ptile,
     unit_list_iterate_end;
   }
 
-  if (0 > change[V_MAIN] && plrtile->seen_count[V_MAIN] == -change[V_MAIN]) {
+  if (0 > change[V_MAIN] && seen_count(V_MAIN) == -change[V_MAIN]) {
     log_debug("(%d, %d): hiding visible units to player %s (nb %d).",
               TILE_XY(ptile), player_name(pplayer), player_number(pplayer));
 
@@ -1002,8 +1181,9 @@ void map_change_seen(struct player *pplayer, struct tile *ptile,
   vision_layer_iterate(v)
   {
     // Avoid underflow.
-    fc_assert(0 <= change[v] || -change[v] <= plrtile->seen_count[v]);
-    plrtile->seen_count[v] += change[v];
+    fc_assert(0 <= change[v] || -change[v] <= seen_count(v));
+    seen_count(v) += change[v];
+    vmap.seen[v].setBit(tindex, 0 < seen_count(v));
   }
   vision_layer_iterate_end;
 
@@ -1012,13 +1192,13 @@ void map_change_seen(struct player *pplayer, struct tile *ptile,
    * seen count cannot be inferior to V_INVIS or V_SUBSURFACE seen count.
    * Moreover, when the fog of war is disabled, V_MAIN has an extra
    * seen count point. */
-  fc_assert(plrtile->seen_count[V_INVIS] + !game.info.fogofwar
-            <= plrtile->seen_count[V_MAIN]);
-  fc_assert(plrtile->seen_count[V_SUBSURFACE] + !game.info.fogofwar
-            <= plrtile->seen_count[V_MAIN]);
+  fc_assert(seen_count(V_INVIS) + !game.info.fogofwar
+            <= seen_count(V_MAIN));
+  fc_assert(seen_count(V_SUBSURFACE) + !game.info.fogofwar
+            <= seen_count(V_MAIN));
 
   if (!map_is_known(ptile, pplayer)) {
-    if (0 < plrtile->seen_count[V_MAIN] && can_reveal_tiles) {
+    if (0 < seen_count(V_MAIN) && can_reveal_tiles) {
       log_debug("(%d, %d): revealing tile to player %s (nb %d).",
                 TILE_XY(ptile), player_name(pplayer),
                 player_number(pplayer));
@@ -1031,7 +1211,7 @@ void map_change_seen(struct player *pplayer, struct tile *ptile,
   }
 
   // Fog the tile.
-  if (0 > change[V_MAIN] && 0 == plrtile->seen_count[V_MAIN]) {
+  if (0 > change[V_MAIN] && 0 == seen_count(V_MAIN)) {
     log_debug("(%d, %d): fogging tile for player %s (nb %d).",
               TILE_XY(ptile), player_name(pplayer), player_number(pplayer));
 
@@ -1043,12 +1223,12 @@ void map_change_seen(struct player *pplayer, struct tile *ptile,
     send_tile_info(pplayer->connections, ptile, false);
   }
 
-  if ((revealing_tile && 0 < plrtile->seen_count[V_MAIN])
+  if ((revealing_tile && 0 < seen_count(V_MAIN))
       || (0 < change[V_MAIN]
-          /* plrtile->seen_count[V_MAIN] Always set to 1
+          /* seen_count(V_MAIN) Always set to 1
            * when the fog of war is disabled. */
           && (change[V_MAIN] + !game.info.fogofwar
-              == (plrtile->seen_count[V_MAIN])))) {
+              == (seen_count(V_MAIN))))) {
     struct city *pcity;
 
     log_debug("(%d, %d): unfogging tile for player %s (nb %d).",
@@ -1083,9 +1263,9 @@ void map_change_seen(struct player *pplayer, struct tile *ptile,
     }
   }
 
-  if ((revealing_tile && 0 < plrtile->seen_count[V_INVIS])
+  if ((revealing_tile && 0 < seen_count(V_INVIS))
       || (0 < change[V_INVIS]
-          && change[V_INVIS] == plrtile->seen_count[V_INVIS])) {
+          && change[V_INVIS] == seen_count(V_INVIS))) {
     log_debug("(%d, %d): revealing invisible units to player %s (nb %d).",
               TILE_XY(ptile), player_name(pplayer), player_number(pplayer));
     // Discover units.
@@ -1097,9 +1277,9 @@ void map_change_seen(struct player *pplayer, struct tile *ptile,
     }
     unit_list_iterate_end;
   }
-  if ((revealing_tile && 0 < plrtile->seen_count[V_SUBSURFACE])
+  if ((revealing_tile && 0 < seen_count(V_SUBSURFACE))
       || (0 < change[V_SUBSURFACE]
-          && change[V_SUBSURFACE] == plrtile->seen_count[V_SUBSURFACE])) {
+          && change[V_SUBSURFACE] == seen_count(V_SUBSURFACE))) {
     log_debug("(%d, %d): revealing subsurface units to player %s (nb %d).",
               TILE_XY(ptile), player_name(pplayer), player_number(pplayer));
     // Discover units.
@@ -1119,11 +1299,12 @@ void map_change_seen(struct player *pplayer, struct tile *ptile,
 
    See also map_get_seen().
  */
-static inline int map_get_own_seen(const struct player *pplayer,
-                                   const struct tile *ptile,
-                                   enum vision_layer vlayer)
+int map_get_own_seen(const struct tile *ptile,
+                     const struct player *pplayer,
+                     enum vision_layer vlayer)
 {
-  return map_get_player_tile(ptile, pplayer)->own_seen[vlayer];
+  return vision_maps[player_index(pplayer)]
+      .own_seen[vlayer][tile_index(ptile)];
 }
 
 /**
@@ -1132,29 +1313,53 @@ static inline int map_get_own_seen(const struct player *pplayer,
 static void map_change_own_seen(struct player *pplayer, struct tile *ptile,
                                 const v_radius_t change)
 {
-  struct player_tile *plrtile = map_get_player_tile(ptile, pplayer);
+  struct player_vision_map &vmap = vision_maps[player_index(pplayer)];
+  const int tindex = tile_index(ptile);
+  bool any = false;
 
-  vision_layer_iterate(v) { plrtile->own_seen[v] += change[v]; }
+  vision_layer_iterate(v)
+  {
+    vmap.own_seen[v][tindex] += change[v];
+    any = any || 0 < vmap.own_seen[v][tindex];
+  }
   vision_layer_iterate_end;
+  vmap.own_seen_any.setBit(tindex, any);
 }
 
 /**
-  Changes site information for player tile.
+   Changes the site at the tile in the private map of the player. The old
+   site, if any, is destroyed.
  */
-void change_playertile_site(struct player_tile *ptile,
-                            struct vision_site *new_site)
+void map_set_player_site(struct tile *ptile, struct player *pplayer,
+                         struct vision_site *new_site)
 {
-  if (ptile->site == new_site) {
+  struct player_tile *plrtile = map_get_player_tile(ptile, pplayer);
+
+  if (plrtile->site == new_site) {
     // Do nothing.
     return;
   }
 
-  if (ptile->site != nullptr) {
+  if (plrtile->site != nullptr) {
     // Releasing old site from tile
-    vision_site_destroy(ptile->site);
+    vision_site_destroy(plrtile->site);
   }
 
-  ptile->site = new_site;
+  plrtile->site = new_site;
+  if (new_site != nullptr) {
+    known_sites[player_index(pplayer)].insert(tile_index(ptile));
+  } else {
+    known_sites[player_index(pplayer)].erase(tile_index(ptile));
+  }
+}
+
+/**
+   Returns the indexes of the tiles with a vision site in the private map
+   of the player, in increasing order.
+ */
+const std::set<int> &map_get_player_sites(const struct player *pplayer)
+{
+  return known_sites[player_index(pplayer)];
 }
 
 /**
@@ -1212,6 +1417,22 @@ void player_map_init(struct player *pplayer)
 
   whole_map_iterate(&(wld.map), ptile) { player_tile_init(ptile, pplayer); }
   whole_map_iterate_end;
+  known_sites[player_index(pplayer)].clear();
+
+  /* We need to use fogofwar_old here, so the player's tiles get in the
+   * same state as the other players' tiles. */
+  struct player_vision_map &vmap = vision_maps[player_index(pplayer)];
+
+  vision_layer_iterate(v)
+  {
+    const bool seen = (V_MAIN == v && !game.server.fogofwar_old);
+
+    vmap.seen_count[v].assign(MAP_INDEX_SIZE, seen ? 1 : 0);
+    vmap.own_seen[v] = vmap.seen_count[v];
+    vmap.seen[v] = QBitArray(MAP_INDEX_SIZE, seen);
+  }
+  vision_layer_iterate_end;
+  vmap.own_seen_any = vmap.seen[V_MAIN];
 
   pplayer->tile_known->resize(MAP_INDEX_SIZE);
 }
@@ -1227,6 +1448,8 @@ void player_map_free(struct player *pplayer)
 
   whole_map_iterate(&(wld.map), ptile) { player_tile_free(ptile, pplayer); }
   whole_map_iterate_end;
+  known_sites[player_index(pplayer)].clear();
+  vision_maps[player_index(pplayer)] = player_vision_map();
 
   free(pplayer->server.private_map);
   pplayer->server.private_map = nullptr;
@@ -1261,7 +1484,7 @@ void remove_player_from_maps(struct player *pplayer)
       // Free vision sites (cities) for removed and other players
       if (aplrtile && aplrtile->site
           && vision_site_owner(aplrtile->site) == pplayer) {
-        change_playertile_site(aplrtile, nullptr);
+        map_set_player_site(ptile, aplayer, nullptr);
         changed = true;
       }
 
@@ -1295,7 +1518,8 @@ void remove_player_from_maps(struct player *pplayer)
       reality_changed = true;
     }
     if (extra_owner(ptile) == pplayer) {
-      ptile->extras_owner = nullptr;
+      tile_set_extras_owner(ptile, nullptr);
+      map_borders_tile_changed(ptile);
       reality_changed = true;
     }
 
@@ -1309,8 +1533,8 @@ void remove_player_from_maps(struct player *pplayer)
 }
 
 /**
-   We need to use fogofwar_old here, so the player's tiles get
-   in the same state as the other players' tiles.
+   Initialize the player tile. The seen counts are set up by
+   player_map_init().
  */
 static void player_tile_init(struct tile *ptile, struct player *pplayer)
 {
@@ -1327,11 +1551,6 @@ static void player_tile_init(struct tile *ptile, struct player *pplayer)
   } else {
     plrtile->last_updated = game.info.year;
   }
-
-  plrtile->seen_count[V_MAIN] = !game.server.fogofwar_old;
-  plrtile->seen_count[V_INVIS] = 0;
-  plrtile->seen_count[V_SUBSURFACE] = 0;
-  memcpy(plrtile->own_seen, plrtile->seen_count, sizeof(v_radius_t));
 }
 
 /**
@@ -1433,6 +1652,8 @@ void update_tile_knowledge(struct tile *ptile)
     return;
   }
 
+  explorer_tile_changed(ptile);
+
   // Players
   players_iterate(pplayer)
   {
@@ -1519,10 +1740,11 @@ static void really_give_tile_info_from_player_to_player(struct player *pfrom,
       // Set and send new city info
       if (from_tile->site) {
         if (!dest_tile->site) {
-          /* We cannot assign new vision site with change_playertile_site(),
-           * since location is not yet set up for new site */
-          dest_tile->site = vision_site_new(0, ptile, nullptr, nullptr);
-          *dest_tile->site = *from_tile->site;
+          struct vision_site *psite =
+              vision_site_new(0, ptile, nullptr, nullptr);
+
+          *psite = *from_tile->site;
+          map_set_player_site(ptile, pdest, psite);
         }
         /* Note that we don't care if receiver knows vision source city
          * or not. */
@@ -1541,11 +1763,16 @@ static void really_give_tile_info_from_player_to_player(struct player *pfrom,
 static void really_give_map_from_player_to_player(struct player *pfrom,
                                                   struct player *pdest)
 {
-  whole_map_iterate(&(wld.map), ptile)
-  {
-    really_give_tile_info_from_player_to_player(pfrom, pdest, ptile);
-  }
-  whole_map_iterate_end;
+  /* Only tiles known to pfrom and not both known and seen by pdest may
+   * change. */
+  const QBitArray &dest_seen = vision_maps[player_index(pdest)].seen[V_MAIN];
+  const QBitArray candidates =
+      *pfrom->tile_known & ~(*pdest->tile_known & dest_seen);
+
+  bitarray_iterate(candidates, [pfrom, pdest](int tindex) {
+    really_give_tile_info_from_player_to_player(
+        pfrom, pdest, index_to_tile(&(wld.map), tindex));
+  });
 
   city_thaw_workers_queue();
   sync_cities();
@@ -1651,19 +1878,20 @@ void give_shared_vision(struct player *pfrom, struct player *pto)
                        player_index(pplayer2))) {
         log_debug("really giving shared vision from %s to %s",
                   player_name(pplayer), player_name(pplayer2));
-        whole_map_iterate(&(wld.map), ptile)
-        {
-          const v_radius_t change =
-              V_RADIUS(map_get_own_seen(pplayer, ptile, V_MAIN),
-                       map_get_own_seen(pplayer, ptile, V_INVIS),
-                       map_get_own_seen(pplayer, ptile, V_SUBSURFACE));
-
-          if (0 < change[V_MAIN] || 0 < change[V_INVIS]) {
-            map_change_seen(pplayer2, ptile, change,
-                            map_is_known(ptile, pplayer));
-          }
-        }
-        whole_map_iterate_end;
+        bitarray_iterate(
+            vision_maps[player_index(pplayer)].own_seen_any,
+            [pplayer, pplayer2](int tindex) {
+              struct tile *ptile = index_to_tile(&(wld.map), tindex);
+              const v_radius_t change =
+                  V_RADIUS(map_get_own_seen(ptile, pplayer, V_MAIN),
+                           map_get_own_seen(ptile, pplayer, V_INVIS),
+                           map_get_own_seen(ptile, pplayer, V_SUBSURFACE));
+
+              if (0 < change[V_MAIN] || 0 < change[V_INVIS]) {
+                map_change_seen(pplayer2, ptile, change,
+                                map_is_known(ptile, pplayer));
+              }
+            });
 
         /* squares that are not seen, but which pfrom may have more recent
            knowledge of */
@@ -1717,18 +1945,19 @@ void remove_shared_vision(struct player *pfrom, struct player *pto)
                       player_index(pplayer2))) {
         log_debug("really removing shared vision from %s to %s",
                   player_name(pplayer), player_name(pplayer2));
-        whole_map_iterate(&(wld.map), ptile)
-        {
-          const v_radius_t change =
-              V_RADIUS(-map_get_own_seen(pplayer, ptile, V_MAIN),
-                       -map_get_own_seen(pplayer, ptile, V_INVIS),
-                       -map_get_own_seen(pplayer, ptile, V_SUBSURFACE));
-
-          if (0 > change[V_MAIN] || 0 > change[V_INVIS]) {
-            map_change_seen(pplayer2, ptile, change, false);
-          }
-        }
-        whole_map_iterate_end;
+        bitarray_iterate(
+            vision_maps[player_index(pplayer)].own_seen_any,
+            [pplayer, pplayer2](int tindex) {
+              struct tile *ptile = index_to_tile(&(wld.map), tindex);
+              const v_radius_t change =
+                  V_RADIUS(-map_get_own_seen(ptile, pplayer, V_MAIN),
+                           -map_get_own_seen(ptile, pplayer, V_INVIS),
+                           -map_get_own_seen(ptile, pplayer, V_SUBSURFACE));
+
+              if (0 > change[V_MAIN] || 0 > change[V_INVIS]) {
+                map_change_seen(pplayer2, ptile, change, false);
+              }
+            });
       }
     }
     players_iterate_end;
@@ -1955,6 +2184,7 @@ void check_terrain_change(struct tile *ptile, struct terrain *oldter)
   }
 
   fix_tile_on_terrain_change(ptile, oldter, true);
+  map_borders_tile_changed(ptile);
 
   // Check for saltwater filling freshwater lake
   if (game.scenario.lake_flooding && is_ocean(newter)
@@ -1979,6 +2209,8 @@ void check_terrain_change(struct tile *ptile, struct terrain *oldter)
   if (need_to_reassign_continents(oldter, newter)) {
     assign_continent_numbers();
     send_all_known_tiles(nullptr);
+    // Claimable tiles depend on continent numbers.
+    map_borders_invalidate();
   }
 
   claimer = tile_claimer(ptile);
@@ -2139,7 +2371,8 @@ void tile_claim_bases(struct tile *ptile, struct player *powner)
   /* This MUST be before potentially recursive call to map_claim_base(),
    * so that the recursive call will get new owner == base_loser and
    * abort recursion. */
-  ptile->extras_owner = powner;
+  tile_set_extras_owner(ptile, powner);
+  map_borders_tile_changed(ptile);
 
   extra_type_by_cause_iterate(EC_BASE, pextra)
   {
@@ -2148,6 +2381,145 @@ void tile_claim_bases(struct tile *ptile, struct player *powner)
   extra_type_by_cause_iterate_end;
 }
 
+/**
+   Returns the current inputs of the border source at ptile.
+ */
+static struct border_source border_source_inputs(struct tile *ptile,
+                                                 struct player *owner,
+                                                 int radius_sq)
+{
+  struct border_source source;
+  struct city *pcity = tile_city(ptile);
+
+  source.owner = owner;
+  source.radius_sq = radius_sq;
+  source.strength = tile_border_source_strength(ptile);
+  source.city_radius_sq =
+      pcity != nullptr ? city_map_radius_sq_get(pcity) : -1;
+  source.claim_ocean = owner != nullptr
+                       && num_known_tech_with_flag(owner, TF_CLAIM_OCEAN)
+                              > 0;
+  source.claim_ocean_limited =
+      owner != nullptr
+      && num_known_tech_with_flag(owner, TF_CLAIM_OCEAN_LIMITED) > 0;
+  source.unknown_tiles = false;
+
+  return source;
+}
+
+/**
+   Returns whether two sets of border source inputs give the same claim.
+ */
+static bool border_source_same(const struct border_source &a,
+                               const struct border_source &b)
+{
+  return a.owner == b.owner && a.radius_sq == b.radius_sq
+         && a.strength == b.strength && a.city_radius_sq == b.city_radius_sq
+         && a.claim_ocean == b.claim_ocean
+         && a.claim_ocean_limited == b.claim_ocean_limited;
+}
+
+/**
+   Mark the registered border sources whose claim may overlap a circle of
+   radius_sq around ptile, ptile itself excepted, as dirty.
+ */
+static void border_sources_mark_near(struct tile *ptile, int radius_sq)
+{
+  const int index = tile_index(ptile);
+  const double radius = std::sqrt(static_cast<double>(radius_sq));
+
+  if (!border_sources_valid) {
+    // Everything will be recalculated anyway.
+    return;
+  }
+
+  for (auto it = border_sources.cbegin(); it != border_sources.cend();
+       ++it) {
+    if (it.key() == index) {
+      continue;
+    }
+
+    const double reach =
+        radius + std::sqrt(static_cast<double>(it.value().radius_sq));
+
+    if (sq_map_distance(ptile, index_to_tile(&(wld.map), it.key()))
+        <= reach * reach) {
+      border_dirty.insert(it.key());
+    }
+  }
+}
+
+/**
+   Record the inputs of the border source at ptile after it claimed its
+   border. Neighbouring sources must claim again if the inputs changed:
+   they may win tiles back.
+ */
+static void border_source_register(struct tile *ptile, struct player *owner,
+                                   int radius_sq, bool unknown_tiles)
+{
+  const int index = tile_index(ptile);
+  struct border_source source =
+      border_source_inputs(ptile, owner, radius_sq);
+  auto old = border_sources.constFind(index);
+
+  source.unknown_tiles = unknown_tiles;
+  if (old == border_sources.cend()) {
+    border_sources_mark_near(ptile, radius_sq);
+  } else if (!border_source_same(*old, source)) {
+    border_sources_mark_near(ptile, MAX(radius_sq, old->radius_sq));
+  }
+
+  border_sources.insert(index, source);
+  border_dirty.remove(index);
+}
+
+/**
+   Forget the claim of the border source at ptile. The neighbouring sources
+   must claim again to pick up the tiles it releases.
+ */
+static void border_source_release(struct tile *ptile, int radius_sq)
+{
+  auto old = border_sources.constFind(tile_index(ptile));
+
+  if (old != border_sources.cend()) {
+    radius_sq = MAX(radius_sq, old->radius_sq);
+    border_sources.erase(old);
+  }
+  border_sources_mark_near(ptile, radius_sq);
+}
+
+/**
+   Forget all border sources. The next turn end recalculates all borders.
+   Call this when claims may have changed in ways the incremental update
+   can't track, such as continent renumbering.
+ */
+void map_borders_invalidate()
+{
+  border_sources.clear();
+  border_dirty.clear();
+  border_sources_valid = false;
+}
+
+/**
+   Mark the border sources whose claim may depend on ptile as dirty. Call
+   this when the terrain or the extras owner of the tile changes: the tile
+   may have become or stopped being a source, and is_claimable_ocean()
+   looks at the tiles adjacent to the claimed one.
+ */
+void map_borders_tile_changed(struct tile *ptile)
+{
+  if (!border_sources_valid) {
+    return;
+  }
+
+  if (is_border_source(ptile)
+      || border_sources.contains(tile_index(ptile))) {
+    border_dirty.insert(tile_index(ptile));
+  }
+  // Sources claiming the tile or one adjacent to it
+  border_sources_mark_near(ptile, 2);
+}
+
 /**
    Remove border for this source.
  */
@@ -2155,6 +2527,8 @@ void map_clear_border(struct tile *ptile)
 {
   int radius_sq = tile_border_source_radius_sq(ptile);
 
+  border_source_release(ptile, radius_sq);
+
   circle_dxyr_iterate(&(wld.map), ptile, radius_sq, dtile, dx, dy, dr)
   {
     struct tile *claimer = tile_claimer(dtile);
@@ -2185,6 +2559,10 @@ void map_update_border(struct tile *ptile, struct player *owner,
   if (old_radius_sq < new_radius_sq) {
     map_claim_border(ptile, owner, new_radius_sq);
   } else {
+    // Neighbours may claim the released tiles.
+    border_sources_mark_near(ptile, old_radius_sq);
+    border_dirty.insert(tile_index(ptile));
+
     circle_dxyr_iterate(&(wld.map), ptile, old_radius_sq, dtile, dx, dy, dr)
     {
       if (dr > new_radius_sq) {
@@ -2199,6 +2577,78 @@ void map_update_border(struct tile *ptile, struct player *owner,
   }
 }
 
+/**
+   Returns whether the border source at ptile, owned by owner, would claim
+   dtile, at square distance dr from it, in the current state of the map.
+   Sets *unknown_tile when the owner does not know dtile yet, so that it
+   has to be claimed again later.
+ */
+static bool border_source_claims_tile(struct tile *ptile,
+                                      struct player *owner,
+                                      struct tile *dtile, int dr,
+                                      bool *unknown_tile)
+{
+  struct tile *dclaimer = tile_claimer(dtile);
+
+  if (dclaimer == ptile) {
+    // Already claimed by the ptile
+    return false;
+  }
+
+  if (dr != 0 && is_border_source(dtile)) {
+    // Do not claim border sources other than self
+    /* Note that this is extremely important at the moment for
+     * base claiming to work correctly in case there's two
+     * fortresses near each other. There could be infinite
+     * recursion in them claiming each other. */
+    return false;
+  }
+
+  if (!map_is_known(dtile, owner) && game.info.borders < BORDERS_EXPAND) {
+    // To be claimed again once the owner knows the tile.
+    *unknown_tile = true;
+    return false;
+  }
+
+  // Always claim source itself (distance, dr, to it 0)
+  if (dr != 0 && nullptr != dclaimer && dclaimer != ptile) {
+    struct city *ccity = tile_city(dclaimer);
+    int strength_old, strength_new;
+
+    if (ccity != nullptr) {
+      // Previously claimed by city
+      int city_x, city_y;
+
+      map_distance_vector(&city_x, &city_y, ccity->tile, dtile);
+
+      if (map_vector_to_sq_distance(city_x, city_y)
+          <= city_map_radius_sq_get(ccity)
+                 + game.info.border_city_permanent_radius_sq) {
+        // Tile is within region permanently claimed by city
+        return false;
+      }
+    }
+
+    strength_old = tile_border_strength(dtile, dclaimer);
+    strength_new = tile_border_strength(dtile, ptile);
+
+    if (strength_new <= strength_old) {
+      /* Stronger shall prevail,
+       * in case of equal strength older shall prevail */
+      return false;
+    }
+  }
+
+  if (is_ocean_tile(dtile)) {
+    // Only certain water tiles are claimable
+    return is_claimable_ocean(dtile, ptile, owner);
+  } else {
+    /* Only land tiles on the same island as the border source
+     * are claimable */
+    return tile_continent(dtile) == tile_continent(ptile);
+  }
+}
+
 /**
    Update borders for this source. Call this for each new source.
 
@@ -2207,6 +2657,8 @@ void map_update_border(struct tile *ptile, struct player *owner,
 void map_claim_border(struct tile *ptile, struct player *owner,
                       int radius_sq)
 {
+  bool unknown_tiles = false;
+
   if (BORDERS_DISABLED == game.info.borders) {
     return;
   }
@@ -2225,73 +2677,20 @@ void map_claim_border(struct tile *ptile, struct player *owner,
 
   circle_dxyr_iterate(&(wld.map), ptile, radius_sq, dtile, dx, dy, dr)
   {
-    struct tile *dclaimer = tile_claimer(dtile);
-
-    if (dclaimer == ptile) {
-      // Already claimed by the ptile
-      continue;
-    }
-
-    if (dr != 0 && is_border_source(dtile)) {
-      // Do not claim border sources other than self
-      /* Note that this is extremely important at the moment for
-       * base claiming to work correctly in case there's two
-       * fortresses near each other. There could be infinite
-       * recursion in them claiming each other. */
-      continue;
-    }
-
-    if (!map_is_known(dtile, owner) && game.info.borders < BORDERS_EXPAND) {
-      continue;
-    }
-
-    // Always claim source itself (distance, dr, to it 0)
-    if (dr != 0 && nullptr != dclaimer && dclaimer != ptile) {
-      struct city *ccity = tile_city(dclaimer);
-      int strength_old, strength_new;
-
-      if (ccity != nullptr) {
-        // Previously claimed by city
-        int city_x, city_y;
-
-        map_distance_vector(&city_x, &city_y, ccity->tile, dtile);
-
-        if (map_vector_to_sq_distance(city_x, city_y)
-            <= city_map_radius_sq_get(ccity)
-                   + game.info.border_city_permanent_radius_sq) {
-          // Tile is within region permanently claimed by city
-          continue;
-        }
-      }
-
-      strength_old = tile_border_strength(dtile, dclaimer);
-      strength_new = tile_border_strength(dtile, ptile);
-
-      if (strength_new <= strength_old) {
-        /* Stronger shall prevail,
-         * in case of equal strength older shall prevail */
-        continue;
-      }
-    }
-
-    if (is_ocean_tile(dtile)) {
-      // Only certain water tiles are claimable
-      if (is_claimable_ocean(dtile, ptile, owner)) {
-        map_claim_ownership(dtile, owner, ptile, dr == 0);
-      }
-    } else {
-      /* Only land tiles on the same island as the border source
-       * are claimable */
-      if (tile_continent(dtile) == tile_continent(ptile)) {
-        map_claim_ownership(dtile, owner, ptile, dr == 0);
-      }
+    if (border_source_claims_tile(ptile, owner, dtile, dr,
+                                  &unknown_tiles)) {
+      map_claim_ownership(dtile, owner, ptile, dr == 0);
     }
   }
   circle_dxyr_iterate_end;
+
+  border_source_register(ptile, owner, radius_sq, unknown_tiles);
 }
 
 /**
-   Update borders for all sources. Call this on turn end.
+   Update borders for all sources, scanning the whole map for them. Call
+   this when sources may have changed without notice, e.g. after loading a
+   game.
  */
 void map_calculate_borders()
 {
@@ -2306,6 +2705,7 @@ void map_calculate_borders()
 
   qDebug("map_calculate_borders()");
 
+  map_borders_invalidate();
   whole_map_iterate(&(wld.map), ptile)
   {
     if (is_border_source(ptile)) {
@@ -2313,12 +2713,122 @@ void map_calculate_borders()
     }
   }
   whole_map_iterate_end;
+  border_dirty.clear();
+  border_sources_valid = true;
+  border_sources_mode = game.info.borders;
 
   qDebug("map_calculate_borders() workers");
   city_thaw_workers_queue();
   city_refresh_queue_processing();
 }
 
+/**
+   Update borders for the sources whose claim may have changed since the
+   last update. Falls back to map_calculate_borders() when the set of
+   sources isn't known. Call this on turn end.
+
+   A source claims again when one of its inputs (owner, radius, strength,
+   permanent city region, ocean claiming techs) changed, when it skipped
+   tiles unknown to its owner, when a neighbouring source changed or
+   released tiles, or when a tile it may claim changed, see
+   map_borders_tile_changed().
+ */
+void map_calculate_dirty_borders()
+{
+  if (BORDERS_DISABLED == game.info.borders) {
+    return;
+  }
+
+  if (wld.map.tiles == nullptr) {
+    // Map not yet initialized
+    return;
+  }
+
+  if (!border_sources_valid || border_sources_mode != game.info.borders) {
+    map_calculate_borders();
+    return;
+  }
+
+  qDebug("map_calculate_dirty_borders()");
+
+  // Find the sources that are gone or changed.
+  const auto indices = border_sources.keys();
+  for (int index : indices) {
+    struct tile *ptile = index_to_tile(&(wld.map), index);
+    const struct border_source source = border_sources.value(index);
+
+    if (!is_border_source(ptile)) {
+      border_source_release(ptile, source.radius_sq);
+    } else if (source.unknown_tiles
+               || !border_source_same(
+                   source, border_source_inputs(
+                               ptile, tile_owner(ptile),
+                               tile_border_source_radius_sq(ptile)))) {
+      border_dirty.insert(index);
+    }
+  }
+
+  /* Claim in tile order, like map_calculate_borders() does. Claims may
+   * mark more sources dirty. */
+  while (!border_dirty.isEmpty()) {
+    auto dirty = border_dirty.values();
+
+    border_dirty.clear();
+    std::sort(dirty.begin(), dirty.end());
+    for (int index : qAsConst(dirty)) {
+      struct tile *ptile = index_to_tile(&(wld.map), index);
+
+      if (is_border_source(ptile)) {
+        map_claim_border(ptile, ptile->owner, -1);
+      } else {
+        border_sources.remove(index);
+      }
+    }
+  }
+
+#ifdef FREECIV_DEBUG
+  {
+    /* Cross-check, without changing anything: a full pass would leave the
+     * map as it is iff no source changes a tile in the current state. */
+    int missed = 0;
+
+    whole_map_iterate(&(wld.map), ptile)
+    {
+      struct player *owner = tile_owner(ptile);
+      bool unknown_tiles = false;
+
+      if (!is_border_source(ptile)) {
+        continue;
+      }
+      fc_assert(owner == nullptr
+                || border_sources.contains(tile_index(ptile)));
+
+      circle_dxyr_iterate(&(wld.map), ptile,
+                          tile_border_source_radius_sq(ptile), dtile, dx,
+                          dy, dr)
+      {
+        if (owner == nullptr ? tile_claimer(dtile) == ptile
+                             : border_source_claims_tile(
+                                 ptile, owner, dtile, dr, &unknown_tiles)) {
+          missed++;
+        }
+      }
+      circle_dxyr_iterate_end;
+    }
+    whole_map_iterate_end;
+
+    if (missed > 0) {
+      qCritical("map_calculate_dirty_borders() missed %d tile claims.",
+                missed);
+    }
+  }
+#endif // FREECIV_DEBUG
+
+  qDebug("map_calculate_dirty_borders() workers");
+  city_thaw_workers_queue();
+  city_refresh_queue_processing();
+}
+
 /**
    Claim base to player's ownership.
  */
@@ -2434,11 +2944,45 @@ void map_claim_base(struct tile *ptile, const extra_type *pextra,
  */
 void vision_change_sight(struct vision *vision, const v_radius_t radius_sq)
 {
-  map_vision_update(vision->player, vision->tile, vision->radius_sq,
-                    radius_sq, vision->can_reveal_tiles);
+  map_vision_update_except(vision->player, vision->tile, vision->radius_sq,
+                           radius_sq, vision->can_reveal_tiles,
+                           vision->except_tile, vision->except_radius_sq);
   memcpy(vision->radius_sq, radius_sq, sizeof(v_radius_t));
 }
 
+/**
+   Fill out the sight of 'new_vision', which has none yet, taking over the
+   sight points of 'old_vision' where they overlap: only the tiles that
+   enter the sight are updated now, and clearing 'old_vision' afterwards
+   only updates the tiles that leave it.
+
+   See documentation in vision.h.
+ */
+void vision_move_sight(struct vision *old_vision, struct vision *new_vision,
+                       const v_radius_t radius_sq)
+{
+  fc_assert(-1 == new_vision->radius_sq[V_MAIN]);
+
+  if (old_vision == nullptr || old_vision->except_tile != nullptr
+      || new_vision->except_tile != nullptr
+      || -1 != new_vision->radius_sq[V_MAIN]
+      || old_vision->player != new_vision->player
+      || old_vision->can_reveal_tiles != new_vision->can_reveal_tiles) {
+    // Cannot hand over; count everything.
+    vision_change_sight(new_vision, radius_sq);
+    return;
+  }
+
+  map_vision_update_except(new_vision->player, new_vision->tile,
+                           new_vision->radius_sq, radius_sq,
+                           new_vision->can_reveal_tiles, old_vision->tile,
+                           old_vision->radius_sq);
+  memcpy(new_vision->radius_sq, radius_sq, sizeof(v_radius_t));
+
+  old_vision->except_tile = new_vision->tile;
+  memcpy(old_vision->except_radius_sq, radius_sq, sizeof(v_radius_t));
+}
+
 /**
    Clear all sight points from this vision source.
 
@@ -2512,7 +3056,8 @@ void create_extra(struct tile *ptile, const extra_type *pextra,
         }
         extra_type_by_cause_iterate_end;
 
-        ptile->extras_owner = pplayer;
+        tile_set_extras_owner(ptile, pplayer);
+        map_borders_tile_changed(ptile);
       }
     } else {
       // Player who already owns bases on tile claims new base
@@ -12,6 +12,8 @@
       \____/        ********************************************************/
 #pragma once
 
+#include <set>
+
 #include "fc_types.h"
 
 #include "map.h"
@@ -32,12 +34,6 @@ struct player_tile {
   struct player *extras_owner;
   bv_extras extras;
 
-  /* If you build a city with an unknown square within city radius
-     the square stays unknown. However, we still have to keep count
-     of the seen points, so they are kept in here. When the tile
-     then becomes known they are moved to seen. */
-  v_radius_t own_seen;
-  v_radius_t seen_count;
   short last_updated;
 };
 
@@ -92,6 +88,11 @@ struct vision_site *map_get_player_site(const struct tile *ptile,
                                         const struct player *pplayer);
 struct player_tile *map_get_player_tile(const struct tile *ptile,
                                         const struct player *pplayer);
+int map_get_seen_count(const struct tile *ptile,
+                       const struct player *pplayer,
+                       enum vision_layer vlayer);
+int map_get_own_seen(const struct tile *ptile, const struct player *pplayer,
+                     enum vision_layer vlayer);
 bool update_player_tile_knowledge(struct player *pplayer,
                                   struct tile *ptile);
 void update_tile_knowledge(struct tile *ptile);
@@ -108,6 +109,9 @@ void enable_fog_of_war_player(struct player *pplayer);
 void disable_fog_of_war_player(struct player *pplayer);
 
 void map_calculate_borders();
+void map_calculate_dirty_borders();
+void map_borders_invalidate();
+void map_borders_tile_changed(struct tile *ptile);
 void map_claim_border(struct tile *ptile, struct player *powner,
                       int radius_sq);
 void map_claim_ownership(struct tile *ptile, struct player *powner,
@@ -129,10 +133,13 @@ bool need_to_reassign_continents(const struct terrain *oldter,
 void bounce_units_on_terrain_change(struct tile *ptile);
 
 void vision_change_sight(struct vision *vision, const v_radius_t radius_sq);
+void vision_move_sight(struct vision *old_vision, struct vision *new_vision,
+                       const v_radius_t radius_sq);
 void vision_clear_sight(struct vision *vision);
 
-void change_playertile_site(struct player_tile *ptile,
-                            struct vision_site *new_site);
+void map_set_player_site(struct tile *ptile, struct player *pplayer,
+                         struct vision_site *new_site);
+const std::set<int> &map_get_player_sites(const struct player *pplayer);
 
 void create_extra(struct tile *ptile, const extra_type *pextra,
                   struct player *pplayer);
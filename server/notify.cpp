@@ -12,6 +12,11 @@
       \____/        ********************************************************/
 
 #include <cstdarg>
+#include <deque>
+
+// Qt
+#include <QByteArray>
+#include <QHash>
 
 // utility
 #include "bitvector.h"
@@ -460,99 +465,188 @@ void notify_research_embassies(const struct research *presearch,
 
 /**
   Event cache datas.
+
+  Events are kept oldest first in a bounded queue, capped both by the
+  'ec_max_size' and the 'ec_turns' settings. Each event gets a sequence
+  number; every recipient (everybody, the global observers and each player)
+  has an index of the sequence numbers of its events, so that replaying
+  them on reconnect doesn't need to look at the events of anybody else.
  */
 enum event_cache_target { ECT_ALL, ECT_PLAYERS, ECT_GLOBAL_OBSERVERS };
 
-// Events are saved in that structure.
+/* Events are saved in that structure. The message is kept apart from the
+ * rest of the packet so that it only takes the memory it needs. */
 struct event_cache_data {
-  struct packet_chat_msg packet;
+  QByteArray message;
+  int tile;
+  enum event_type event;
+  int packet_timestamp;
+  int phase;
+  int conn_id;
+  int turn;
   time_t timestamp;
   enum server_states server_state;
   enum event_cache_target target_type;
   bv_player target; // Used if target_type == ECT_PLAYERS.
 };
 
-#define SPECLIST_TAG event_cache_data
-#define SPECLIST_TYPE struct event_cache_data
-#include "speclist.h"
-#define event_cache_iterate(pdata)                                          \
-  TYPED_LIST_ITERATE(struct event_cache_data, event_cache, pdata)
-#define event_cache_iterate_end LIST_ITERATE_END
-
 struct event_cache_players {
   bv_player vector;
 };
 
+// Sequence numbers of the events sent to one recipient, oldest first.
+typedef std::deque<quint64> event_cache_index;
+
+struct event_cache_store {
+  std::deque<event_cache_data> events; // oldest first
+  quint64 first = 0;                   // sequence number of events.front()
+  event_cache_index all;
+  event_cache_index global_observers;
+  QHash<int, event_cache_index> players; // by player index
+};
+
 // The full list of the events.
-static struct event_cache_data_list *event_cache = nullptr;
+static struct event_cache_store *event_cache = nullptr;
 
 /* Event cache status: ON(TRUE) / OFF(FALSE); used for saving the
  * event cache */
 static bool event_cache_status = false;
 
 /**
-   Callback for freeing event cache data
+   Returns the maximal number of events in the cache.
  */
-static void event_cache_data_free(struct event_cache_data *data)
+static int event_cache_max_size()
 {
-  delete data;
+  return game.server.event_cache.max_size
+             ? game.server.event_cache.max_size
+             : GAME_MAX_EVENT_CACHE_MAX_SIZE;
 }
 
 /**
-   Creates a new event_cache_data, appened to the list.  It mays remove an
+   Drops the oldest event from the cache and from the indexes it is in.
+ */
+static void event_cache_pop_front()
+{
+  const struct event_cache_data &pdata = event_cache->events.front();
+  quint64 seq = event_cache->first;
+
+  switch (pdata.target_type) {
+  case ECT_ALL:
+    fc_assert(event_cache->all.front() == seq);
+    event_cache->all.pop_front();
+    break;
+  case ECT_GLOBAL_OBSERVERS:
+    fc_assert(event_cache->global_observers.front() == seq);
+    event_cache->global_observers.pop_front();
+    break;
+  case ECT_PLAYERS:
+    for (int i = 0; i < MAX_NUM_PLAYER_SLOTS; i++) {
+      if (BV_ISSET(pdata.target, i)) {
+        auto it = event_cache->players.find(i);
+
+        fc_assert_action(it != event_cache->players.end()
+                             && it->front() == seq,
+                         continue);
+        it->pop_front();
+        if (it->empty()) {
+          event_cache->players.erase(it);
+        }
+      }
+    }
+    break;
+  }
+
+  event_cache->events.pop_front();
+  event_cache->first++;
+}
+
+/**
+   Creates a new event_cache_data, appened to the cache.  It mays remove an
    old entry if needed.
  */
-static struct event_cache_data *
-event_cache_data_new(const struct packet_chat_msg *packet, time_t timestamp,
-                     enum server_states server_status,
-                     enum event_cache_target target_type,
-                     struct event_cache_players *players)
+static void event_cache_data_new(const struct packet_chat_msg *packet,
+                                 int turn, time_t timestamp,
+                                 enum server_states server_status,
+                                 enum event_cache_target target_type,
+                                 const bv_player *target)
 {
-  struct event_cache_data *pdata;
-  int max_events;
+  struct event_cache_data pdata;
+  quint64 seq;
 
   if (nullptr == event_cache) {
     /* Don't do log for this, because this could make an infinite
      * recursion. */
-    return nullptr;
+    return;
   }
-  fc_assert_ret_val(nullptr != packet, nullptr);
+  fc_assert_ret(nullptr != packet);
 
   if (packet->event == E_MESSAGE_WALL) {
     // No popups at save game load.
-    return nullptr;
+    return;
   }
 
   if (!game.server.event_cache.chat && packet->event == E_CHAT_MSG) {
     // chat messages should _not_ be saved
-    return nullptr;
+    return;
   }
 
   // check if cache is active
   if (!event_cache_status) {
-    return nullptr;
+    return;
   }
 
-  pdata = new event_cache_data;
-  pdata->packet = *packet;
-  pdata->timestamp = timestamp;
-  pdata->server_state = server_status;
-  pdata->target_type = target_type;
-  if (players) {
-    pdata->target = players->vector;
+  pdata.message = QByteArray(packet->message);
+  pdata.tile = packet->tile;
+  pdata.event = packet->event;
+  pdata.packet_timestamp = packet->timestamp;
+  pdata.phase = packet->phase;
+  pdata.conn_id = packet->conn_id;
+  pdata.turn = turn;
+  pdata.timestamp = timestamp;
+  pdata.server_state = server_status;
+  pdata.target_type = target_type;
+  if (target != nullptr) {
+    pdata.target = *target;
   } else {
-    BV_CLR_ALL(pdata->target);
+    BV_CLR_ALL(pdata.target);
   }
-  event_cache_data_list_append(event_cache, pdata);
 
-  max_events = game.server.event_cache.max_size
-                   ? game.server.event_cache.max_size
-                   : GAME_MAX_EVENT_CACHE_MAX_SIZE;
-  while (event_cache_data_list_size(event_cache) > max_events) {
-    event_cache_data_list_pop_front(event_cache);
+  seq = event_cache->first + event_cache->events.size();
+  switch (target_type) {
+  case ECT_ALL:
+    event_cache->all.push_back(seq);
+    break;
+  case ECT_GLOBAL_OBSERVERS:
+    event_cache->global_observers.push_back(seq);
+    break;
+  case ECT_PLAYERS:
+    for (int i = 0; i < MAX_NUM_PLAYER_SLOTS; i++) {
+      if (BV_ISSET(pdata.target, i)) {
+        event_cache->players[i].push_back(seq);
+      }
+    }
+    break;
   }
+  event_cache->events.push_back(std::move(pdata));
 
-  return pdata;
+  while (event_cache->events.size()
+         > static_cast<size_t>(event_cache_max_size())) {
+    event_cache_pop_front();
+  }
+}
+
+/**
+   Rebuilds the packet of a cached event.
+ */
+static void event_cache_packet(const struct event_cache_data &pdata,
+                               struct packet_chat_msg *packet)
+{
+  sz_strlcpy(packet->message, pdata.message.constData());
+  packet->tile = pdata.tile;
+  packet->event = pdata.event;
+  packet->timestamp = pdata.packet_timestamp;
+  packet->phase = pdata.phase;
+  packet->conn_id = pdata.conn_id;
 }
 
 /**
@@ -563,7 +657,7 @@ void event_cache_init()
   if (event_cache != nullptr) {
     event_cache_free();
   }
-  event_cache = event_cache_data_list_new_full(event_cache_data_free);
+  event_cache = new event_cache_store;
   event_cache_status = true;
 }
 
@@ -572,34 +666,40 @@ void event_cache_init()
  */
 void event_cache_free()
 {
-  if (event_cache != nullptr) {
-    event_cache_data_list_destroy(event_cache);
-    event_cache = nullptr;
-  }
+  delete event_cache;
+  event_cache = nullptr;
   event_cache_status = false;
 }
 
 /**
    Remove all events from the cache.
  */
-void event_cache_clear() { event_cache_data_list_clear(event_cache); }
+void event_cache_clear()
+{
+  if (event_cache != nullptr) {
+    *event_cache = event_cache_store();
+  }
+}
 
 /**
-   Remove the old events from the cache.
+   Remove the old events from the cache: those older than 'ec_turns' turns
+   and those beyond 'ec_max_size' if it was lowered.
  */
 void event_cache_remove_old()
 {
-  struct event_cache_data *current;
+  if (event_cache == nullptr) {
+    return;
+  }
 
   // This assumes that entries are in order, the ones to be removed first.
-  current = event_cache_data_list_get(event_cache, 0);
-
-  // Don't rm for now
-  //while (current != nullptr
-  //       && current->packet.timestamp <= time(nullptr)) {
-  //  event_cache_data_list_pop_front(event_cache);
-  //  current = event_cache_data_list_get(event_cache, 0);
-  //}
+  while (!event_cache->events.empty()
+         && (event_cache->events.front().turn
+                     + game.server.event_cache.turns
+                 <= game.info.turn
+             || event_cache->events.size()
+                    > static_cast<size_t>(event_cache_max_size()))) {
+    event_cache_pop_front();
+  }
 }
 
 /**
@@ -608,8 +708,8 @@ void event_cache_remove_old()
 void event_cache_add_for_all(const struct packet_chat_msg *packet)
 {
   if (0 < game.server.event_cache.turns) {
-    (void) event_cache_data_new(packet, time(nullptr), server_state(),
-                                ECT_ALL, nullptr);
+    event_cache_data_new(packet, game.info.turn, time(nullptr),
+                         server_state(), ECT_ALL, nullptr);
   }
 }
 
@@ -620,8 +720,8 @@ void event_cache_add_for_global_observers(
     const struct packet_chat_msg *packet)
 {
   if (0 < game.server.event_cache.turns) {
-    (void) event_cache_data_new(packet, time(nullptr), server_state(),
-                                ECT_GLOBAL_OBSERVERS, nullptr);
+    event_cache_data_new(packet, game.info.turn, time(nullptr),
+                         server_state(), ECT_GLOBAL_OBSERVERS, nullptr);
   }
 }
 
@@ -642,12 +742,12 @@ void event_cache_add_for_player(const struct packet_chat_msg *packet,
 
   if (0 < game.server.event_cache.turns
       && (server_state() > S_S_INITIAL || !game.info.is_new_game)) {
-    struct event_cache_data *pdata;
+    bv_player target;
 
-    pdata = event_cache_data_new(packet, time(nullptr), server_state(),
-                                 ECT_PLAYERS, nullptr);
-    fc_assert_ret(nullptr != pdata);
-    BV_SET(pdata->target, player_index(pplayer));
+    BV_CLR_ALL(target);
+    BV_SET(target, player_index(pplayer));
+    event_cache_data_new(packet, game.info.turn, time(nullptr),
+                         server_state(), ECT_PLAYERS, &target);
   }
 }
 
@@ -664,8 +764,8 @@ void event_cache_add_for_players(const struct packet_chat_msg *packet,
   if (0 < game.server.event_cache.turns && nullptr != players
       && BV_ISSET_ANY(players->vector)
       && (server_state() > S_S_INITIAL || !game.info.is_new_game)) {
-    (void) event_cache_data_new(packet, time(nullptr), server_state(),
-                                ECT_PLAYERS, players);
+    event_cache_data_new(packet, game.info.turn, time(nullptr),
+                         server_state(), ECT_PLAYERS, &players->vector);
   }
 
   if (nullptr != players) {
@@ -705,52 +805,97 @@ event_cache_player_add(struct event_cache_players *players,
 }
 
 /**
-   Returns whether the event may be displayed for the connection.
+   Send all available events.  If include_public is TRUE, also fully global
+   message will be sent.
+
+   Only the indexes of the recipients the connection stands for are read.
+   They are merged so that the events are sent in the order they happened.
  */
-static bool event_cache_match(const struct event_cache_data *pdata,
-                              const struct player *pplayer,
-                              bool is_global_observer, bool include_public)
+void send_pending_events(struct connection *pconn, bool include_public)
 {
-  //if (server_state() != pdata->server_state) {
-  //  return false;
-  //}
+  const struct player *pplayer = conn_get_player(pconn);
+  const event_cache_index *indexes[3];
+  event_cache_index::const_iterator positions[3];
+  struct packet_chat_msg pcm;
+  int count = 0;
 
-  if (server_state() == S_S_RUNNING && time(nullptr) < pdata->packet.timestamp
-      && time(nullptr) > pdata->packet.timestamp) {
-    return false;
+  if (event_cache == nullptr) {
+    return;
   }
 
-  switch (pdata->target_type) {
-  case ECT_ALL:
-    return include_public;
-  case ECT_PLAYERS:
-    return (nullptr != pplayer
-            && BV_ISSET(pdata->target, player_index(pplayer)));
-  case ECT_GLOBAL_OBSERVERS:
-    return is_global_observer;
+  if (include_public) {
+    indexes[count++] = &event_cache->all;
+  }
+  if (conn_is_global_observer(pconn)) {
+    indexes[count++] = &event_cache->global_observers;
   }
+  if (nullptr != pplayer) {
+    auto it = event_cache->players.constFind(player_index(pplayer));
+
+    if (it != event_cache->players.constEnd()) {
+      indexes[count++] = &it.value();
+    }
+  }
+
+  for (int i = 0; i < count; i++) {
+    positions[i] = indexes[i]->cbegin();
+  }
+
+  for (;;) {
+    int next = -1;
+
+    for (int i = 0; i < count; i++) {
+      if (positions[i] != indexes[i]->cend()
+          && (next < 0 || *positions[i] < *positions[next])) {
+        next = i;
+      }
+    }
+    if (next < 0) {
+      break;
+    }
 
-  return false;
+    event_cache_packet(
+        event_cache->events[*positions[next]++ - event_cache->first], &pcm);
+    notify_conn_packet(pconn->self, &pcm, false);
+  }
 }
 
 /**
-   Send all available events.  If include_public is TRUE, also fully global
-   message will be sent.
+   Fills 'stats' with the size of the event cache.
  */
-void send_pending_events(struct connection *pconn, bool include_public)
+void event_cache_get_stats(struct event_cache_stats *stats)
 {
-  const struct player *pplayer = conn_get_player(pconn);
-  bool is_global_observer = conn_is_global_observer(pconn);
-  struct packet_chat_msg pcm;
+  stats->events = 0;
+  stats->for_all = 0;
+  stats->for_global_observers = 0;
+  stats->for_players = 0;
+  stats->oldest_turn = -1;
+  stats->bytes = 0;
+
+  if (event_cache == nullptr) {
+    return;
+  }
 
-  event_cache_iterate(pdata)
-  {
-    if (event_cache_match(pdata, pplayer, is_global_observer,
-                          include_public)) {
-        notify_conn_packet(pconn->self, &pdata->packet, false);
-    }
+  stats->events = event_cache->events.size();
+  stats->for_all = event_cache->all.size();
+  stats->for_global_observers = event_cache->global_observers.size();
+  for (const auto &index : qAsConst(event_cache->players)) {
+    stats->for_players += index.size();
+  }
+  if (!event_cache->events.empty()) {
+    stats->oldest_turn = event_cache->events.front().turn;
+  }
+
+  stats->bytes = sizeof(*event_cache)
+                 + stats->events * sizeof(struct event_cache_data)
+                 + (stats->for_all + stats->for_global_observers
+                    + stats->for_players)
+                       * sizeof(quint64)
+                 + event_cache->players.size()
+                       * (sizeof(int) + sizeof(event_cache_index));
+  for (const auto &pdata : event_cache->events) {
+    stats->bytes += pdata.message.capacity();
   }
-  event_cache_iterate_end;
 }
 
 /**
@@ -762,7 +907,7 @@ void event_cache_load(struct section_file *file, const char *section)
   enum event_cache_target target_type;
   enum server_states server_status;
   struct event_cache_players *players = nullptr;
-  int i, x, y, event_count;
+  int i, x, y, event_count, turn;
   time_t timestamp, now;
   const char *p, *q;
 
@@ -811,6 +956,9 @@ void event_cache_load(struct section_file *file, const char *section)
         file, now, "%s.events%d.timestamp", section, i);
     packet.timestamp = timestamp;
 
+    turn = secfile_lookup_int_default(file, game.info.turn,
+                                      "%s.events%d.turn", section, i);
+
     p = secfile_lookup_str(file, "%s.events%d.server_state", section, i);
     if (nullptr == p) {
       qDebug("[Event cache %4d] Missing server state info.", i);
@@ -857,8 +1005,9 @@ void event_cache_load(struct section_file *file, const char *section)
     }
 
     // insert event into the cache
-    (void) event_cache_data_new(&packet, timestamp, server_status,
-                                target_type, players);
+    event_cache_data_new(&packet, turn, timestamp, server_status,
+                         target_type,
+                         players != nullptr ? &players->vector : nullptr);
     delete players;
     players = nullptr;
     qDebug("Event %4d loaded.", i);
@@ -872,13 +1021,14 @@ void event_cache_save(struct section_file *file, const char *section)
 {
   int event_count = 0;
 
+  fc_assert_ret(event_cache != nullptr);
+
   /* stop event logging; this way events from log_*() will not be added
    * to the event list while saving the event list */
   event_cache_status = false;
 
-  event_cache_iterate(pdata)
-  {
-    struct tile *ptile = index_to_tile(&(wld.map), pdata->packet.tile);
+  for (const auto &pdata : event_cache->events) {
+    struct tile *ptile = index_to_tile(&(wld.map), pdata.tile);
     char target[MAX_NUM_PLAYER_SLOTS + 1];
     char *p;
     int tile_x = -1, tile_y = -1;
@@ -887,25 +1037,27 @@ void event_cache_save(struct section_file *file, const char *section)
       index_to_map_pos(&tile_x, &tile_y, tile_index(ptile));
     }
 
-    if (pdata->packet.phase != PHASE_UNKNOWN) {
+    if (pdata.phase != PHASE_UNKNOWN) {
       /* Do not save current value of PHASE_UNKNOWN to savegame.
        * It practically means that "savegame had no phase stored".
        * Note that the only case where phase might be PHASE_UNKNOWN
        * may be present is that the event was loaded from previous
        * savegame created by a freeciv version that did not store event
        * phases. */
-      secfile_insert_int(file, pdata->packet.phase, "%s.events%d.phase",
+      secfile_insert_int(file, pdata.phase, "%s.events%d.phase",
                          section, event_count);
     }
-    secfile_insert_int(file, pdata->timestamp, "%s.events%d.timestamp",
+    secfile_insert_int(file, pdata.timestamp, "%s.events%d.timestamp",
                        section, event_count);
+    secfile_insert_int(file, pdata.turn, "%s.events%d.turn", section,
+                       event_count);
     secfile_insert_int(file, tile_x, "%s.events%d.x", section, event_count);
     secfile_insert_int(file, tile_y, "%s.events%d.y", section, event_count);
-    secfile_insert_str(file, server_states_name(pdata->server_state),
+    secfile_insert_str(file, server_states_name(pdata.server_state),
                        "%s.events%d.server_state", section, event_count);
-    secfile_insert_str(file, event_type_name(pdata->packet.event),
+    secfile_insert_str(file, event_type_name(pdata.event),
                        "%s.events%d.event", section, event_count);
-    switch (pdata->target_type) {
+    switch (pdata.target_type) {
     case ECT_ALL:
       fc_snprintf(target, sizeof(target), "All");
       break;
@@ -913,7 +1065,7 @@ void event_cache_save(struct section_file *file, const char *section)
       p = target;
       players_iterate(pplayer)
       {
-        *p++ = (BV_ISSET(pdata->target, player_index(pplayer)) ? '1' : '0');
+        *p++ = (BV_ISSET(pdata.target, player_index(pplayer)) ? '1' : '0');
       }
       players_iterate_end;
       *p = '\0';
@@ -924,14 +1076,13 @@ void event_cache_save(struct section_file *file, const char *section)
     }
     secfile_insert_str(file, target, "%s.events%d.target", section,
                        event_count);
-    secfile_insert_str(file, pdata->packet.message, "%s.events%d.message",
-                       section, event_count);
+    secfile_insert_str(file, pdata.message.constData(),
+                       "%s.events%d.message", section, event_count);
 
     qDebug("Event %4d saved.", event_count);
 
     event_count++;
   }
-  event_cache_iterate_end;
 
   // save the number of events in the event cache
   secfile_insert_int(file, event_count, "%s.count", section);
@@ -946,11 +1097,13 @@ void event_cache_save(struct section_file *file, const char *section)
  */
 void event_cache_phases_invalidate()
 {
-  event_cache_iterate(pdata)
-  {
-    if (pdata->packet.phase >= 0) {
-      pdata->packet.phase = PHASE_INVALIDATED;
+  if (event_cache == nullptr) {
+    return;
+  }
+
+  for (auto &pdata : event_cache->events) {
+    if (pdata.phase >= 0) {
+      pdata.phase = PHASE_INVALIDATED;
     }
   }
-  event_cache_iterate_end;
 }
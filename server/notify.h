@@ -97,6 +97,18 @@ void event_cache_add_for_players(const struct packet_chat_msg *packet,
 
 void send_pending_events(struct connection *pconn, bool include_public);
 
+// Size of the event cache, see '/list events'.
+struct event_cache_stats {
+  int events;
+  int for_all;
+  int for_global_observers;
+  int for_players; // Counted once for each recipient player
+  int oldest_turn; // -1 if there are no events
+  size_t bytes;
+};
+
+void event_cache_get_stats(struct event_cache_stats *stats);
+
 void event_cache_phases_invalidate();
 
 struct section_file;
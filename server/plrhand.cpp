@@ -237,7 +237,8 @@ void kill_player(struct player *pplayer)
       map_claim_ownership(ptile, nullptr, nullptr, false);
     }
     if (extra_owner(ptile) == pplayer) {
-      ptile->extras_owner = nullptr;
+      tile_set_extras_owner(ptile, nullptr);
+      map_borders_tile_changed(ptile);
     }
   }
   whole_map_iterate_end;
@@ -701,7 +702,8 @@ static void maybe_claim_base(struct tile *ptile, struct player *new_owner,
     }
     extra_type_by_cause_iterate_end;
 
-    ptile->extras_owner = new_owner;
+    tile_set_extras_owner(ptile, new_owner);
+    map_borders_tile_changed(ptile);
   }
 }
 
@@ -1786,6 +1788,9 @@ void server_remove_player(struct player *pplayer)
 
   qInfo(_("Removing player %s."), player_name(pplayer));
 
+  // Map images being drawn may refer to the player.
+  mapimg_server_wait();
+
   notify_conn(pplayer->connections, nullptr, E_CONNECTION, ftc_server,
               _("You've been removed from the game!"));
 
@@ -15,6 +15,9 @@
 #include <cstdlib>
 #include <cstring>
 
+// Qt
+#include <QCryptographicHash>
+
 #include "bitvector.h"
 #include "deprecations.h"
 #include "fcintl.h"
@@ -28,6 +31,7 @@
 #include "actions.h"
 #include "ai.h"
 #include "base.h"
+#include "capstr.h"
 #include "city.h"
 #include "effects.h"
 #include "extras.h"
@@ -112,6 +116,9 @@ static char (*road_sections)[MAX_SECTION_LABEL] = nullptr;
 
 static struct requirement_vector reqs_list;
 
+// See ruleset_cache_hash(). Empty until computed.
+static QByteArray ruleset_stream_hash;
+
 static bool load_rulesetdir(const char *rsdir, bool compat_mode,
                             rs_conversion_logger logger, bool act,
                             bool buffer_script, bool load_luadata);
@@ -8603,6 +8610,8 @@ bool load_rulesets(const char *restore, const char *alt, bool compat_mode,
                    rs_conversion_logger logger, bool act, bool buffer_script,
                    bool load_luadata)
 {
+  ruleset_stream_hash.clear();
+
   if (load_rulesetdir(game.server.rulesetdir, compat_mode, logger, act,
                       buffer_script, load_luadata)) {
     return true;
@@ -8904,6 +8913,44 @@ bool reload_rulesets_settings()
   return ok;
 }
 
+/**
+   Returns a hash of the packets send_rulesets() sends to a new connection,
+   as hexadecimal digits. Clients with the "ruleset-cache" capability keep
+   the ruleset packets they received under this hash, so that they don't
+   need them again as long as the rulesets are the same.
+
+   The packets are encoded once for a connection that sends nothing, and
+   kept until the rulesets are loaded again.
+ */
+const char *ruleset_cache_hash()
+{
+  if (ruleset_stream_hash.isEmpty()) {
+    struct connection scratch {};
+    QByteArray stream;
+
+    connection_common_init(&scratch);
+    conn_set_capability(&scratch, our_capability);
+    // Same header as after the login protocol.
+    packet_header_set(&scratch.packet_header);
+    scratch.self = conn_list_new();
+    conn_list_append(scratch.self, &scratch);
+    scratch.packet_capture = &stream;
+
+    send_rulesets(scratch.self);
+
+    conn_list_destroy(scratch.self);
+    connection_common_close(&scratch);
+
+    ruleset_stream_hash =
+        QCryptographicHash::hash(stream, QCryptographicHash::Sha256)
+            .toHex();
+    log_debug("Ruleset packets: %d bytes, hash %s", stream.size(),
+              ruleset_stream_hash.constData());
+  }
+
+  return ruleset_stream_hash.constData();
+}
+
 /**
    Send all ruleset information to the specified connections.
  */
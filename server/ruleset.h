@@ -48,6 +48,7 @@ bool load_rulesets(const char *restore, const char *alt, bool compat_mode,
                    bool load_luadata);
 bool reload_rulesets_settings();
 void send_rulesets(struct conn_list *dest);
+const char *ruleset_cache_hash();
 
 void rulesets_deinit();
 
@@ -121,22 +121,23 @@ static void check_fow(const char *file, const char *function, int line)
   {
     players_iterate(pplayer)
     {
-      struct player_tile *plr_tile = map_get_player_tile(ptile, pplayer);
-
       vision_layer_iterate(v)
       {
+        int seen = map_get_seen_count(ptile, pplayer, v);
+        int own_seen = map_get_own_seen(ptile, pplayer, v);
+
         // underflow of unsigned int
-        SANITY_TILE(ptile, plr_tile->seen_count[v] < 30000);
-        SANITY_TILE(ptile, plr_tile->own_seen[v] < 30000);
-        SANITY_TILE(ptile, plr_tile->own_seen[v] <= plr_tile->seen_count[v]);
+        SANITY_TILE(ptile, seen < 30000);
+        SANITY_TILE(ptile, own_seen < 30000);
+        SANITY_TILE(ptile, own_seen <= seen);
       }
       vision_layer_iterate_end;
 
       // Lots of server bits depend on this.
-      SANITY_TILE(ptile, plr_tile->seen_count[V_INVIS]
-                             <= plr_tile->seen_count[V_MAIN]);
-      SANITY_TILE(ptile,
-                  plr_tile->own_seen[V_INVIS] <= plr_tile->own_seen[V_MAIN]);
+      SANITY_TILE(ptile, map_get_seen_count(ptile, pplayer, V_INVIS)
+                             <= map_get_seen_count(ptile, pplayer, V_MAIN));
+      SANITY_TILE(ptile, map_get_own_seen(ptile, pplayer, V_INVIS)
+                             <= map_get_own_seen(ptile, pplayer, V_MAIN));
     }
     players_iterate_end;
   }
@@ -4663,8 +4663,7 @@ static void sg_load_player_vision(struct loaddata *loading,
 
     pdcity = vision_site_new(0, nullptr, nullptr, nullptr);
     if (sg_load_player_vision_city(loading, plr, pdcity, buf)) {
-      change_playertile_site(map_get_player_tile(pdcity->location, plr),
-                             pdcity);
+      map_set_player_site(pdcity->location, plr, pdcity);
       identity_number_reserve(pdcity->identity);
     } else {
       // Error loading the data.
@@ -121,6 +121,7 @@
 #include "sanitycheck.h"
 #include "savecompat.h"
 #include "settings.h"
+#include "snapshot.h"
 #include "spacerace.h"
 #include "srv_main.h"
 #include "techtools.h"
@@ -267,6 +268,9 @@ struct savedata {
 
   // Set in sg_save_game(); needed in sg_save_map_*(); ...
   bool save_players;
+
+  // The state of the map when the saving started.
+  struct snapshot *snapshot;
 };
 
 #define TOKEN_SIZE 10
@@ -655,13 +659,19 @@ static struct savedata *savedata_new(struct section_file *file,
 
   saving->save_players = false;
 
+  saving->snapshot = snapshot_take(false);
+
   return saving;
 }
 
 /**
    Free resources allocated for savedata item
  */
-static void savedata_destroy(struct savedata *saving) { free(saving); }
+static void savedata_destroy(struct savedata *saving)
+{
+  snapshot_free(saving->snapshot);
+  free(saving);
+}
 
 /* =======================================================================
  * Helper functions.
@@ -2857,8 +2867,9 @@ static void sg_save_map_tiles(struct savedata *saving)
   sg_check_ret();
 
   // Save the terrain type.
-  SAVE_MAP_CHAR(ptile, terrain2char(ptile->terrain), saving->file,
-                "map.t%04d");
+  SAVE_MAP_CHAR(ptile,
+                terrain2char(snapshot_tile_terrain(saving->snapshot, ptile)),
+                saving->file, "map.t%04d");
 
   // Save special tile sprites.
   whole_map_iterate(&(wld.map), ptile)
@@ -3269,11 +3280,12 @@ static void sg_save_map_owner(struct savedata *saving)
       char token[TOKEN_SIZE];
       struct tile *ptile = native_pos_to_tile(&(wld.map), x, y);
 
-      if (!saving->save_players || tile_owner(ptile) == nullptr) {
+      struct player *owner = snapshot_tile_owner(saving->snapshot, ptile);
+
+      if (!saving->save_players || owner == nullptr) {
         qstrcpy(token, "-");
       } else {
-        fc_snprintf(token, sizeof(token), "%d",
-                    player_number(tile_owner(ptile)));
+        fc_snprintf(token, sizeof(token), "%d", player_number(owner));
       }
       strcat(line, token);
       if (x + 1 < wld.map.xsize) {
@@ -3291,10 +3303,12 @@ static void sg_save_map_owner(struct savedata *saving)
       char token[TOKEN_SIZE];
       struct tile *ptile = native_pos_to_tile(&(wld.map), x, y);
 
-      if (ptile->claimer == nullptr) {
+      struct tile *claimer = snapshot_tile_claimer(saving->snapshot, ptile);
+
+      if (claimer == nullptr) {
         qstrcpy(token, "-");
       } else {
-        fc_snprintf(token, sizeof(token), "%d", tile_index(ptile->claimer));
+        fc_snprintf(token, sizeof(token), "%d", tile_index(claimer));
       }
       strcat(line, token);
       if (x + 1 < wld.map.xsize) {
@@ -3312,11 +3326,13 @@ static void sg_save_map_owner(struct savedata *saving)
       char token[TOKEN_SIZE];
       struct tile *ptile = native_pos_to_tile(&(wld.map), x, y);
 
-      if (!saving->save_players || extra_owner(ptile) == nullptr) {
+      struct player *owner =
+          snapshot_tile_extras_owner(saving->snapshot, ptile);
+
+      if (!saving->save_players || owner == nullptr) {
         qstrcpy(token, "-");
       } else {
-        fc_snprintf(token, sizeof(token), "%d",
-                    player_number(extra_owner(ptile)));
+        fc_snprintf(token, sizeof(token), "%d", player_number(owner));
       }
       strcat(line, token);
       if (x + 1 < wld.map.xsize) {
@@ -7093,8 +7109,7 @@ static void sg_load_player_vision(struct loaddata *loading,
 
     pdcity = vision_site_new(0, nullptr, nullptr, nullptr);
     if (sg_load_player_vision_city(loading, plr, pdcity, buf)) {
-      change_playertile_site(map_get_player_tile(pdcity->location, plr),
-                             pdcity);
+      map_set_player_site(pdcity->location, plr, pdcity);
       identity_number_reserve(pdcity->identity);
     } else {
       // Error loading the data.
@@ -8,9 +8,11 @@
  see https://www.gnu.org/licenses/.
  */
 
+#include <algorithm>
 #include <cstdarg>
 #include <ctime>
 #include <sys/stat.h>
+#include <vector>
 
 /* dependencies/lua */
 extern "C" {
@@ -21,13 +23,18 @@ extern "C" {
 #include "tolua.h"
 }
 // utility
+#include "fcintl.h"
 #include "log.h"
 #include "registry.h"
 
+// common
+#include "game.h"
+
 /* common/scriptcore */
 #include "api_game_specenum.h"
 #include "luascript.h"
 #include "luascript_func.h"
+#include "luascript_profile.h"
 #include "luascript_signal.h"
 #include "tolua_game_gen.h"
 #include "tolua_signal_gen.h"
@@ -46,6 +53,15 @@ extern "C" {
 static struct fc_lua *fcl_main = nullptr;
 static struct fc_lua *fcl_unsafe = nullptr;
 
+// Names of the signals of enum script_signal
+static const char *const script_signal_names[SCRIPT_SIGNAL_COUNT] = {
+    "unit_moved",
+    "city_built",
+    "pulse",
+};
+// Their ids in fcl_main, resolved once by script_server_init()
+static int script_signal_ids[SCRIPT_SIGNAL_COUNT];
+
 /**
    Optional game script code (useful for scenarios).
  */
@@ -304,10 +320,17 @@ bool script_server_init()
 
   luascript_signal_init(fcl_main);
   script_server_signals_create();
+  for (int i = 0; i < SCRIPT_SIGNAL_COUNT; i++) {
+    script_signal_ids[i] =
+        luascript_signal_id(fcl_main, script_signal_names[i]);
+    fc_assert(script_signal_ids[i] >= 0);
+  }
 
   luascript_func_init(fcl_main);
   script_server_functions_define();
 
+  script_server_apply_limits();
+
   // Add the unsafe instance.
   fcl_unsafe = luascript_new(nullptr, false);
   if (fcl_unsafe == nullptr) {
@@ -343,6 +366,9 @@ void script_server_free()
     // luascript_signal_free() is called by luascript_destroy().
     luascript_destroy(fcl_main);
     fcl_main = nullptr;
+    for (int i = 0; i < SCRIPT_SIGNAL_COUNT; i++) {
+      script_signal_ids[i] = -1;
+    }
   }
 
   if (fcl_unsafe != nullptr) {
@@ -385,6 +411,188 @@ void script_server_signal_emit(const char *signal_name, ...)
   va_end(args);
 }
 
+/**
+   Invoke all the callback functions attached to a given signal, without
+   looking it up by name. Does nothing if no callback is attached.
+ */
+void script_server_signal_emit_id(enum script_signal signal, ...)
+{
+  va_list args;
+
+  if (!script_server_signal_has_callbacks(signal)) {
+    return;
+  }
+
+  va_start(args, signal);
+  luascript_signal_emit_id_valist(fcl_main, script_signal_ids[signal],
+                                  args);
+  va_end(args);
+}
+
+/**
+   Returns whether the scripts connected any callback to the signal. Hot
+   paths use it to skip the work of preparing an emission nobody listens
+   to.
+ */
+bool script_server_signal_has_callbacks(enum script_signal signal)
+{
+  fc_assert_ret_val(signal >= 0 && signal < SCRIPT_SIGNAL_COUNT, false);
+
+  if (fcl_main == nullptr) {
+    return false;
+  }
+
+  return luascript_signal_has_callbacks(fcl_main, script_signal_ids[signal]);
+}
+
+/**
+   Show how often each signal was emitted and how much time its callbacks
+   took, most expensive first.
+ */
+void script_server_signal_report(struct connection *caller)
+{
+  std::vector<const struct signal *> signals;
+
+  fc_assert_ret(fcl_main != nullptr);
+
+  for (int i = 0;; i++) {
+    const struct signal *psignal = luascript_signal_get(fcl_main, i);
+
+    if (psignal == nullptr) {
+      break;
+    }
+    if (psignal->emits > 0 || !psignal->callbacks->isEmpty()) {
+      signals.push_back(psignal);
+    }
+  }
+
+  std::stable_sort(signals.begin(), signals.end(),
+                   [](const struct signal *a, const struct signal *b) {
+                     return a->nsecs > b->nsecs;
+                   });
+
+  cmd_reply(CMD_LUA, caller, C_COMMENT, _("Lua signals:"));
+  cmd_reply(CMD_LUA, caller, C_COMMENT, "%-32s %9s %9s %9s %10s",
+            _("Signal"), _("Handlers"), _("Emitted"), _("Calls"),
+            _("Time (ms)"));
+  for (const auto *psignal : signals) {
+    cmd_reply(CMD_LUA, caller, C_COMMENT, "%-32s %9d %9d %9d %10.2f",
+              psignal->name, static_cast<int>(psignal->callbacks->size()),
+              psignal->emits, psignal->calls, psignal->nsecs / 1e6);
+  }
+  if (signals.empty()) {
+    cmd_reply(CMD_LUA, caller, C_COMMENT, _("No signal was emitted."));
+  }
+}
+
+/**
+   Clear the signal statistics shown by script_server_signal_report().
+ */
+void script_server_signal_stats_reset()
+{
+  luascript_signal_stats_reset(fcl_main);
+}
+
+/**
+   Apply the 'luatimelimit' and 'luainstrlimit' settings to the ruleset and
+   scenario scripts. The unsafe instance, only usable by admins, keeps the
+   default limits.
+ */
+void script_server_apply_limits()
+{
+  if (fcl_main != nullptr) {
+    luascript_set_limits(
+        fcl_main, game.server.luatimelimit,
+        static_cast<qint64>(game.server.luainstrlimit) * 1000);
+  }
+}
+
+/**
+   Start or stop profiling the ruleset and scenario scripts.
+ */
+void script_server_profile_set_enabled(bool enabled)
+{
+  fc_assert_ret(fcl_main != nullptr);
+
+  luascript_profile_set_enabled(fcl_main, enabled);
+  if (enabled) {
+    luascript_profile_new_period(fcl_main);
+  }
+}
+
+/**
+   Returns whether the scripts are being profiled.
+ */
+bool script_server_profile_enabled()
+{
+  return luascript_profile_enabled(fcl_main);
+}
+
+/**
+   Drop the collected profile data.
+ */
+void script_server_profile_reset()
+{
+  fc_assert_ret(fcl_main != nullptr);
+
+  luascript_profile_reset(fcl_main);
+}
+
+/**
+   Start collecting the profile data of a new turn.
+ */
+void script_server_profile_new_turn()
+{
+  if (luascript_profile_enabled(fcl_main)) {
+    luascript_profile_new_period(fcl_main);
+  }
+}
+
+/**
+   Show the most expensive signal handlers, Lua functions and source lines
+   of the last 'turns' turns.
+ */
+void script_server_profile_report(struct connection *caller, int turns)
+{
+  const int count = 10;
+
+  fc_assert_ret(fcl_main != nullptr);
+
+  cmd_reply(CMD_LUAPROFILE, caller, C_COMMENT,
+            PL_("Lua profile of the last turn:",
+                "Lua profile of the last %d turns:", turns),
+            turns);
+
+  const auto handlers =
+      luascript_profile_top(fcl_main, LPK_HANDLER, turns, count);
+  cmd_reply(CMD_LUAPROFILE, caller, C_COMMENT, "%-40s %9s %10s",
+            _("Handler"), _("Calls"), _("Time (ms)"));
+  for (const auto &entry : handlers) {
+    cmd_reply(CMD_LUAPROFILE, caller, C_COMMENT, "%-40s %9d %10.2f",
+              qUtf8Printable(entry.name), entry.stats.calls,
+              entry.stats.nsecs / 1e6);
+  }
+
+  for (auto kind : {LPK_FUNCTION, LPK_LINE}) {
+    const auto entries = luascript_profile_top(fcl_main, kind, turns, count);
+
+    cmd_reply(CMD_LUAPROFILE, caller, C_COMMENT, "%-40s %9s",
+              kind == LPK_FUNCTION ? _("Function") : _("Line"),
+              _("Samples"));
+    for (const auto &entry : entries) {
+      cmd_reply(CMD_LUAPROFILE, caller, C_COMMENT, "%-40s %9lld",
+                qUtf8Printable(entry.name),
+                static_cast<long long>(entry.stats.samples));
+    }
+  }
+
+  if (!luascript_profile_enabled(fcl_main)) {
+    cmd_reply(CMD_LUAPROFILE, caller, C_COMMENT,
+              _("The profiler is off. Use '%sluaprofile on' to start it."),
+              caller ? "/" : "");
+  }
+}
+
 /**
    Declare any new signal types you need here.
  */
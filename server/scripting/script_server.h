@@ -38,8 +38,28 @@ bool script_server_unsafe_do_file(struct connection *caller,
 void script_server_state_load(struct section_file *file);
 void script_server_state_save(struct section_file *file);
 
+// Signals emitted often enough to be looked up by id.
+enum script_signal {
+  SCRIPT_SIGNAL_UNIT_MOVED,
+  SCRIPT_SIGNAL_CITY_BUILT,
+  SCRIPT_SIGNAL_PULSE,
+  SCRIPT_SIGNAL_COUNT
+};
+
 // Signals.
 void script_server_signal_emit(const char *signal_name, ...);
+void script_server_signal_emit_id(enum script_signal signal, ...);
+bool script_server_signal_has_callbacks(enum script_signal signal);
+void script_server_signal_report(struct connection *caller);
+void script_server_signal_stats_reset();
 
 // Functions
 bool script_server_call(const char *func_name, ...);
+
+// Execution limits and profiling.
+void script_server_apply_limits();
+void script_server_profile_set_enabled(bool enabled);
+bool script_server_profile_enabled();
+void script_server_profile_reset();
+void script_server_profile_new_turn();
+void script_server_profile_report(struct connection *caller, int turns);
@@ -332,6 +332,7 @@ int server_make_connection(QTcpSocket *new_sock, const QString &client_addr)
       pconn->server.ignore_list =
           conn_pattern_list_new_full(conn_pattern_destroy);
       pconn->server.is_closing = false;
+      pconn->server.ruleset_cache_offered = false;
       pconn->ping_time = -1.0;
       pconn->incoming_packet_notify = nullptr;
       pconn->outgoing_packet_notify = nullptr;
@@ -476,30 +477,6 @@ static void finish_processing_request(struct connection *pconn)
   conn_compression_thaw(pconn);
 }
 
-/**
- * Process all unit waits that are expired.
- */
-void finish_unit_waits()
-{
-  time_t now = time(NULL);
-  struct unit *punit;
-  struct unit_wait *head;
-
-  while ((head = unit_wait_list_front(server.unit_waits))
-         && head->wake_up < now) {
-
-    punit = game_unit_by_number(head->id);
-    if (!punit) {
-      /* Unit doesn't exist anymore. */
-      continue;
-    }
-    if (head->activity == punit->activity) {
-      finish_unit_wait(punit, head->activity_count);
-    }
-    unit_wait_list_pop_front(server.unit_waits);
-  }
-}
-
 /**
    Ping a connection.
  */
@@ -70,6 +70,7 @@
 #include "script_server.h" // scripting
 #include "sernet.h"
 #include "settings.h"
+#include "snapshot.h"
 #include "srv_main.h"
 #include "stdinhand.h"
 #include "timing.h"
@@ -103,6 +104,8 @@ void handle_readline_input_callback(char *line)
 }
 #endif // !Q_OS_WIN
 
+} // anonymous namespace
+
 /**
    Initialize server specific functions.
  */
@@ -126,6 +129,8 @@ void fc_interface_init_server()
   fc_interface_init();
 }
 
+namespace {
+
 /**
    Server initialization.
  */
@@ -772,16 +777,24 @@ void server::begin_phase()
     m_save_counter++;
 
     if (!m_skip_mapimg) {
-      // Save map image(s).
+      /* Save map image(s). They are drawn on a background thread, from a
+       * snapshot of the game. */
+      struct mapimg_batch *batch = mapimg_batch_new(
+          qUtf8Printable(srvarg.saves_pathname));
+
       for (int i = 0; i < mapimg_count(); i++) {
         struct mapdef *pmapdef = mapimg_isvalid(i);
-        if (pmapdef != nullptr) {
-          mapimg_create(pmapdef, false, game.server.save_name,
-                        qUtf8Printable(srvarg.saves_pathname));
-        } else {
+        if (pmapdef == nullptr
+            || !mapimg_batch_add(batch, pmapdef, false,
+                                 game.server.save_name)) {
           qCritical("%s", mapimg_error());
         }
       }
+      if (mapimg_batch_size(batch) > 0) {
+        mapimg_server_start(snapshot_take(true), batch);
+      } else {
+        mapimg_batch_destroy(batch);
+      }
     } else {
       m_skip_mapimg = false;
     }
@@ -1071,10 +1084,8 @@ void server::pulse()
     }
     conn_list_iterate_end
 
-    finish_unit_waits();
-
     call_ai_refresh();
-    script_server_signal_emit("pulse");
+    script_server_signal_emit_id(SCRIPT_SIGNAL_PULSE);
     (void) send_server_info_to_metaserver(META_REFRESH);
   }
   iter += 1;
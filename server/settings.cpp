@@ -35,6 +35,9 @@
 #include "srv_main.h"
 #include "stdinhand.h"
 
+/* server/scripting */
+#include "script_server.h"
+
 /* The following classes determine what can be changed when. Actually, some
  * of them have the same "changeability", but different types are separated
  * here in case they have other uses. Also, SSET_GAME_INIT/SSET_RULES
@@ -638,6 +641,15 @@ static void scorelog_action(const struct setting *pset)
   }
 }
 
+/**
+   Apply the script execution limits.
+ */
+static void luascript_limits_action(const struct setting *pset)
+{
+  Q_UNUSED(pset)
+  script_server_apply_limits();
+}
+
 /**
    Create the selected number of AI's.
  */
@@ -2959,6 +2971,38 @@ static struct setting settings[] = {
                 "are not required to wait for the save to finish."),
              nullptr, nullptr, GAME_DEFAULT_THREADED_SAVE),
 
+    GEN_BOOL("threaded_arrange", game.server.threaded_arrange, SSET_META,
+             SSET_INTERNAL, SSET_RARE, ALLOW_HACK, ALLOW_HACK,
+             N_("Whether to arrange city workers in separate threads"),
+             N_("If this is turned on and many cities need their workers "
+                "rearranged at once (e.g. after borders changed), cities "
+                "that share no workable tile and no trade route are "
+                "arranged in parallel. This only speeds things up on "
+                "machines with several cores."),
+             nullptr, nullptr, GAME_DEFAULT_THREADED_ARRANGE),
+
+    GEN_INT("luatimelimit", game.server.luatimelimit, SSET_META,
+            SSET_INTERNAL, SSET_RARE, ALLOW_HACK, ALLOW_HACK,
+            N_("Maximum run time of a scenario script call (milliseconds)"),
+            N_("A script handler or command that runs longer than this "
+               "is aborted with an error, so that a runaway scenario "
+               "script doesn't stall the game. 0 means no limit."),
+            nullptr, nullptr, luascript_limits_action,
+            GAME_MIN_LUATIMELIMIT, GAME_MAX_LUATIMELIMIT,
+            GAME_DEFAULT_LUATIMELIMIT),
+
+    GEN_INT("luainstrlimit", game.server.luainstrlimit, SSET_META,
+            SSET_INTERNAL, SSET_RARE, ALLOW_HACK, ALLOW_HACK,
+            N_("Maximum number of Lua instructions in a script call "
+               "(thousands)"),
+            N_("A script handler or command that executes more virtual "
+               "machine instructions than this is aborted with an error. "
+               "Unlike 'luatimelimit', this doesn't depend on the speed "
+               "of the server. 0 means no limit."),
+            nullptr, nullptr, luascript_limits_action,
+            GAME_MIN_LUAINSTRLIMIT, GAME_MAX_LUAINSTRLIMIT,
+            GAME_DEFAULT_LUAINSTRLIMIT),
+
     GEN_ENUM("compresstype", game.server.save_compress_type, SSET_META,
              SSET_INTERNAL, SSET_RARE, ALLOW_HACK, ALLOW_HACK,
              N_("Savegame compression algorithm"),
@@ -0,0 +1,480 @@
+/*
+ Copyright (c) 1996-2020 Freeciv21 and Freeciv contributors. This file is
+ part of Freeciv21. Freeciv21 is free software: you can redistribute it
+ and/or modify it under the terms of the GNU  General Public License  as
+ published by the Free Software Foundation, either version 3 of the
+ License,  or (at your option) any later version. You should have received
+ a copy of the GNU General Public License along with Freeciv21. If not,
+ see https://www.gnu.org/licenses/.
+ */
+
+/**
+  Game state snapshots.
+
+  A snapshot is a read-only copy of the parts of the game state that
+  reports and writers need: the tiles, the units, the cities and the
+  economy of the players, and optionally the map as each player knows it.
+  It is taken in one pass over the game and can be read while the game goes
+  on, e.g. from another thread.
+
+  Everything is stored as plain numbers (indices and player numbers) in a
+  single allocation. Pointers are only resolved when the snapshot is read,
+  so a snapshot must not outlive the ruleset it was taken with.
+ */
+
+#include <QElapsedTimer>
+
+#include <memory>
+
+// utility
+#include "log.h"
+
+// common
+#include "city.h"
+#include "extras.h"
+#include "game.h"
+#include "map.h"
+#include "player.h"
+#include "terrain.h"
+#include "unit.h"
+#include "unitlist.h"
+#include "unittype.h"
+#include "vision.h"
+
+// server
+#include "maphand.h"
+#include "score.h"
+
+#include "snapshot.h"
+
+// A tile as captured by a snapshot.
+struct snapshot_tile {
+  int claimer;        // Tile index, -1 if none.
+  short terrain;      // Terrain index, -1 if unknown.
+  short owner;        // Player number, -1 if none; same below.
+  short extras_owner;
+  short city_owner;
+  short unit_owner; // Owner of the first unit on the tile.
+};
+
+// A tile as known by a player when the snapshot was taken.
+struct snapshot_view_tile {
+  short terrain;    // Terrain index, -1 if unknown.
+  short owner;      // Player number, -1 if none; same below.
+  short city_owner; // Only set if there is a city there.
+  char known;       // enum known_type
+};
+
+struct snapshot {
+  int turn;
+  int ntiles;
+  int nunits;
+  int ncities;
+  int nplayers; // Highest player number + 1.
+  bv_player captured;
+  bool views;
+
+  struct snapshot_tile *tiles;
+  // Indexed by player number; nullptr without views or for empty slots.
+  struct snapshot_view_tile **view;
+  struct snapshot_unit *units;
+  struct snapshot_city *cities;
+  struct snapshot_player *players;
+
+  std::unique_ptr<char[]> arena;
+};
+
+/**
+   Reserves room for 'count' items of type T at '*offset' in 'arena', and
+   moves the offset past them. Only computes the offset when 'arena' is
+   nullptr.
+ */
+template <typename T>
+static T *snapshot_carve(char *arena, size_t *offset, int count)
+{
+  T *items;
+
+  *offset = (*offset + alignof(T) - 1) / alignof(T) * alignof(T);
+  items = arena != nullptr ? reinterpret_cast<T *>(arena + *offset)
+                           : nullptr;
+  *offset += sizeof(T) * count;
+
+  return items;
+}
+
+/**
+   Lays out the arrays of the snapshot in 'arena', or only computes the size
+   they need when 'arena' is nullptr. Returns that size.
+ */
+static size_t snapshot_layout(struct snapshot *snap, char *arena)
+{
+  size_t offset = 0;
+
+  snap->tiles =
+      snapshot_carve<struct snapshot_tile>(arena, &offset, snap->ntiles);
+  snap->units =
+      snapshot_carve<struct snapshot_unit>(arena, &offset, snap->nunits);
+  snap->cities =
+      snapshot_carve<struct snapshot_city>(arena, &offset, snap->ncities);
+  snap->players = snapshot_carve<struct snapshot_player>(arena, &offset,
+                                                         snap->nplayers);
+  snap->view = snapshot_carve<struct snapshot_view_tile *>(arena, &offset,
+                                                           snap->nplayers);
+  if (snap->views) {
+    players_iterate(pplayer)
+    {
+      struct snapshot_view_tile *view =
+          snapshot_carve<struct snapshot_view_tile>(arena, &offset,
+                                                    snap->ntiles);
+
+      if (arena != nullptr) {
+        snap->view[player_number(pplayer)] = view;
+      }
+    }
+    players_iterate_end;
+  }
+
+  return offset;
+}
+
+/**
+   Returns the number of the player, or -1 for nullptr.
+ */
+static inline short snapshot_player_number(const struct player *pplayer)
+{
+  return pplayer != nullptr ? player_number(pplayer) : -1;
+}
+
+/**
+   Returns the index of the terrain, or -1 for nullptr.
+ */
+static inline short snapshot_terrain_index(const struct terrain *pterrain)
+{
+  return pterrain != nullptr ? terrain_index(pterrain) : -1;
+}
+
+/**
+   Captures the map as the player knows it.
+ */
+static void snapshot_fill_view(struct snapshot_view_tile *view,
+                               const struct player *pplayer)
+{
+  whole_map_iterate(&(wld.map), ptile)
+  {
+    struct snapshot_view_tile *vtile = view + tile_index(ptile);
+    struct player_tile *plrtile = map_get_player_tile(ptile, pplayer);
+    struct vision_site *pdcity = map_get_player_city(ptile, pplayer);
+
+    vtile->known = tile_get_known(ptile, pplayer);
+    vtile->terrain = snapshot_terrain_index(plrtile->terrain);
+    vtile->owner = snapshot_player_number(plrtile->owner);
+    vtile->city_owner =
+        tile_city(ptile) != nullptr && pdcity != nullptr
+            ? snapshot_player_number(pdcity->owner)
+            : -1;
+  }
+  whole_map_iterate_end;
+}
+
+/**
+   Takes a snapshot of the game. With 'player_views', the map as known by
+   each player is included as well. Free it with snapshot_free().
+ */
+struct snapshot *snapshot_take(bool player_views)
+{
+  auto *snap = new snapshot();
+  QElapsedTimer timer;
+  int i;
+
+  timer.start();
+
+  snap->turn = game.info.turn;
+  // There are no tiles before the map is created.
+  snap->ntiles = map_is_empty() ? 0 : MAP_INDEX_SIZE;
+  snap->views = player_views && snap->ntiles > 0;
+  players_iterate(pplayer)
+  {
+    snap->nunits += unit_list_size(pplayer->units);
+    snap->ncities += city_list_size(pplayer->cities);
+    snap->nplayers = MAX(snap->nplayers, player_number(pplayer) + 1);
+    BV_SET(snap->captured, player_number(pplayer));
+  }
+  players_iterate_end;
+
+  snap->arena.reset(new char[snapshot_layout(snap, nullptr)]());
+  snapshot_layout(snap, snap->arena.get());
+
+  for (i = 0; i < snap->ntiles; i++) {
+    const struct tile *ptile = index_to_tile(&(wld.map), i);
+    struct snapshot_tile *stile = snap->tiles + i;
+    struct city *pcity = tile_city(ptile);
+
+    stile->claimer = ptile->claimer != nullptr ? tile_index(ptile->claimer)
+                                               : -1;
+    stile->terrain = snapshot_terrain_index(tile_terrain(ptile));
+    stile->owner = snapshot_player_number(tile_owner(ptile));
+    stile->extras_owner = snapshot_player_number(extra_owner(ptile));
+    stile->city_owner =
+        pcity != nullptr ? snapshot_player_number(city_owner(pcity)) : -1;
+    stile->unit_owner =
+        unit_list_size(ptile->units) > 0
+            ? snapshot_player_number(
+                unit_owner(unit_list_get(ptile->units, 0)))
+            : -1;
+  }
+
+  i = 0;
+  players_iterate(pplayer)
+  {
+    unit_list_iterate(pplayer->units, punit)
+    {
+      struct snapshot_unit *sunit = snap->units + i++;
+
+      sunit->id = punit->id;
+      sunit->tile = tile_index(unit_tile(punit));
+      sunit->homecity = punit->homecity;
+      sunit->moves_left = punit->moves_left;
+      sunit->owner = player_number(pplayer);
+      sunit->type = utype_index(unit_type_get(punit));
+      sunit->hp = punit->hp;
+      sunit->veteran = punit->veteran;
+    }
+    unit_list_iterate_end;
+  }
+  players_iterate_end;
+
+  i = 0;
+  players_iterate(pplayer)
+  {
+    struct snapshot_player *splayer =
+        snap->players + player_number(pplayer);
+
+    city_list_iterate(pplayer->cities, pcity)
+    {
+      struct snapshot_city *scity = snap->cities + i++;
+
+      scity->id = pcity->id;
+      scity->tile = tile_index(city_tile(pcity));
+      scity->food_stock = pcity->food_stock;
+      scity->shield_stock = pcity->shield_stock;
+      output_type_iterate(o) { scity->surplus[o] = pcity->surplus[o]; }
+      output_type_iterate_end;
+      scity->owner = player_number(pplayer);
+      scity->size = city_size_get(pcity);
+    }
+    city_list_iterate_end;
+
+    splayer->gold = pplayer->economic.gold;
+    splayer->tax = pplayer->economic.tax;
+    splayer->science = pplayer->economic.science;
+    splayer->luxury = pplayer->economic.luxury;
+    splayer->score = get_civ_score(pplayer);
+    splayer->cities = city_list_size(pplayer->cities);
+    splayer->units = unit_list_size(pplayer->units);
+    splayer->is_alive = pplayer->is_alive;
+
+    if (snap->views) {
+      snapshot_fill_view(snap->view[player_number(pplayer)], pplayer);
+    }
+  }
+  players_iterate_end;
+
+  log_debug("Snapshot of %d tiles, %d units and %d cities taken in %lld us",
+            snap->ntiles, snap->nunits, snap->ncities,
+            timer.nsecsElapsed() / 1000);
+
+  return snap;
+}
+
+/**
+   Frees a snapshot.
+ */
+void snapshot_free(struct snapshot *snap) { delete snap; }
+
+/**
+   Returns the turn the snapshot was taken at.
+ */
+int snapshot_turn(const struct snapshot *snap) { return snap->turn; }
+
+/**
+   Returns the terrain of the tile.
+ */
+struct terrain *snapshot_tile_terrain(const struct snapshot *snap,
+                                      const struct tile *ptile)
+{
+  return terrain_by_number(snap->tiles[tile_index(ptile)].terrain);
+}
+
+/**
+   Returns the owner of the tile.
+ */
+struct player *snapshot_tile_owner(const struct snapshot *snap,
+                                   const struct tile *ptile)
+{
+  return player_by_number(snap->tiles[tile_index(ptile)].owner);
+}
+
+/**
+   Returns the source of the ownership of the tile.
+ */
+struct tile *snapshot_tile_claimer(const struct snapshot *snap,
+                                   const struct tile *ptile)
+{
+  return index_to_tile(&(wld.map), snap->tiles[tile_index(ptile)].claimer);
+}
+
+/**
+   Returns the owner of the extras on the tile.
+ */
+struct player *snapshot_tile_extras_owner(const struct snapshot *snap,
+                                          const struct tile *ptile)
+{
+  return player_by_number(snap->tiles[tile_index(ptile)].extras_owner);
+}
+
+/**
+   Returns the owner of the city on the tile.
+ */
+struct player *snapshot_tile_city_owner(const struct snapshot *snap,
+                                        const struct tile *ptile)
+{
+  return player_by_number(snap->tiles[tile_index(ptile)].city_owner);
+}
+
+/**
+   Returns the owner of the first unit on the tile.
+ */
+struct player *snapshot_tile_unit_owner(const struct snapshot *snap,
+                                        const struct tile *ptile)
+{
+  return player_by_number(snap->tiles[tile_index(ptile)].unit_owner);
+}
+
+/**
+   Returns whether the snapshot includes the map as known by the players.
+ */
+bool snapshot_has_views(const struct snapshot *snap) { return snap->views; }
+
+/**
+   Returns the view of the tile by the player, or nullptr if the snapshot
+   doesn't have it.
+ */
+static const struct snapshot_view_tile *
+snapshot_view_tile_get(const struct snapshot *snap, const struct tile *ptile,
+                       const struct player *pplayer)
+{
+  int number = player_number(pplayer);
+
+  fc_assert_ret_val(snap->views, nullptr);
+  fc_assert_ret_val(number < snap->nplayers, nullptr);
+  fc_assert_ret_val(snap->view[number] != nullptr, nullptr);
+
+  return snap->view[number] + tile_index(ptile);
+}
+
+/**
+   Returns how well the player knew the tile.
+ */
+enum known_type snapshot_view_known(const struct snapshot *snap,
+                                    const struct tile *ptile,
+                                    const struct player *pplayer)
+{
+  const struct snapshot_view_tile *vtile =
+      snapshot_view_tile_get(snap, ptile, pplayer);
+
+  return vtile != nullptr ? static_cast<enum known_type>(vtile->known)
+                          : TILE_UNKNOWN;
+}
+
+/**
+   Returns the terrain of the tile as known by the player.
+ */
+struct terrain *snapshot_view_terrain(const struct snapshot *snap,
+                                      const struct tile *ptile,
+                                      const struct player *pplayer)
+{
+  const struct snapshot_view_tile *vtile =
+      snapshot_view_tile_get(snap, ptile, pplayer);
+
+  return vtile != nullptr ? terrain_by_number(vtile->terrain) : nullptr;
+}
+
+/**
+   Returns the owner of the tile as known by the player.
+ */
+struct player *snapshot_view_owner(const struct snapshot *snap,
+                                   const struct tile *ptile,
+                                   const struct player *pplayer)
+{
+  const struct snapshot_view_tile *vtile =
+      snapshot_view_tile_get(snap, ptile, pplayer);
+
+  return vtile != nullptr ? player_by_number(vtile->owner) : nullptr;
+}
+
+/**
+   Returns the owner of the city on the tile as known by the player. It is
+   nullptr if there is no city there any more, even if the player still
+   believes there is one.
+ */
+struct player *snapshot_view_city_owner(const struct snapshot *snap,
+                                        const struct tile *ptile,
+                                        const struct player *pplayer)
+{
+  const struct snapshot_view_tile *vtile =
+      snapshot_view_tile_get(snap, ptile, pplayer);
+
+  return vtile != nullptr ? player_by_number(vtile->city_owner) : nullptr;
+}
+
+/**
+   Returns the number of units in the snapshot.
+ */
+int snapshot_unit_count(const struct snapshot *snap) { return snap->nunits; }
+
+/**
+   Returns the i-th unit of the snapshot. Units are grouped by owner.
+ */
+const struct snapshot_unit *snapshot_unit_get(const struct snapshot *snap,
+                                              int i)
+{
+  fc_assert_ret_val(i >= 0 && i < snap->nunits, nullptr);
+
+  return snap->units + i;
+}
+
+/**
+   Returns the number of cities in the snapshot.
+ */
+int snapshot_city_count(const struct snapshot *snap)
+{
+  return snap->ncities;
+}
+
+/**
+   Returns the i-th city of the snapshot. Cities are grouped by owner.
+ */
+const struct snapshot_city *snapshot_city_get(const struct snapshot *snap,
+                                              int i)
+{
+  fc_assert_ret_val(i >= 0 && i < snap->ncities, nullptr);
+
+  return snap->cities + i;
+}
+
+/**
+   Returns the economy of the player when the snapshot was taken, or
+   nullptr if the player didn't exist then.
+ */
+const struct snapshot_player *
+snapshot_player_get(const struct snapshot *snap,
+                    const struct player *pplayer)
+{
+  int number = player_number(pplayer);
+
+  if (!BV_ISSET(snap->captured, number)) {
+    return nullptr;
+  }
+
+  return snap->players + number;
+}
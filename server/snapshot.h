@@ -0,0 +1,93 @@
+/*
+ Copyright (c) 1996-2020 Freeciv21 and Freeciv contributors. This file is
+ part of Freeciv21. Freeciv21 is free software: you can redistribute it
+ and/or modify it under the terms of the GNU  General Public License  as
+ published by the Free Software Foundation, either version 3 of the
+ License,  or (at your option) any later version. You should have received
+ a copy of the GNU General Public License along with Freeciv21. If not,
+ see https://www.gnu.org/licenses/.
+ */
+#pragma once
+
+// common
+#include "fc_types.h"
+#include "tile.h" // enum known_type
+
+// A unit as captured by a snapshot.
+struct snapshot_unit {
+  int id;
+  int tile;     // Tile index.
+  int homecity; // City id, 0 if none.
+  int moves_left;
+  short owner; // Player number.
+  short type;  // Unit type index.
+  short hp;
+  short veteran;
+};
+
+// A city as captured by a snapshot.
+struct snapshot_city {
+  int id;
+  int tile; // Tile index.
+  int food_stock;
+  int shield_stock;
+  int surplus[O_LAST];
+  short owner; // Player number.
+  short size;
+};
+
+// The economy of a player as captured by a snapshot.
+struct snapshot_player {
+  int gold;
+  int tax;
+  int science;
+  int luxury;
+  int score;
+  int cities;
+  int units;
+  bool is_alive;
+};
+
+struct snapshot;
+
+struct snapshot *snapshot_take(bool player_views);
+void snapshot_free(struct snapshot *snap);
+
+int snapshot_turn(const struct snapshot *snap);
+
+struct terrain *snapshot_tile_terrain(const struct snapshot *snap,
+                                      const struct tile *ptile);
+struct player *snapshot_tile_owner(const struct snapshot *snap,
+                                   const struct tile *ptile);
+struct tile *snapshot_tile_claimer(const struct snapshot *snap,
+                                   const struct tile *ptile);
+struct player *snapshot_tile_extras_owner(const struct snapshot *snap,
+                                          const struct tile *ptile);
+struct player *snapshot_tile_city_owner(const struct snapshot *snap,
+                                        const struct tile *ptile);
+struct player *snapshot_tile_unit_owner(const struct snapshot *snap,
+                                        const struct tile *ptile);
+
+bool snapshot_has_views(const struct snapshot *snap);
+enum known_type snapshot_view_known(const struct snapshot *snap,
+                                    const struct tile *ptile,
+                                    const struct player *pplayer);
+struct terrain *snapshot_view_terrain(const struct snapshot *snap,
+                                      const struct tile *ptile,
+                                      const struct player *pplayer);
+struct player *snapshot_view_owner(const struct snapshot *snap,
+                                   const struct tile *ptile,
+                                   const struct player *pplayer);
+struct player *snapshot_view_city_owner(const struct snapshot *snap,
+                                        const struct tile *ptile,
+                                        const struct player *pplayer);
+
+int snapshot_unit_count(const struct snapshot *snap);
+const struct snapshot_unit *snapshot_unit_get(const struct snapshot *snap,
+                                              int i);
+int snapshot_city_count(const struct snapshot *snap);
+const struct snapshot_city *snapshot_city_get(const struct snapshot *snap,
+                                              int i);
+const struct snapshot_player *
+snapshot_player_get(const struct snapshot *snap,
+                    const struct player *pplayer);
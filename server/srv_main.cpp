@@ -18,6 +18,8 @@
 #include <QCoreApplication>
 #include <QDebug>
 #include <QElapsedTimer>
+#include <QRunnable>
+#include <QThreadPool>
 
 // utility
 #include "bitvector.h"
@@ -80,11 +82,13 @@
 #include "score.h"
 #include "sernet.h"
 #include "settings.h"
+#include "snapshot.h"
 #include "spacerace.h"
 #include "srv_log.h"
 #include "stdinhand.h"
 #include "techtools.h"
 #include "unittools.h"
+#include "unitwait.h"
 #include "voting.h"
 
 /* server/advisors */
@@ -1085,6 +1089,7 @@ void begin_turn(bool is_new_turn)
   send_game_info(nullptr);
 
   if (is_new_turn) {
+    script_server_profile_new_turn();
     script_server_signal_emit("turn_begin", game.info.turn, game.info.year);
     script_server_signal_emit("turn_started",
                               game.info.turn > 0 ? game.info.turn - 1
@@ -1166,15 +1171,6 @@ void begin_turn(bool is_new_turn)
       QStringLiteral("Begin turn:%1 milliseconds").arg(timer.elapsed()));
 }
 
-/**
- * Comparator for sorting unit_waits in chronological order.
- */
-static int unit_wait_cmp(const struct unit_wait *const *a,
-                         const struct unit_wait *const *b)
-{
-  return (*a)->wake_up > (*b)->wake_up;
-}
-
 /**
    Begin a phase of movement.  This handles all beginning-of-phase actions
    for one or more players.
@@ -1220,7 +1216,7 @@ void begin_phase(bool is_new_phase)
   if (is_new_phase) {
     /* Unit "end of turn" activities - of course these actually go at
      * the start of the turn! */
-    unit_wait_list_clear(server.unit_waits);
+    unit_waits_clear();
 
     whole_map_iterate(&(wld.map), ptile)
     {
@@ -1267,17 +1263,6 @@ void begin_phase(bool is_new_phase)
     }
     phase_players_iterate_end;
 
-    unit_wait_list_sort(server.unit_waits, unit_wait_cmp);
-    unit_wait_list_link_iterate(server.unit_waits, plink)
-    {
-      struct unit *punit =
-          game_unit_by_number(unit_wait_list_link_data(plink)->id);
-      if (punit) {
-        punit->server.wait = plink;
-      }
-    }
-    unit_wait_list_link_iterate_end;
-
     /* Execute orders after activities have been completed (roads built,
      * pillage done, etc.). */
     phase_players_iterate(pplayer)
@@ -1549,8 +1534,9 @@ void end_turn()
   conn_list_iterate_end;
 
   lsend_packet_end_turn(game.est_connections);
+  city_info_turn_stats();
 
-  map_calculate_borders();
+  map_calculate_dirty_borders();
 
   // Output some AI measurement information
   players_iterate(pplayer)
@@ -2084,12 +2070,21 @@ bool server_packet_input(struct connection *pconn, void *packet, int type)
     return true;
   }
 
+  /* Established, but still waiting for the answer to the ruleset cache
+   * offer: the connection is not in the game yet and may not act. */
+  if (pconn->server.ruleset_cache_offered
+      && type != PACKET_RULESET_CACHE_REPLY) {
+    qDebug("Ignoring packet %s(%d) from %s before it joined the game.",
+           packet_name(packet_type(type)), type, conn_description(pconn));
+    return true;
+  }
+
   // valid packets from established connections but non-players
   if (type == PACKET_CHAT_MSG_REQ || type == PACKET_SINGLE_WANT_HACK_REQ
       || type == PACKET_NATION_SELECT_REQ || type == PACKET_REPORT_REQ
       || type == PACKET_CLIENT_INFO || type == PACKET_CONN_PONG
       || type == PACKET_CLIENT_HEARTBEAT || type == PACKET_SAVE_SCENARIO
-      || is_client_edit_packet(type)) {
+      || type == PACKET_RULESET_CACHE_REPLY || is_client_edit_packet(type)) {
     /* Except for PACKET_EDIT_MODE (used to set edit mode), check
      * that the client is allowed to send the given edit packet. */
     if (is_client_edit_packet(type) && type != PACKET_EDIT_MODE
@@ -3153,18 +3148,6 @@ void srv_ready()
   }
 }
 
-/**
- * Free function for unit_wait.
- */
-static void unit_wait_destroy(struct unit_wait *pwait)
-{
-  struct unit *punit = game_unit_by_number(pwait->id);
-  if (punit) {
-    punit->server.wait = NULL;
-  }
-  free(pwait);
-}
-
 /**
    Initialize game data for the server (corresponds to server_game_free).
  */
@@ -3174,7 +3157,7 @@ void server_game_init(bool keep_ruleset_value)
   server.playable_nations = 0;
   server.nbarbarians = 0;
   server.identity_number = IDENTITY_NUMBER_SKIP;
-  server.unit_waits = unit_wait_list_new_full(unit_wait_destroy);
+  unit_waits_init();
 
   BV_CLR_ALL(identity_numbers_used);
   identity_number_reserve(IDENTITY_NUMBER_ZERO);
@@ -3195,8 +3178,12 @@ void server_game_init(bool keep_ruleset_value)
  */
 void server_game_free()
 {
+  mapimg_server_wait();
+
   CALL_FUNC_EACH_AI(game_free);
 
+  map_borders_invalidate();
+
   // Free all the treaties that were left open when game finished.
   free_treaties();
 
@@ -3221,6 +3208,7 @@ void server_game_free()
       vision_free(pcity->server.vision);
       pcity->server.vision = nullptr;
       adv_city_free(pcity);
+      city_info_cache_free(pcity);
     }
     city_list_iterate_end;
   }
@@ -3235,7 +3223,7 @@ void server_game_free()
   log_civ_score_free();
   playercolor_free();
   citymap_free();
-  unit_wait_list_destroy(server.unit_waits);
+  unit_waits_free();
   game_free();
 }
 
@@ -3342,6 +3330,65 @@ unsigned int server_ss_val_bitwise_get(server_setting_id id)
   }
 }
 
+// The snapshot the map images are drawn from, see mapimg_server_create().
+static const struct snapshot *mapimg_snapshot = nullptr;
+
+// Background thread for mapimg_server_start()
+Q_GLOBAL_STATIC(QThreadPool, mapimg_job)
+
+/**
+   Draws and saves the map images of the batch from the given snapshot, on
+   a background thread. Takes ownership of both. Map images are drawn one
+   batch at a time; this waits for the previous one first.
+ */
+void mapimg_server_start(struct snapshot *snap, struct mapimg_batch *batch)
+{
+  mapimg_server_wait();
+
+  mapimg_snapshot = snap;
+  mapimg_job->setMaxThreadCount(1);
+  mapimg_job->start(QRunnable::create([snap, batch] {
+    if (!mapimg_batch_draw(batch)) {
+      qCritical("%s", mapimg_error());
+    }
+    mapimg_snapshot = nullptr;
+    mapimg_batch_destroy(batch);
+    snapshot_free(snap);
+  }));
+}
+
+/**
+   Waits until the map images started by mapimg_server_start() are saved.
+   They are drawn from the snapshot but also use the map topology, the
+   rulesets and the player structs, so this must be called before any of
+   these is freed.
+ */
+void mapimg_server_wait()
+{
+  if (mapimg_job.exists()) {
+    mapimg_job->waitForDone();
+  }
+}
+
+/**
+   Creates the map image from the given snapshot, which should include the
+   views of the players. Returns whether it succeeded.
+ */
+bool mapimg_server_create(const struct snapshot *snap,
+                          struct mapdef *pmapdef, bool force)
+{
+  bool success;
+
+  mapimg_server_wait();
+
+  mapimg_snapshot = snap;
+  success = mapimg_create(pmapdef, force, game.server.save_name,
+                          qUtf8Printable(srvarg.saves_pathname));
+  mapimg_snapshot = nullptr;
+
+  return success;
+}
+
 /**
    Helper function for the mapimg module - tile knowledge.
  */
@@ -3349,8 +3396,10 @@ known_type mapimg_server_tile_known(const struct tile *ptile,
                                     const struct player *pplayer,
                                     bool knowledge)
 {
+  fc_assert_ret_val(mapimg_snapshot != nullptr, TILE_UNKNOWN);
+
   if (knowledge && pplayer) {
-    return tile_get_known(ptile, pplayer);
+    return snapshot_view_known(mapimg_snapshot, ptile, pplayer);
   }
 
   return TILE_KNOWN_SEEN;
@@ -3363,12 +3412,13 @@ terrain *mapimg_server_tile_terrain(const struct tile *ptile,
                                     const struct player *pplayer,
                                     bool knowledge)
 {
+  fc_assert_ret_val(mapimg_snapshot != nullptr, nullptr);
+
   if (knowledge && pplayer) {
-    struct player_tile *plrtile = map_get_player_tile(ptile, pplayer);
-    return plrtile->terrain;
+    return snapshot_view_terrain(mapimg_snapshot, ptile, pplayer);
   }
 
-  return tile_terrain(ptile);
+  return snapshot_tile_terrain(mapimg_snapshot, ptile);
 }
 
 /**
@@ -3378,13 +3428,15 @@ player *mapimg_server_tile_owner(const struct tile *ptile,
                                  const struct player *pplayer,
                                  bool knowledge)
 {
+  fc_assert_ret_val(mapimg_snapshot != nullptr, nullptr);
+
   if (knowledge && pplayer
-      && tile_get_known(ptile, pplayer) != TILE_KNOWN_SEEN) {
-    struct player_tile *plrtile = map_get_player_tile(ptile, pplayer);
-    return plrtile->owner;
+      && snapshot_view_known(mapimg_snapshot, ptile, pplayer)
+             != TILE_KNOWN_SEEN) {
+    return snapshot_view_owner(mapimg_snapshot, ptile, pplayer);
   }
 
-  return tile_owner(ptile);
+  return snapshot_tile_owner(mapimg_snapshot, ptile);
 }
 
 /**
@@ -3393,23 +3445,13 @@ player *mapimg_server_tile_owner(const struct tile *ptile,
 player *mapimg_server_tile_city(const struct tile *ptile,
                                 const struct player *pplayer, bool knowledge)
 {
-  struct city *pcity = tile_city(ptile);
-
-  if (!pcity) {
-    return nullptr;
-  }
+  fc_assert_ret_val(mapimg_snapshot != nullptr, nullptr);
 
   if (knowledge && pplayer) {
-    struct vision_site *pdcity = map_get_player_city(ptile, pplayer);
-
-    if (pdcity) {
-      return pdcity->owner;
-    } else {
-      return nullptr;
-    }
+    return snapshot_view_city_owner(mapimg_snapshot, ptile, pplayer);
   }
 
-  return city_owner(tile_city(ptile));
+  return snapshot_tile_city_owner(mapimg_snapshot, ptile);
 }
 
 /**
@@ -3418,18 +3460,15 @@ player *mapimg_server_tile_city(const struct tile *ptile,
 player *mapimg_server_tile_unit(const struct tile *ptile,
                                 const struct player *pplayer, bool knowledge)
 {
-  int unit_count = unit_list_size(ptile->units);
-
-  if (unit_count == 0) {
-    return nullptr;
-  }
+  fc_assert_ret_val(mapimg_snapshot != nullptr, nullptr);
 
   if (knowledge && pplayer
-      && tile_get_known(ptile, pplayer) != TILE_KNOWN_SEEN) {
+      && snapshot_view_known(mapimg_snapshot, ptile, pplayer)
+             != TILE_KNOWN_SEEN) {
     return nullptr;
   }
 
-  return unit_owner(unit_list_get(ptile->units, 0));
+  return snapshot_tile_unit_owner(mapimg_snapshot, ptile);
 }
 
 /**
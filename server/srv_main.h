@@ -24,6 +24,9 @@
 #include <QHostAddress>
 
 struct conn_list;
+struct mapdef;
+struct mapimg_batch;
+struct snapshot;
 
 struct server_arguments {
   // metaserver information
@@ -84,12 +87,11 @@ extern struct civserver {
   unsigned short identity_number;
 
   char game_identifier[MAX_LEN_GAME_IDENTIFIER];
-
-  struct unit_wait_list *unit_waits;
 } server;
 
 void init_game_seed();
 void srv_init();
+void fc_interface_init_server();
 void server_quit();
 void save_game_auto(const char *save_reason, enum autosave_type type);
 
@@ -139,6 +141,10 @@ extern bool force_end_of_sniff;
 
 void update_nations_with_startpos();
 
+void mapimg_server_start(struct snapshot *snap, struct mapimg_batch *batch);
+void mapimg_server_wait();
+bool mapimg_server_create(const struct snapshot *snap,
+                          struct mapdef *pmapdef, bool force);
 known_type mapimg_server_tile_known(const struct tile *ptile,
                                     const struct player *pplayer,
                                     bool knowledge);
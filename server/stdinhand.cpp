@@ -64,6 +64,7 @@
 #include "ruleset.h"
 #include "sanitycheck.h"
 #include "settings.h"
+#include "snapshot.h"
 #include "srv_log.h"
 #include "srv_main.h"
 #include "techtools.h"
@@ -130,6 +131,8 @@ static bool default_command(struct connection *caller, char *arg,
                             bool check);
 static bool lua_command(struct connection *caller, char *arg, bool check,
                         int read_recursion);
+static bool luaprofile_command(struct connection *caller, char *arg,
+                               bool check);
 static bool kick_command(struct connection *caller, char *name, bool check);
 static bool delegate_command(struct connection *caller, char *arg,
                              bool check);
@@ -5085,6 +5088,8 @@ static bool handle_stdin_input_real(struct connection *caller, char *str,
     return default_command(caller, arg, check);
   case CMD_LUA:
     return lua_command(caller, arg, check, read_recursion);
+  case CMD_LUAPROFILE:
+    return luaprofile_command(caller, arg, check);
   case CMD_KICK:
     return kick_command(caller, arg, check);
   case CMD_DELEGATE:
@@ -5370,6 +5375,8 @@ static bool default_command(struct connection *caller, char *arg, bool check)
 #define SPECENUM_VALUE2NAME "unsafe-cmd"
 #define SPECENUM_VALUE3 LUA_UNSAFE_FILE
 #define SPECENUM_VALUE3NAME "unsafe-file"
+#define SPECENUM_VALUE4 LUA_SIGNALS
+#define SPECENUM_VALUE4NAME "signals"
 #include "specenum_gen.h"
 
 /**
@@ -5441,6 +5448,13 @@ static bool lua_command(struct connection *caller, char *arg, bool check,
   case LUA_CMD:
     // Nothing to check.
     break;
+  case LUA_SIGNALS:
+    if (luaarg[0] != '\0' && fc_strcasecmp(luaarg, "reset") != 0) {
+      cmd_reply(CMD_LUA, caller, C_SYNTAX,
+                _("Usage: %slua signals [reset]"), caller ? "/" : "");
+      return false;
+    }
+    break;
   case LUA_UNSAFE_CMD:
     if (read_recursion > 0) {
       cmd_reply(CMD_LUA, caller, C_FAIL,
@@ -5510,6 +5524,15 @@ static bool lua_command(struct connection *caller, char *arg, bool check,
   case LUA_CMD:
     ret = script_server_do_string(caller, luaarg);
     break;
+  case LUA_SIGNALS:
+    if (luaarg[0] != '\0') {
+      script_server_signal_stats_reset();
+      cmd_reply(CMD_LUA, caller, C_OK, _("Lua signal statistics reset."));
+    } else {
+      script_server_signal_report(caller);
+    }
+    ret = true;
+    break;
   case LUA_UNSAFE_CMD:
     ret = script_server_unsafe_do_string(caller, luaarg);
     break;
@@ -5548,6 +5571,51 @@ static bool lua_command(struct connection *caller, char *arg, bool check,
   return ret;
 }
 
+/**
+   Control the Lua profiler or show its results.
+ */
+static bool luaprofile_command(struct connection *caller, char *arg,
+                               bool check)
+{
+  QString str = QString(arg).trimmed();
+  int turns = 5;
+
+  if (str.isEmpty() || str_to_int(qUtf8Printable(str), &turns)) {
+    if (turns < 1) {
+      cmd_reply(CMD_LUAPROFILE, caller, C_SYNTAX,
+                _("The number of turns must be positive."));
+      return false;
+    }
+    if (!check) {
+      script_server_profile_report(caller, turns);
+    }
+  } else if (str.compare(QLatin1String("on"), Qt::CaseInsensitive) == 0) {
+    if (!check) {
+      script_server_profile_set_enabled(true);
+      cmd_reply(CMD_LUAPROFILE, caller, C_OK, _("Lua profiler started."));
+    }
+  } else if (str.compare(QLatin1String("off"), Qt::CaseInsensitive) == 0) {
+    if (!check) {
+      script_server_profile_set_enabled(false);
+      cmd_reply(CMD_LUAPROFILE, caller, C_OK, _("Lua profiler stopped."));
+    }
+  } else if (str.compare(QLatin1String("reset"), Qt::CaseInsensitive)
+             == 0) {
+    if (!check) {
+      script_server_profile_reset();
+      cmd_reply(CMD_LUAPROFILE, caller, C_OK,
+                _("Lua profile data cleared."));
+    }
+  } else {
+    cmd_reply(CMD_LUAPROFILE, caller, C_SYNTAX,
+              _("Usage: %sluaprofile on|off|reset|[number of turns]"),
+              caller ? "/" : "");
+    return false;
+  }
+
+  return true;
+}
+
 // Define the possible arguments to the delegation command
 #define SPECENUM_NAME delegate_args
 #define SPECENUM_VALUE0 DELEGATE_CANCEL
@@ -6262,17 +6330,19 @@ static bool mapimg_command(struct connection *caller, char *arg, bool check)
         return ret;
       }
 
+      struct snapshot *snap = snapshot_take(true);
+
       for (id = 0; id < mapimg_count(); id++) {
         struct mapdef *pmapdef = mapimg_isvalid(id);
 
         if (pmapdef == nullptr
-            || !mapimg_create(pmapdef, true, game.server.save_name,
-                              qUtf8Printable(srvarg.saves_pathname))) {
+            || !mapimg_server_create(snap, pmapdef, true)) {
           cmd_reply(CMD_MAPIMG, caller, C_FAIL,
                     _("Error saving map image %d: %s."), id, mapimg_error());
           ret = false;
         }
       }
+      snapshot_free(snap);
     } else if (sscanf(qUtf8Printable(token.at(1)), "%d", &id) != 0) {
       struct mapdef *pmapdef;
 
@@ -6282,9 +6352,15 @@ static bool mapimg_command(struct connection *caller, char *arg, bool check)
       }
 
       pmapdef = mapimg_isvalid(id);
-      if (pmapdef == nullptr
-          || !mapimg_create(pmapdef, true, game.server.save_name,
-                            qUtf8Printable(srvarg.saves_pathname))) {
+      if (pmapdef != nullptr) {
+        struct snapshot *snap = snapshot_take(true);
+
+        if (!mapimg_server_create(snap, pmapdef, true)) {
+          pmapdef = nullptr;
+        }
+        snapshot_free(snap);
+      }
+      if (pmapdef == nullptr) {
         cmd_reply(CMD_MAPIMG, caller, C_FAIL,
                   _("Error saving map image %d: %s."), id, mapimg_error());
         ret = false;
@@ -7098,6 +7174,33 @@ static void show_delegations(struct connection *caller)
   cmd_reply(CMD_LIST, caller, C_COMMENT, horiz_line);
 }
 
+/**
+   Show the size of the event cache.
+ */
+static void show_events(struct connection *caller)
+{
+  struct event_cache_stats stats;
+
+  event_cache_get_stats(&stats);
+
+  cmd_reply(CMD_LIST, caller, C_COMMENT, _("Event cache:"));
+  cmd_reply(CMD_LIST, caller, C_COMMENT, horiz_line);
+  cmd_reply(CMD_LIST, caller, C_COMMENT,
+            _("%d events using %.1f KiB (at most %d events of the last %d "
+              "turns are kept)."),
+            stats.events, stats.bytes / 1024.0,
+            game.server.event_cache.max_size, game.server.event_cache.turns);
+  if (stats.oldest_turn >= 0) {
+    cmd_reply(CMD_LIST, caller, C_COMMENT, _("Oldest event from turn %d."),
+              stats.oldest_turn);
+  }
+  cmd_reply(CMD_LIST, caller, C_COMMENT,
+            _("Recipients: %d public, %d for global observers, %d for "
+              "players."),
+            stats.for_all, stats.for_global_observers, stats.for_players);
+  cmd_reply(CMD_LIST, caller, C_COMMENT, horiz_line);
+}
+
 /**
    Show the ignore list of the
  */
@@ -7402,22 +7505,24 @@ static void show_colors(struct connection *caller)
 #define SPECENUM_VALUE1NAME "connections"
 #define SPECENUM_VALUE2 LIST_DELEGATIONS
 #define SPECENUM_VALUE2NAME "delegations"
-#define SPECENUM_VALUE3 LIST_IGNORE
-#define SPECENUM_VALUE3NAME "ignored users"
-#define SPECENUM_VALUE4 LIST_MAPIMG
-#define SPECENUM_VALUE4NAME "map image definitions"
-#define SPECENUM_VALUE5 LIST_PLAYERS
-#define SPECENUM_VALUE5NAME "players"
-#define SPECENUM_VALUE6 LIST_RULESETS
-#define SPECENUM_VALUE6NAME "rulesets"
-#define SPECENUM_VALUE7 LIST_SCENARIOS
-#define SPECENUM_VALUE7NAME "scenarios"
-#define SPECENUM_VALUE8 LIST_NATIONSETS
-#define SPECENUM_VALUE8NAME "nationsets"
-#define SPECENUM_VALUE9 LIST_TEAMS
-#define SPECENUM_VALUE9NAME "teams"
-#define SPECENUM_VALUE10 LIST_VOTES
-#define SPECENUM_VALUE10NAME "votes"
+#define SPECENUM_VALUE3 LIST_EVENTS
+#define SPECENUM_VALUE3NAME "events"
+#define SPECENUM_VALUE4 LIST_IGNORE
+#define SPECENUM_VALUE4NAME "ignored users"
+#define SPECENUM_VALUE5 LIST_MAPIMG
+#define SPECENUM_VALUE5NAME "map image definitions"
+#define SPECENUM_VALUE6 LIST_PLAYERS
+#define SPECENUM_VALUE6NAME "players"
+#define SPECENUM_VALUE7 LIST_RULESETS
+#define SPECENUM_VALUE7NAME "rulesets"
+#define SPECENUM_VALUE8 LIST_SCENARIOS
+#define SPECENUM_VALUE8NAME "scenarios"
+#define SPECENUM_VALUE9 LIST_NATIONSETS
+#define SPECENUM_VALUE9NAME "nationsets"
+#define SPECENUM_VALUE10 LIST_TEAMS
+#define SPECENUM_VALUE10NAME "teams"
+#define SPECENUM_VALUE11 LIST_VOTES
+#define SPECENUM_VALUE11NAME "votes"
 #include "specenum_gen.h"
 
 /**
@@ -7464,6 +7569,9 @@ static bool show_list(struct connection *caller, char *arg)
   case LIST_DELEGATIONS:
     show_delegations(caller);
     return true;
+  case LIST_EVENTS:
+    show_events(caller);
+    return true;
   case LIST_IGNORE:
     return show_ignore(caller);
   case LIST_MAPIMG:
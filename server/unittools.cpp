@@ -68,6 +68,7 @@
 #include "srv_main.h"
 #include "techtools.h"
 #include "unithand.h"
+#include "unitwait.h"
 
 /* server/advisors */
 #include "advgoto.h"
@@ -1067,7 +1068,6 @@ static void update_unit_activity(struct unit *punit, time_t now)
   struct player *pplayer = unit_owner(punit);
   enum unit_activity activity = punit->activity;
   int activity_rate = get_activity_rate_this_turn(punit);
-  struct unit_wait *wait;
   time_t wake_up = punit->action_timestamp + game.server.unitwaittime;
 
   unit_restore_movepoints(pplayer, punit);
@@ -1122,12 +1122,7 @@ static void update_unit_activity(struct unit *punit, time_t now)
     if (game.server.unitwaittime
         && (game.server.unitwaittime_style & UWT_ACTIVITIES)
         && wake_up > now) {
-      wait = new unit_wait{};
-      wait->activity_count = activity_rate;
-      wait->activity = activity;
-      wait->id = punit->id;
-      wait->wake_up = wake_up;
-      unit_wait_list_append(server.unit_waits, wait);
+      unit_wait_add(punit, wake_up, activity, activity_rate);
       return;
     }
 
@@ -1161,9 +1156,7 @@ void finish_unit_wait(struct unit *punit, int activity_count)
 void unit_forget_last_activity(struct unit *punit)
 {
   punit->changed_from = ACTIVITY_IDLE;
-  if (punit->server.wait) {
-    unit_wait_list_erase(server.unit_waits, punit->server.wait);
-  }
+  unit_wait_cancel(punit);
 }
 
 /**
@@ -2024,9 +2017,7 @@ void server_remove_unit_full(struct unit *punit, bool transported,
   punit->server.vision = nullptr;
 
   // Clear a unit wait if present.
-  if (punit->server.wait) {
-    unit_wait_list_erase(server.unit_waits, punit->server.wait);
-  }
+  unit_wait_cancel(punit);
 
   packet.unit_id = punit->id;
   // Send to onlookers.
@@ -3510,7 +3501,8 @@ static void unit_enter_building(struct unit *punit)
       create_extra(ptile, new_extra, pplayer);
       if (name == "building_u") {
         // No owner
-        ptile->extras_owner = nullptr;
+        tile_set_extras_owner(ptile, nullptr);
+        map_borders_tile_changed(ptile);
       }
 
       // Update building struct
@@ -4156,7 +4148,7 @@ static struct unit_move_data *unit_move_data(struct unit *punit,
   // Enhance vision if unit steps into a fortress
   new_vision = vision_new(powner, pdesttile);
   punit->server.vision = new_vision;
-  vision_change_sight(new_vision, radius_sq);
+  vision_move_sight(pdata->old_vision, new_vision, radius_sq);
   ASSERT_VISION(new_vision);
 
   return pdata;
@@ -4631,9 +4623,11 @@ bool unit_move(struct unit *punit, struct tile *pdesttile, int move_cost,
     refresh_dumb_city(pcity);
   }
 
-  if (unit_lives) {
+  if (unit_lives
+      && script_server_signal_has_callbacks(SCRIPT_SIGNAL_UNIT_MOVED)) {
     // Let the scripts run ...
-    script_server_signal_emit("unit_moved", punit, psrctile, pdesttile);
+    script_server_signal_emit_id(SCRIPT_SIGNAL_UNIT_MOVED, punit, psrctile,
+                                 pdesttile);
     unit_lives = unit_is_alive(saved_id);
   }
 
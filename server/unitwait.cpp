@@ -0,0 +1,244 @@
+/*__            ___                 ***************************************
+/   \          /   \          Copyright (c) 1996-2020 Freeciv21 and Freeciv
+\_   \        /  __/          contributors. This file is part of Freeciv21.
+ _\   \      /  /__     Freeciv21 is free software: you can redistribute it
+ \___  \____/   __/    and/or modify it under the terms of the GNU  General
+     \_       _/          Public License  as published by the Free Software
+       | @ @  \_               Foundation, either version 3 of the  License,
+       |                              or (at your option) any later version.
+     _/     /\                  You should have received  a copy of the GNU
+    /o)  (o/\ \_                General Public License along with Freeciv21.
+    \_____/ /                     If not, see https://www.gnu.org/licenses/.
+      \____/        ********************************************************/
+
+/**
+  Activities delayed by 'unitwaittime'.
+
+  When a unit acted shortly before turn change, its activity only progresses
+  once 'unitwaittime' has passed since the action. The pending completions
+  are kept in a binary min-heap ordered by wake up time, with the position
+  of each unit's entry indexed so that it can be cancelled when the unit
+  moves or dies. A single-shot timer is armed for the earliest deadline.
+ */
+
+#include <QDateTime>
+#include <QHash>
+#include <QTimer>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// utility
+#include "log.h"
+
+// common
+#include "game.h"
+#include "unit.h"
+
+// server
+#include "unittools.h"
+
+#include "unitwait.h"
+
+struct unit_wait {
+  int id;
+  time_t wake_up;
+  enum unit_activity activity;
+  int activity_count;
+};
+
+static std::vector<unit_wait> wait_heap;
+static QHash<int, int> wait_index; // unit id -> position in wait_heap
+static QTimer *wait_timer = nullptr;
+
+/**
+   Returns whether the wait at position a is due before the one at b.
+ */
+static bool wait_before(int a, int b)
+{
+  const auto &wa = wait_heap[a], &wb = wait_heap[b];
+
+  return wa.wake_up < wb.wake_up
+         || (wa.wake_up == wb.wake_up && wa.id < wb.id);
+}
+
+/**
+   Swap two heap positions.
+ */
+static void wait_swap(int a, int b)
+{
+  std::swap(wait_heap[a], wait_heap[b]);
+  wait_index[wait_heap[a].id] = a;
+  wait_index[wait_heap[b].id] = b;
+}
+
+/**
+   Restore the heap order after the entry at pos got earlier.
+ */
+static void wait_sift_up(int pos)
+{
+  while (pos > 0) {
+    int parent = (pos - 1) / 2;
+
+    if (!wait_before(pos, parent)) {
+      break;
+    }
+    wait_swap(pos, parent);
+    pos = parent;
+  }
+}
+
+/**
+   Restore the heap order after the entry at pos got later.
+ */
+static void wait_sift_down(int pos)
+{
+  const int size = wait_heap.size();
+
+  for (;;) {
+    int first = pos;
+    int left = 2 * pos + 1, right = 2 * pos + 2;
+
+    if (left < size && wait_before(left, first)) {
+      first = left;
+    }
+    if (right < size && wait_before(right, first)) {
+      first = right;
+    }
+    if (first == pos) {
+      break;
+    }
+    wait_swap(pos, first);
+    pos = first;
+  }
+}
+
+/**
+   Remove the heap entry at pos.
+ */
+static void wait_remove_at(int pos)
+{
+  const int last = wait_heap.size() - 1;
+
+  wait_index.remove(wait_heap[pos].id);
+  if (pos != last) {
+    wait_heap[pos] = wait_heap[last];
+    wait_index[wait_heap[pos].id] = pos;
+  }
+  wait_heap.pop_back();
+
+  if (pos < last) {
+    wait_sift_down(pos);
+    wait_sift_up(pos);
+  }
+}
+
+/**
+   Arm the timer for the earliest wait, or stop it if there is none.
+ */
+static void wait_timer_arm()
+{
+  if (wait_heap.empty()) {
+    if (wait_timer != nullptr) {
+      wait_timer->stop();
+    }
+    return;
+  }
+
+  if (wait_timer == nullptr) {
+    wait_timer = new QTimer;
+    wait_timer->setSingleShot(true);
+    wait_timer->setTimerType(Qt::PreciseTimer);
+    QObject::connect(wait_timer, &QTimer::timeout, finish_unit_waits);
+  }
+
+  // A wait is over once the clock passed wake_up, i.e. at wake_up + 1.
+  const qint64 due = (static_cast<qint64>(wait_heap.front().wake_up) + 1)
+                     * 1000;
+  wait_timer->start(
+      std::max<qint64>(0, due - QDateTime::currentMSecsSinceEpoch()));
+}
+
+/**
+   Initialize the unit waits.
+ */
+void unit_waits_init() { unit_waits_clear(); }
+
+/**
+   Free the unit waits.
+ */
+void unit_waits_free()
+{
+  unit_waits_clear();
+  delete wait_timer;
+  wait_timer = nullptr;
+}
+
+/**
+   Drop all unit waits.
+ */
+void unit_waits_clear()
+{
+  wait_heap.clear();
+  wait_index.clear();
+  wait_timer_arm();
+}
+
+/**
+   Delay the completion of the unit's current activity until wake_up. Any
+   previous wait of the unit is replaced.
+ */
+void unit_wait_add(const struct unit *punit, time_t wake_up,
+                   enum unit_activity activity, int activity_count)
+{
+  unit_wait_cancel(punit);
+
+  wait_heap.push_back({punit->id, wake_up, activity, activity_count});
+  wait_index.insert(punit->id, wait_heap.size() - 1);
+  wait_sift_up(wait_heap.size() - 1);
+
+  if (wait_index.value(punit->id) == 0) {
+    wait_timer_arm();
+  }
+}
+
+/**
+   Forget the wait of the unit, if any.
+ */
+void unit_wait_cancel(const struct unit *punit)
+{
+  auto it = wait_index.constFind(punit->id);
+
+  if (it == wait_index.cend()) {
+    return;
+  }
+
+  const bool first = it.value() == 0;
+  wait_remove_at(it.value());
+  if (first) {
+    wait_timer_arm();
+  }
+}
+
+/**
+   Complete all activities whose wait is over.
+ */
+void finish_unit_waits()
+{
+  time_t now = time(nullptr);
+
+  while (!wait_heap.empty() && wait_heap.front().wake_up < now) {
+    const struct unit_wait wait = wait_heap.front();
+    struct unit *punit = game_unit_by_number(wait.id);
+
+    // Remove it first, completing the activity may add or cancel waits.
+    wait_remove_at(0);
+
+    if (punit != nullptr && wait.activity == punit->activity) {
+      finish_unit_wait(punit, wait.activity_count);
+    }
+  }
+
+  wait_timer_arm();
+}
@@ -0,0 +1,30 @@
+/*__            ___                 ***************************************
+/   \          /   \          Copyright (c) 1996-2020 Freeciv21 and Freeciv
+\_   \        /  __/          contributors. This file is part of Freeciv21.
+ _\   \      /  /__     Freeciv21 is free software: you can redistribute it
+ \___  \____/   __/    and/or modify it under the terms of the GNU  General
+     \_       _/          Public License  as published by the Free Software
+       | @ @  \_               Foundation, either version 3 of the  License,
+       |                              or (at your option) any later version.
+     _/     /\                  You should have received  a copy of the GNU
+    /o)  (o/\ \_                General Public License along with Freeciv21.
+    \_____/ /                     If not, see https://www.gnu.org/licenses/.
+      \____/        ********************************************************/
+#pragma once
+
+#include <ctime>
+
+// common
+#include "fc_types.h"
+
+struct unit;
+
+void unit_waits_init();
+void unit_waits_free();
+void unit_waits_clear();
+
+void unit_wait_add(const struct unit *punit, time_t wake_up,
+                   enum unit_activity activity, int activity_count);
+void unit_wait_cancel(const struct unit *punit);
+
+void finish_unit_waits();
@@ -0,0 +1,817 @@
+/*
+ Copyright (c) 1996-2020 Freeciv21 and Freeciv contributors. This file is
+ __    __          part of Freeciv21. Freeciv21 is free software: you can
+/ \\..// \    redistribute it and/or modify it under the terms of the GNU
+  ( oo )        General Public License  as published by the Free Software
+   \__/         Foundation, either version 3 of the License,  or (at your
+                      option) any later version. You should have received
+    a copy of the GNU General Public License along with Freeciv21. If not,
+                  see https://www.gnu.org/licenses/.
+ */
+
+/**
+  Headless turn benchmark.
+
+  Loads a savegame without opening any socket, hands every player to the
+  AI, fixes the random seed and plays a number of turns through the same
+  begin_turn()/begin_phase()/end_phase()/end_turn() sequence as the server.
+  The time spent in each stage is printed together with a hash of the final
+  game state, so that two runs can be compared for speed as well as for
+  determinism. The cost of research_update() on the final tech tree, of
+  walking the unit lists, of the city governor for the final cities and of
+  the caravan destination search for the final units are printed as well.
+
+  With --mapgen, maps of the given sizes are generated from the default
+  ruleset instead, and the generation time and a hash of each map are
+  printed. With --registry, the given files (or the rulesets in the given
+  directories) are parsed repeatedly and the time it takes is printed.
+ */
+
+#include <fc_config.h>
+
+#include <cstdlib>
+#include <thread>
+
+// Qt
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+// utility
+#include "fciconv.h"
+#include "fcintl.h"
+#include "log.h"
+#include "registry.h"
+#include "shared.h" // FC_INFINITY
+
+// common
+#include "actions.h"
+#include "ai.h"
+#include "capstr.h"
+#include "city.h"
+#include "fc_interface.h"
+#include "game.h"
+#include "map.h"
+#include "player.h"
+#include "research.h"
+#include "unit.h"
+#include "unitlist.h"
+#include "unittype.h"
+#include "version.h"
+
+/* common/aicore */
+#include "caravan.h"
+#include "cm.h"
+
+// server
+#include "console.h"
+#include "diplhand.h"
+#include "edithand.h"
+#include "mapimg.h"
+#include "ruleset.h"
+#include "sernet.h"
+#include "settings.h"
+#include "snapshot.h"
+#include "srv_main.h"
+#include "stdinhand.h"
+#include "voting.h"
+
+/* server/generator */
+#include "mapgen.h"
+
+namespace {
+
+enum bench_stage {
+  BS_BEGIN_TURN,
+  BS_BEGIN_PHASE,
+  BS_END_PHASE,
+  BS_END_TURN,
+  BS_COUNT
+};
+
+const char *const stage_names[BS_COUNT] = {"begin_turn", "begin_phase",
+                                           "end_phase", "end_turn"};
+
+struct stage_timing {
+  qint64 total = 0; // nanoseconds
+  qint64 max = 0;
+  int calls = 0;
+};
+
+/**
+   Adds the integer 'value' to the state hash.
+ */
+void hash_int(QCryptographicHash &hash, qint64 value)
+{
+  hash.addData(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+/**
+   Returns a hash of the parts of the game state the AI and the turn
+   processing act on. Two runs from the same savegame and seed are expected
+   to give the same value.
+ */
+QByteArray game_state_hash()
+{
+  QCryptographicHash hash(QCryptographicHash::Sha256);
+
+  hash_int(hash, game.info.turn);
+  hash_int(hash, game.info.year);
+
+  whole_map_iterate(&(wld.map), ptile)
+  {
+    const struct player *owner = tile_owner(ptile);
+
+    hash_int(hash, terrain_number(tile_terrain(ptile)));
+    hash_int(hash, owner != nullptr ? player_number(owner) : -1);
+    hash.addData(reinterpret_cast<const char *>(ptile->extras.vec),
+                 sizeof(ptile->extras.vec));
+  }
+  whole_map_iterate_end;
+
+  players_iterate(pplayer)
+  {
+    const struct research *presearch = research_get(pplayer);
+
+    hash_int(hash, player_number(pplayer));
+    hash_int(hash, pplayer->is_alive);
+    hash_int(hash, pplayer->economic.gold);
+    hash_int(hash, presearch->researching);
+    hash_int(hash, presearch->bulbs_researched);
+    hash_int(hash, presearch->techs_researched);
+
+    city_list_iterate(pplayer->cities, pcity)
+    {
+      hash_int(hash, pcity->id);
+      hash_int(hash, tile_index(city_tile(pcity)));
+      hash_int(hash, city_size_get(pcity));
+      hash_int(hash, pcity->food_stock);
+      hash_int(hash, pcity->shield_stock);
+      hash_int(hash, pcity->production.kind);
+      hash_int(hash, universal_number(&pcity->production));
+    }
+    city_list_iterate_end;
+
+    unit_list_iterate(pplayer->units, punit)
+    {
+      hash_int(hash, punit->id);
+      hash_int(hash, utype_number(unit_type_get(punit)));
+      hash_int(hash, tile_index(unit_tile(punit)));
+      hash_int(hash, punit->hp);
+      hash_int(hash, punit->veteran);
+      hash_int(hash, punit->moves_left);
+      hash_int(hash, punit->activity);
+    }
+    unit_list_iterate_end;
+  }
+  players_iterate_end;
+
+  return hash.result().toHex();
+}
+
+/**
+   Runs 'function' and adds the time it took to 'timing'.
+ */
+template <typename F> void timed(struct stage_timing &timing, F function)
+{
+  QElapsedTimer timer;
+
+  timer.start();
+  function();
+
+  auto elapsed = timer.nsecsElapsed();
+  timing.total += elapsed;
+  timing.max = qMax(timing.max, elapsed);
+  timing.calls++;
+}
+
+/**
+   Plays one turn the way the server does when no client is connected.
+   Returns false when the game ended.
+ */
+bool bench_turn(bool is_new_turn, struct stage_timing *timings)
+{
+  timed(timings[BS_BEGIN_TURN], [=] { begin_turn(is_new_turn); });
+
+  do {
+    timed(timings[BS_BEGIN_PHASE], [=] { begin_phase(is_new_turn); });
+    timed(timings[BS_END_PHASE], [] { end_phase(); });
+    game.info.phase++;
+  } while (server_state() == S_S_RUNNING
+           && game.info.phase < game.server.num_phases);
+
+  timed(timings[BS_END_TURN], [] { end_turn(); });
+
+  if (server_state() != S_S_OVER && check_for_game_over()) {
+    set_server_state(S_S_OVER);
+  }
+
+  return server_state() == S_S_RUNNING;
+}
+
+/**
+   Returns a hash of the generated map.
+ */
+QByteArray map_hash()
+{
+  QCryptographicHash hash(QCryptographicHash::Sha256);
+
+  whole_map_iterate(&(wld.map), ptile)
+  {
+    const struct extra_type *resource = tile_resource(ptile);
+
+    hash_int(hash, terrain_number(tile_terrain(ptile)));
+    hash_int(hash, resource != nullptr ? extra_number(resource) : -1);
+    hash_int(hash, tile_continent(ptile));
+    hash.addData(reinterpret_cast<const char *>(ptile->extras.vec),
+                 sizeof(ptile->extras.vec));
+  }
+  whole_map_iterate_end;
+  hash_int(hash, map_startpos_count());
+
+  return hash.result().toHex();
+}
+
+/**
+   Calls research_update() 'rounds' times for each alive player and prints
+   how long a call takes. The research state is recalculated from the same
+   inventions every time, so the game state is left unchanged.
+ */
+void bench_research(int rounds)
+{
+  struct stage_timing timing;
+
+  for (int i = 0; i < rounds; i++) {
+    players_iterate_alive(pplayer)
+    {
+      struct research *presearch = research_get(pplayer);
+
+      timed(timing, [presearch] { research_update(presearch); });
+    }
+    players_iterate_alive_end;
+  }
+
+  fc_printf("research_update_us calls %d avg %.3f max %.3f\n",
+            timing.calls,
+            timing.calls > 0 ? timing.total / 1e3 / timing.calls : 0.0,
+            timing.max / 1e3);
+}
+
+/**
+   Walks the units of every tile and of every player, and the cargo of
+   every transport, 'rounds' times and prints how long a walk takes.
+ */
+void bench_unit_lists(int rounds)
+{
+  struct stage_timing timing;
+  unsigned int sum = 0;
+
+  for (int i = 0; i < rounds; i++) {
+    timed(timing, [&sum] {
+      whole_map_iterate(&(wld.map), ptile)
+      {
+        unit_list_iterate(ptile->units, punit) { sum += punit->id; }
+        unit_list_iterate_end;
+      }
+      whole_map_iterate_end;
+      players_iterate(pplayer)
+      {
+        unit_list_iterate(pplayer->units, punit)
+        {
+          sum += punit->id;
+          if (get_transporter_occupancy(punit) > 0) {
+            unit_cargo_iterate(punit, pcargo) { sum += pcargo->id; }
+            unit_cargo_iterate_end;
+          }
+        }
+        unit_list_iterate_end;
+      }
+      players_iterate_end;
+    });
+  }
+
+  fc_printf("unit_lists_us calls %d avg %.3f max %.3f sum %u\n",
+            timing.calls,
+            timing.calls > 0 ? timing.total / 1e3 / timing.calls : 0.0,
+            timing.max / 1e3, sum);
+}
+
+/**
+   Runs the city governor on every city 'rounds' times and prints how long
+   a query takes. The relaxed timing is for the same query followed by the
+   two retries with weaker requirements done when no valid result is found,
+   all sharing one tile lattice. The results are not applied, so the game
+   state is left unchanged. The branch & bound nodes explored by the relaxed
+   queries are printed too, to compare pruning changes.
+ */
+void bench_cm(int rounds)
+{
+  struct stage_timing timing, relaxed_timing;
+  long nodes = 0;
+
+  for (int i = 0; i < rounds; i++) {
+    cities_iterate(pcity)
+    {
+      struct cm_parameter parameter;
+      auto result = cm_result_new(pcity);
+
+      cm_init_parameter(&parameter);
+      if (pcity->cm_parameter != nullptr) {
+        cm_copy_parameter(&parameter, pcity->cm_parameter);
+      }
+
+      timed(timing, [&] {
+        cm_query_result(pcity, &parameter, result, false);
+      });
+      timed(relaxed_timing, [&] {
+        struct cm_state *state = cm_state_init(pcity, false);
+
+        cm_state_query(state, &parameter, result, false);
+        parameter.minimal_surplus[O_FOOD] = 0;
+        parameter.minimal_surplus[O_SHIELD] = 0;
+        parameter.minimal_surplus[O_GOLD] = -FC_INFINITY;
+        cm_state_query(state, &parameter, result, false);
+        cm_init_emergency_parameter(&parameter);
+        cm_state_query(state, &parameter, result, true);
+        nodes += cm_state_node_count(state);
+        cm_state_free(state);
+      });
+    }
+    cities_iterate_end;
+  }
+
+  fc_printf("cm_query_us calls %d avg %.3f max %.3f\n", timing.calls,
+            timing.calls > 0 ? timing.total / 1e3 / timing.calls : 0.0,
+            timing.max / 1e3);
+  fc_printf("cm_relaxed_us calls %d avg %.3f max %.3f\n",
+            relaxed_timing.calls,
+            relaxed_timing.calls > 0
+                ? relaxed_timing.total / 1e3 / relaxed_timing.calls
+                : 0.0,
+            relaxed_timing.max / 1e3);
+  fc_printf("cm_relaxed_nodes calls %d avg %.1f\n", relaxed_timing.calls,
+            relaxed_timing.calls > 0
+                ? static_cast<double>(nodes) / relaxed_timing.calls
+                : 0.0);
+}
+
+/**
+   Looks for the best destination of every unit able to enter trade routes
+   or help wonders 'rounds' times and prints how long a search takes. Only
+   the first round of a turn does the path finding for caravans that share
+   a starting point; the game state is left unchanged.
+ */
+void bench_caravans(int rounds)
+{
+  struct stage_timing timing;
+
+  for (int i = 0; i < rounds; i++) {
+    players_iterate_alive(pplayer)
+    {
+      unit_list_iterate(pplayer->units, punit)
+      {
+        struct caravan_parameter parameter;
+        struct caravan_result result;
+
+        if (game_city_by_number(punit->homecity) == nullptr
+            || (!unit_can_do_action(punit, ACTION_TRADE_ROUTE)
+                && !unit_can_do_action(punit, ACTION_HELP_WONDER))) {
+          continue;
+        }
+
+        caravan_parameter_init_from_unit(&parameter, punit);
+        parameter.allow_foreign_trade = FTL_ALLIED;
+        timed(timing, [&] {
+          caravan_find_best_destination(punit, &parameter, &result, false);
+        });
+      }
+      unit_list_iterate_end;
+    }
+    players_iterate_alive_end;
+  }
+
+  fc_printf("caravan_search_us calls %d avg %.3f max %.3f\n", timing.calls,
+            timing.calls > 0 ? timing.total / 1e3 / timing.calls : 0.0,
+            timing.max / 1e3);
+}
+
+/**
+   Takes a snapshot of the game with the views of the players 'rounds'
+   times and prints how long it takes.
+ */
+void bench_snapshot(int rounds)
+{
+  struct stage_timing timing;
+
+  for (int i = 0; i < rounds; i++) {
+    struct snapshot *snap = nullptr;
+
+    timed(timing, [&snap] { snap = snapshot_take(true); });
+    snapshot_free(snap);
+  }
+
+  fc_printf("snapshot_us calls %d avg %.3f max %.3f\n", timing.calls,
+            timing.calls > 0 ? timing.total / 1e3 / timing.calls : 0.0,
+            timing.max / 1e3);
+}
+
+/**
+   Saves a map image of all players 'rounds' times to a temporary
+   directory. Prints how long the turn waits for it, which is the time to
+   set up the image and to take the snapshot, and how long the drawing and
+   saving takes on the background thread.
+ */
+void bench_mapimg(int rounds)
+{
+  struct stage_timing main_timing, draw_timing;
+  QTemporaryDir dir;
+  int id;
+
+  if (!dir.isValid()
+      || !mapimg_define("zoom=1:map=tcub:show=all:format=ppm|ppm", false)) {
+    return;
+  }
+  id = mapimg_count() - 1;
+  if (mapimg_isvalid(id) == nullptr) {
+    mapimg_delete(id);
+    return;
+  }
+
+  for (int i = 0; i < rounds; i++) {
+    struct mapimg_batch *batch = nullptr;
+    struct snapshot *snap = nullptr;
+
+    timed(main_timing, [&] {
+      batch = mapimg_batch_new(qUtf8Printable(dir.path()));
+      mapimg_batch_add(batch, mapimg_isvalid(id), true, "bench");
+      snap = snapshot_take(true);
+    });
+    timed(draw_timing, [&] {
+      mapimg_server_start(snap, batch);
+      mapimg_server_wait();
+    });
+  }
+  mapimg_delete(id);
+
+  fc_printf("mapimg_main_us calls %d avg %.3f max %.3f\n",
+            main_timing.calls,
+            main_timing.calls > 0
+                ? main_timing.total / 1e3 / main_timing.calls
+                : 0.0,
+            main_timing.max / 1e3);
+  fc_printf("mapimg_draw_us calls %d avg %.3f max %.3f\n",
+            draw_timing.calls,
+            draw_timing.calls > 0
+                ? draw_timing.total / 1e3 / draw_timing.calls
+                : 0.0,
+            draw_timing.max / 1e3);
+}
+
+/**
+   Generates a map of each of the given 'sizes' (in thousands of tiles)
+   with the default ruleset and settings, and reports how long it took.
+   Returns false if the ruleset could not be loaded or a size is invalid.
+ */
+bool bench_mapgen(const QString &sizes, int seed)
+{
+  struct unit_type *utype;
+
+  if (!load_rulesets(nullptr, nullptr, false, nullptr, true, false,
+                     true)) {
+    return false;
+  }
+  utype = get_role_unit(L_FIRSTBUILD, 0);
+
+  fc_printf("seed %d\n", seed);
+  for (const auto &str : sizes.split(QLatin1Char(','))) {
+    bool ok;
+    int size = str.toInt(&ok);
+    QElapsedTimer timer;
+
+    if (!ok || size < MAP_MIN_SIZE || size > MAP_MAX_SIZE) {
+      fc_fprintf(stderr, _("Invalid map size %s\n"), qUtf8Printable(str));
+      return false;
+    }
+
+    main_map_free();
+    wld.map.server.mapsize = MAPSIZE_FULLSIZE;
+    wld.map.server.size = size;
+    wld.map.server.seed_setting = seed;
+
+    timer.start();
+    bool created = map_fractal_generate(true, utype);
+    auto elapsed = timer.nsecsElapsed();
+
+    fc_printf("mapgen size %d (%dx%d) %s ms %.3f hash %s\n", size,
+              wld.map.xsize, wld.map.ysize, created ? "ok" : "failed",
+              elapsed / 1e6, map_hash().constData());
+  }
+
+  return true;
+}
+
+/**
+   Loads each of the comma-separated 'paths' 'rounds' times with the
+   registry and reports how long it took. A directory stands for the
+   rulesets it contains. Returns false if a file could not be loaded.
+ */
+bool bench_registry(const QString &paths, int rounds)
+{
+  QStringList files;
+
+  for (const auto &path : paths.split(QLatin1Char(','))) {
+    QDir dir(path);
+
+    if (dir.exists()) {
+      for (const auto &name :
+           dir.entryList({QStringLiteral("*.ruleset")}, QDir::Files)) {
+        files.append(dir.filePath(name));
+      }
+    } else {
+      files.append(path);
+    }
+  }
+
+  for (const auto &file : qAsConst(files)) {
+    struct stage_timing timing;
+    int entries = 0;
+
+    for (int i = 0; i < rounds; i++) {
+      struct section_file *secfile = nullptr;
+
+      timed(timing, [&] { secfile = secfile_load(file, true); });
+      if (secfile == nullptr) {
+        fc_fprintf(stderr, "%s\n", secfile_error());
+        return false;
+      }
+
+      entries = 0;
+      section_list_iterate(secfile_sections(secfile), psection)
+      {
+        entries += entry_list_size(section_entries(psection));
+      }
+      section_list_iterate_end;
+      secfile_destroy(secfile);
+    }
+
+    fc_printf("registry %s entries %d ms avg %.3f max %.3f\n",
+              qUtf8Printable(file), entries,
+              timing.total / 1e6 / timing.calls, timing.max / 1e6);
+  }
+
+  return true;
+}
+
+/**
+   Writes 'lines' log lines to 'filename' from two threads and reports how
+   long the producers were blocked and how long it took until everything
+   was on disk. Standard error still receives every line; redirect it to
+   measure the file writer alone.
+ */
+void bench_log(const QString &filename, int lines)
+{
+  QElapsedTimer timer;
+
+  log_set_file(filename);
+
+  timer.start();
+  auto producer = [lines](int thread) {
+    for (int i = thread; i < lines; i += 2) {
+      qInfo("Benchmark line %d from thread %d", i, thread);
+    }
+  };
+  std::thread first(producer, 0);
+  std::thread second(producer, 1);
+  first.join();
+  second.join();
+  auto produced = timer.nsecsElapsed();
+
+  // Waits for the writer thread
+  log_close();
+  auto written = timer.nsecsElapsed();
+
+  fc_printf("log_lines %d\n", lines);
+  fc_printf("log_produce_ms %.3f\n", produced / 1e6);
+  fc_printf("log_write_ms %.3f\n", written / 1e6);
+}
+
+} // anonymous namespace
+
+/**
+   Entry point of the benchmark
+ */
+int main(int argc, char **argv)
+{
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationVersion(freeciv21_version());
+
+  init_nls();
+  init_character_encodings(FC_DEFAULT_DATA_ENCODING, false);
+
+  QCommandLineParser parser;
+  parser.addHelpOption();
+  parser.addVersionOption();
+
+  bool ok = parser.addOptions({
+      {{"d", _("debug")},
+       // TRANS: Do not translate "fatal", "critical", "warning", "info" or
+       //        "debug". It's exactly what the user must type.
+       _("Set debug log level (fatal/critical/warning/info/debug)"),
+       _("LEVEL"),
+       QStringLiteral("warning")},
+      {{"F", "Fatal"}, _("Raise a signal on failed assertion")},
+      {{"f", "file"},
+       _("Load saved game FILE"),
+       // TRANS: Command-line argument
+       _("FILE")},
+      {{"l", "log"},
+       _("Use FILE as logfile"),
+       // TRANS: Command-line argument
+       _("FILE")},
+      {"log-bench",
+       _("Instead of playing, write LINES lines to the logfile from two "
+         "threads"),
+       // TRANS: Command-line argument
+       _("LINES")},
+      {"mapgen",
+       _("Instead of playing, generate maps of the given comma-separated "
+         "SIZES (in thousands of tiles)"),
+       // TRANS: Command-line argument
+       _("SIZES")},
+      {"registry",
+       _("Instead of playing, load the comma-separated FILES, or the "
+         "rulesets in them if they are directories, as many times as "
+         "--turns"),
+       // TRANS: Command-line argument
+       _("FILES")},
+      {{"s", "seed"},
+       _("Use SEED for the random number generator"),
+       // TRANS: Command-line argument
+       _("SEED"),
+       QStringLiteral("1")},
+      {{"t", "turns"},
+       _("Play TURNS turns"),
+       // TRANS: Command-line argument
+       _("TURNS"),
+       QStringLiteral("10")},
+  });
+  if (!ok) {
+    qFatal("Adding command line arguments failed");
+  }
+
+  // Parse
+  parser.process(app);
+
+  // Process the parsed options
+  if (!log_init(parser.value(QStringLiteral("debug")))) {
+    exit(EXIT_FAILURE);
+  }
+  fc_assert_set_fatal(parser.isSet(QStringLiteral("Fatal")));
+
+  if (parser.isSet(QStringLiteral("log-bench"))) {
+    int lines = parser.value(QStringLiteral("log-bench")).toInt(&ok);
+
+    if (!ok || lines <= 0) {
+      fc_fprintf(stderr, _("Invalid line count %s\n"),
+                 qUtf8Printable(parser.value(QStringLiteral("log-bench"))));
+      exit(EXIT_FAILURE);
+    }
+    bench_log(parser.isSet(QStringLiteral("log"))
+                  ? parser.value(QStringLiteral("log"))
+                  : QStringLiteral("lunar_gambit-bench.log"),
+              lines);
+    free_nls();
+    return EXIT_SUCCESS;
+  }
+
+  int turns = parser.value(QStringLiteral("turns")).toInt(&ok);
+  if (!ok || turns <= 0) {
+    fc_fprintf(stderr, _("Invalid turn count %s\n"),
+               qUtf8Printable(parser.value(QStringLiteral("turns"))));
+    exit(EXIT_FAILURE);
+  }
+  int seed = parser.value(QStringLiteral("seed")).toInt(&ok);
+  if (!ok || seed <= 0) {
+    fc_fprintf(stderr, _("Invalid seed %s\n"),
+               qUtf8Printable(parser.value(QStringLiteral("seed"))));
+    exit(EXIT_FAILURE);
+  }
+  if (parser.isSet(QStringLiteral("registry"))) {
+    bool success =
+        bench_registry(parser.value(QStringLiteral("registry")), turns);
+
+    free_nls();
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  bool mapgen = parser.isSet(QStringLiteral("mapgen"));
+  if (!mapgen && !parser.isSet(QStringLiteral("file"))) {
+    fc_fprintf(stderr, _("No saved game given, use --file.\n"));
+    exit(EXIT_FAILURE);
+  }
+  if (parser.isSet(QStringLiteral("log"))) {
+    srvarg.log_filename = parser.value(QStringLiteral("log"));
+  }
+
+  init_our_capability();
+
+  // Same as the server, minus the network
+  srv_init();
+  srvarg.announce = ANNOUNCE_NONE;
+  fc_interface_init_server();
+  init_connections();
+  con_log_init(srvarg.log_filename);
+  // logging available after this point
+
+  settings_init(true);
+  stdinhand_init();
+  edithand_init();
+  voting_init();
+  diplhand_init();
+  ai_timer_init();
+
+  server_game_init(false);
+  mapimg_init(mapimg_server_tile_known, mapimg_server_tile_terrain,
+              mapimg_server_tile_owner, mapimg_server_tile_city,
+              mapimg_server_tile_unit, mapimg_server_plrcolor_count,
+              mapimg_server_plrcolor_get);
+
+  if (mapgen) {
+    bool success =
+        bench_mapgen(parser.value(QStringLiteral("mapgen")), seed);
+
+    server_quit();
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  if (!load_command(nullptr,
+                    qUtf8Printable(parser.value(QStringLiteral("file"))),
+                    false, true)) {
+    server_quit();
+    exit(EXIT_FAILURE);
+  }
+  auto load_time = timer.nsecsElapsed();
+
+  // Nobody will ever connect: let the AI play everyone, never wait for a
+  // timeout and don't write anything to disk.
+  game.server.auto_ai_toggle = true;
+  game.info.timeout = 0;
+  game.server.save_nturns = 0;
+  game.server.autosaves = 0;
+
+  // srv_ready() calls fc_srand() with this through init_game_seed()
+  game.server.seed_setting = seed;
+  wld.map.server.seed_setting = seed;
+
+  timer.restart();
+  srv_ready();
+  auto ready_time = timer.nsecsElapsed();
+
+  // Same as server::update_game_state()
+  struct stage_timing timings[BS_COUNT];
+  bool is_new_turn = game.info.is_new_game;
+  game.info.is_new_game = false;
+  int played = 0;
+
+  timer.restart();
+  while (played < turns) {
+    bool running = bench_turn(is_new_turn, timings);
+
+    is_new_turn = true;
+    played++;
+    if (!running) {
+      break;
+    }
+  }
+  auto play_time = timer.nsecsElapsed();
+
+  fc_printf("turns %d\n", played);
+  fc_printf("seed %d\n", seed);
+  fc_printf("load_ms %.3f\n", load_time / 1e6);
+  fc_printf("ready_ms %.3f\n", ready_time / 1e6);
+  fc_printf("play_ms %.3f\n", play_time / 1e6);
+  for (int i = 0; i < BS_COUNT; i++) {
+    fc_printf("%s_ms total %.3f avg %.3f max %.3f\n", stage_names[i],
+              timings[i].total / 1e6,
+              timings[i].calls > 0
+                  ? timings[i].total / 1e6 / timings[i].calls
+                  : 0.0,
+              timings[i].max / 1e6);
+  }
+  bench_research(100);
+  bench_unit_lists(100);
+  bench_cm(10);
+  bench_caravans(10);
+  bench_snapshot(10);
+  bench_mapimg(5);
+  fc_printf("state_hash %s\n", game_state_hash().constData());
+
+  server_quit();
+
+  return EXIT_SUCCESS;
+}
@@ -12,6 +12,10 @@
       \____/        ********************************************************/
 #pragma once
 
+#include <QBitArray>
+#include <QtAlgorithms>
+#include <QtEndian>
+
 #include <cstring> // memset
 
 // utility
@@ -98,3 +102,40 @@ void bv_clr_all_from(unsigned char *vec_to, const unsigned char *vec_from,
   } name
 
 bool is_any_set(QBitArray &ba);
+
+/**
+   Calls 'func' with the index of every bit set in 'bits', in increasing
+   order. 'bits' is a copy, so 'func' may change the array it was taken
+   from.
+ */
+template <typename F>
+void bitarray_iterate(const QBitArray bits, F func)
+{
+  const auto *data = reinterpret_cast<const uchar *>(bits.bits());
+  const int size = bits.size();
+  const int nbytes = (size + 7) / 8;
+  int i = 0;
+
+  for (; i + 8 <= nbytes; i += 8) {
+    quint64 word;
+
+    memcpy(&word, data + i, sizeof(word));
+    word = qFromLittleEndian(word);
+    while (word != 0) {
+      func(i * 8 + qCountTrailingZeroBits(word));
+      word &= word - 1;
+    }
+  }
+  for (; i < nbytes; i++) {
+    uint byte = data[i];
+
+    while (byte != 0) {
+      int index = i * 8 + qCountTrailingZeroBits(byte);
+
+      if (index < size) {
+        func(index);
+      }
+      byte &= byte - 1;
+    }
+  }
+}
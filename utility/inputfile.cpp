@@ -21,11 +21,15 @@
   specific "tokens" from the file.  Probably this should really use
   higher-level tools... (flex/lex bison/yacc?)
 
-  When the user tries to read a token, we return a (const char*)
-  pointing to some data if the token was found, or nullptr otherwise.
-  The data pointed to should not be modified.  The retuned pointer
-  is valid _only_ until another inputfile is performed.  (So should
-  be used immediately, or fc_strdup-ed etc.)
+  The whole file is read in memory (as UTF-8) when it is opened, and
+  lines and tokens are views into that buffer: no data is copied while
+  tokenizing, except for strings read from separate files.
+
+  When the user tries to read a token, we return a QByteArray holding
+  the token if it was found, or an empty one otherwise.  The token
+  usually shares the data of the file and is valid _only_ until the
+  file it was read from is closed, which happens at the end of an
+  included file.  (So should be used immediately, or deep-copied.)
 
   The tokens recognised are as follows:
   (Single quotes are delimiters used here, but are not part of the
@@ -66,6 +70,7 @@
 #include <cstdarg>
 // Qt
 #include <QLoggingCategory>
+#include <QTextCodec>
 
 // KArchive
 #include <KFilterDev>
@@ -78,40 +83,37 @@
 #define INF_MAGIC (0xabdc0132) // arbitrary
 
 struct inputfile {
-  unsigned int magic;        // memory check
-  QString filename;          // filename as passed to fopen
-  QIODevice *fp;             // read from this
-  QTextStream *stream;       // handles encoding
-  QString cur_line;          // data from current line
-  unsigned int cur_line_pos; // position in current line
-  unsigned int line_num;     // line number from file in cur_line
-  QString partial;           /* used in accumulating multi-line strings;
-                                used only in get_token_value, but put
-                                here so it gets freed when file closed */
-  QString token;             // data returned to user
-  datafilename_fn_t datafn;  /* function like datafilename(); use a
-                                function pointer just to keep this
-                                inputfile module "generic" */
-  bool in_string;            /* set when reading multi-line strings,
-                                to know not to handle *include at start
-                                of line as include mechanism */
-  int string_start_line;     /* when in_string is true, this is the
-                                start line of current string */
+  unsigned int magic;       // memory check
+  QString filename;         // filename as passed to fopen
+  QByteArray data;          /* the whole file, in UTF-8 and with '\n'
+                               line endings */
+  int data_pos;             // start of the next line in data
+  QByteArray cur_line;      // current line, a view into data
+  int cur_line_pos;         // position in current line
+  unsigned int line_num;    // line number from file in cur_line
+  datafilename_fn_t datafn; /* function like datafilename(); use a
+                               function pointer just to keep this
+                               inputfile module "generic" */
+  bool in_string;           /* set when reading multi-line strings,
+                               to know not to handle *include at start
+                               of line as include mechanism */
+  int string_start_line;    /* when in_string is true, this is the
+                               start line of current string */
   struct inputfile *included_from; /* nullptr for toplevel file, otherwise
                                       points back to files which this one
                                       has been included from */
 };
 
 // A function to get a specific token type:
-typedef QString (*get_token_fn_t)(struct inputfile *inf);
+typedef QByteArray (*get_token_fn_t)(struct inputfile *inf);
 
-static QString get_token_section_name(struct inputfile *inf);
-static QString get_token_entry_name(struct inputfile *inf);
-static QString get_token_eol(struct inputfile *inf);
-static QString get_token_table_start(struct inputfile *inf);
-static QString get_token_table_end(struct inputfile *inf);
-static QString get_token_comma(struct inputfile *inf);
-static QString get_token_value(struct inputfile *inf);
+static QByteArray get_token_section_name(struct inputfile *inf);
+static QByteArray get_token_entry_name(struct inputfile *inf);
+static QByteArray get_token_eol(struct inputfile *inf);
+static QByteArray get_token_table_start(struct inputfile *inf);
+static QByteArray get_token_table_end(struct inputfile *inf);
+static QByteArray get_token_comma(struct inputfile *inf);
+static QByteArray get_token_value(struct inputfile *inf);
 
 static struct {
   const char *name;
@@ -133,9 +135,40 @@ Q_LOGGING_CATEGORY(inf_category, "freeciv.inputfile")
 /**
    Return true if c is a 'comment' character: '#' or ';'
  */
-template <class Char> static bool is_comment(Char c)
+static bool is_comment(char c) { return (c == '#' || c == ';'); }
+
+/**
+   Return true if c is a whitespace character. Only ASCII whitespace is
+   considered, so that parts of UTF-8 sequences never are.
+ */
+static bool is_space(char c)
+{
+  return (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v'
+          || c == '\f');
+}
+
+/**
+   Return true if c is a decimal digit.
+ */
+static bool is_digit(char c) { return (c >= '0' && c <= '9'); }
+
+/**
+   Return true if c can be part of a one-word string: an ASCII letter or
+   digit, or any part of a non-ASCII UTF-8 sequence.
+ */
+static bool is_word_char(char c)
+{
+  return (is_digit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+          || static_cast<unsigned char>(c) >= 0x80);
+}
+
+/**
+   Returns a token holding 'len' bytes of the current line starting at
+   'pos'. The data is not copied.
+ */
+static QByteArray line_view(const struct inputfile *inf, int pos, int len)
 {
-  return (c == '#' || c == ';');
+  return QByteArray::fromRawData(inf->cur_line.constData() + pos, len);
 }
 
 /**
@@ -147,17 +180,15 @@ static void init_zeros(struct inputfile *inf)
   fc_assert_ret(nullptr != inf);
   inf->magic = INF_MAGIC;
   inf->filename.clear();
-  inf->fp = nullptr;
-  inf->stream = nullptr;
+  inf->data.clear();
+  inf->data_pos = 0;
   inf->datafn = nullptr;
   inf->included_from = nullptr;
-  inf->line_num = inf->cur_line_pos = 0;
+  inf->line_num = 0;
+  inf->cur_line_pos = 0;
   inf->in_string = false;
   inf->string_start_line = 0;
   inf->cur_line.clear();
-  inf->token.clear();
-  inf->partial.clear();
-  inf->partial.reserve(200);
 }
 
 /**
@@ -167,7 +198,6 @@ static bool inf_sanity_check(struct inputfile *inf)
 {
   fc_assert_ret_val(nullptr != inf, false);
   fc_assert_ret_val(INF_MAGIC == inf->magic, false);
-  fc_assert_ret_val(nullptr != inf->fp, false);
   fc_assert_ret_val(false == inf->in_string || true == inf->in_string,
                     false);
 
@@ -218,25 +248,50 @@ struct inputfile *inf_from_file(const QString &filename,
 }
 
 /**
-   Open the stream, and return an allocated, initialized structure.
-   Returns nullptr if the file could not be opened.
+   Read the whole stream, and return an allocated, initialized structure.
+   The stream is deleted once read. Returns nullptr if the file could not
+   be opened.
  */
 struct inputfile *inf_from_stream(QIODevice *stream,
                                   datafilename_fn_t datafn)
 {
   struct inputfile *inf;
+  QTextCodec *codec;
 
   fc_assert_ret_val(nullptr != stream, nullptr);
   inf = new inputfile;
   init_zeros(inf);
 
   inf->filename.clear();
-  inf->fp = stream;
-  inf->stream = new QTextStream(stream);
-  inf->stream->setCodec("UTF-8");
-  inf->stream->setAutoDetectUnicode(true); // Allow UTF-16 and UTF-32
+  inf->data = stream->readAll();
   inf->datafn = datafn;
 
+  // No way to determine whether a generic QIODevice has error'ed :(
+  if (dynamic_cast<KFilterDev *>(stream)
+      && dynamic_cast<KFilterDev *>(stream)->error() != 0) {
+    // TRANS: Error reading <file>: <reason>
+    qCCritical(inf_category) << QString::fromUtf8(_("Error reading %1: %2"))
+                                    .arg(inf_filename(inf))
+                                    .arg(stream->errorString());
+  }
+  delete stream;
+
+  // Allow UTF-16 and UTF-32, and skip the byte order mark.
+  codec = QTextCodec::codecForUtfText(inf->data, nullptr);
+  if (codec != nullptr && codec->mibId() != 106) { // 106 is UTF-8
+    inf->data = codec->toUnicode(inf->data).toUtf8();
+  } else if (inf->data.startsWith("\xef\xbb\xbf")) {
+    inf->data.remove(0, 3);
+  }
+
+  // The parsing code needs '\n' at the end of every line.
+  if (inf->data.contains('\r')) {
+    inf->data.replace("\r\n", "\n");
+  }
+  if (!inf->data.isEmpty() && !inf->data.endsWith('\n')) {
+    inf->data.append('\n');
+  }
+
   qCDebug(inf_category) << "opened" << inf_filename(inf) << "ok";
   return inf;
 }
@@ -253,21 +308,6 @@ static void inf_close_partial(struct inputfile *inf)
 
   qCDebug(inf_category) << "sub-closing" << inf_filename(inf);
 
-  // No way to determine whether a generic QIODevice has error'ed :(
-  bool error = false;
-  if (dynamic_cast<KFilterDev *>(inf->fp)) {
-    error = dynamic_cast<KFilterDev *>(inf->fp)->error() != 0;
-  }
-  if (error) {
-    qCCritical(inf_category) << "Error before closing" << inf_filename(inf)
-                             << ":" << inf->fp->errorString();
-  }
-  delete inf->stream;
-  inf->stream = nullptr;
-
-  delete inf->fp;
-  inf->fp = nullptr;
-
   // assign zeros for safety if accidentally re-use etc:
   init_zeros(inf);
   inf->magic = ~INF_MAGIC;
@@ -323,7 +363,8 @@ bool inf_at_eof(struct inputfile *inf)
 {
   fc_assert_ret_val(inf_sanity_check(inf), true);
 
-  return inf->included_from == nullptr && inf->stream->atEnd()
+  return inf->included_from == nullptr
+         && inf->data_pos >= inf->data.length()
          && inf->cur_line_pos >= inf->cur_line.length();
 }
 
@@ -338,29 +379,30 @@ bool inf_at_eof(struct inputfile *inf)
 static bool check_include(struct inputfile *inf)
 {
   struct inputfile *new_inf, temp;
+  const auto &line = inf->cur_line;
 
   fc_assert_ret_val(inf_sanity_check(inf), false);
   if (inf->in_string || inf->cur_line_pos > 0) {
     return false;
   }
 
-  QString include_prefix = QStringLiteral("*include");
-  if (!inf->cur_line.startsWith(include_prefix)) {
+  const auto include_prefix = QByteArrayLiteral("*include");
+  if (!line.startsWith(include_prefix)) {
     return false;
   }
 
   // From here, the include-line must be well formed
   // Skip any whitespace
   for (inf->cur_line_pos = include_prefix.length();
-       inf->cur_line_pos < inf->cur_line.length(); ++inf->cur_line_pos) {
-    if (!inf->cur_line[inf->cur_line_pos].isSpace()) {
+       inf->cur_line_pos < line.length(); ++inf->cur_line_pos) {
+    if (!is_space(line.at(inf->cur_line_pos))) {
       break;
     }
   }
 
   // Check that we've got the opening ", and not EOL
-  if (inf->cur_line_pos >= inf->cur_line.length()
-      || inf->cur_line[inf->cur_line_pos] != '\"') {
+  if (inf->cur_line_pos >= line.length()
+      || line.at(inf->cur_line_pos) != '\"') {
     qCCritical(inf_category,
                "Did not find opening doublequote for '*include' line");
     return false;
@@ -370,28 +412,28 @@ static bool check_include(struct inputfile *inf)
   auto start = inf->cur_line_pos + 1;
 
   // Find the closing "
-  auto end = inf->cur_line.indexOf('\"', start);
+  auto end = line.indexOf('\"', start);
   if (end < 0) {
     qCCritical(inf_category,
                "Did not find closing doublequote for '*include' line");
     return false;
   }
 
-  auto name = inf->cur_line.mid(start, end - start);
+  auto name = QString::fromUtf8(line.mid(start, end - start));
 
   // Check that the rest of line is well-formed
-  for (int i = end + 1; i < inf->cur_line.length(); ++i) {
-    auto c = inf->cur_line[i];
+  for (int i = end + 1; i < line.length(); ++i) {
+    auto c = line.at(i);
     if (is_comment(c)) {
       // Ignore the rest of the line
       break;
-    } else if (!c.isSpace()) {
+    } else if (!is_space(c)) {
       qCCritical(inf_category, "Junk after filename for '*include' line");
       return false;
     }
   }
 
-  inf->cur_line_pos = inf->cur_line.length() - 1;
+  inf->cur_line_pos = line.length() - 1;
   auto full_name = inf->datafn(name);
   if (full_name.isEmpty()) {
     qCCritical(inf_category) << "Could not find included file: " << name;
@@ -411,12 +453,19 @@ static bool check_include(struct inputfile *inf)
     } while ((inc = inc->included_from));
   }
 
-  new_inf = inf_from_file(qUtf8Printable(full_name), inf->datafn);
+  new_inf = inf_from_file(full_name, inf->datafn);
+  if (new_inf == nullptr) {
+    qCCritical(inf_category) << "Could not open included file:"
+                             << full_name;
+    return false;
+  }
 
   /* Swap things around so that memory pointed to by inf (user pointer,
      and pointer in calling functions) contains the new inputfile,
      and newly allocated memory for new_inf contains the old inputfile.
      This is pretty scary, lets hope it works...
+     The data of the files is shared, not copied, so that the current
+     lines still point to it.
   */
   temp = *new_inf;
   *new_inf = *inf;
@@ -451,31 +500,25 @@ static bool stop_reading(inputfile *inf)
    Read a new line into cur_line.
    Increments line_num and cur_line_pos.
    Returns 0 if didn't read or other problem: treat as EOF.
-   Strips newline from input.
+   The line is a view into the data of the file, including the newline.
  */
 static bool read_a_line(struct inputfile *inf)
 {
   fc_assert_ret_val(inf_sanity_check(inf), false);
 
   // eof
-  if (inf->stream->atEnd() && inf->cur_line_pos >= inf->cur_line.length()) {
+  if (inf->data_pos >= inf->data.length()) {
     return stop_reading(inf);
   }
 
-  // Read a full line. Only ASCII line separators are valid.
-  // First get the data. Proper error handling makes this terrible...
-  QString line;
-  const auto ok = inf->stream->readLineInto(&inf->cur_line, 0);
-  if (!ok && !inf->fp->atEnd()) {
-    // TRANS: Error reading <file>: <reason>
-    qCCritical(inf_category) << QString::fromUtf8(_("Error reading %1: %2"))
-                                    .arg(inf->filename)
-                                    .arg(inf->fp->errorString());
-    return stop_reading(inf);
-  }
+  // The data always ends with a newline, see inf_from_stream().
+  auto end = inf->data.indexOf('\n', inf->data_pos);
+  fc_assert_ret_val(end >= 0, false);
 
-  // Normal behavior
-  inf->cur_line += '\n'; // The parsing code needs a termination character.
+  // The parsing code needs a termination character: keep the newline.
+  inf->cur_line = QByteArray::fromRawData(
+      inf->data.constData() + inf->data_pos, end + 1 - inf->data_pos);
+  inf->data_pos = end + 1;
   inf->cur_line_pos = 0;
   inf->line_num++;
 
@@ -514,7 +557,7 @@ QString inf_log_str(struct inputfile *inf, const char *message, ...)
 
   if (!inf->cur_line.isEmpty()) {
     str += QStringLiteral("\n  looking at: '%1'")
-               .arg(inf->cur_line.mid(inf->cur_line_pos));
+               .arg(QString::fromUtf8(inf->cur_line.mid(inf->cur_line_pos)));
   }
   if (inf->in_string) {
     str += QStringLiteral("\n  processing string starting at line %1")
@@ -532,15 +575,16 @@ QString inf_log_str(struct inputfile *inf, const char *message, ...)
 /**
    Returns token of given type from given inputfile.
  */
-QString inf_token(struct inputfile *inf, enum inf_token_type type)
+QByteArray inf_token(struct inputfile *inf, enum inf_token_type type)
 {
-  fc_assert_ret_val(inf_sanity_check(inf), nullptr);
-  fc_assert_ret_val(INF_TOK_FIRST <= type && INF_TOK_LAST > type, nullptr);
+  fc_assert_ret_val(inf_sanity_check(inf), QByteArray());
+  fc_assert_ret_val(INF_TOK_FIRST <= type && INF_TOK_LAST > type,
+                    QByteArray());
 
   auto name = tok_tab[type].name ? tok_tab[type].name : "(unnamed)";
   auto func = tok_tab[type].func;
 
-  QString s;
+  QByteArray s;
   if (func) {
     while (!have_line(inf) && read_a_line(inf)) {
       // Nothing.
@@ -575,91 +619,91 @@ int inf_discard_tokens(struct inputfile *inf, enum inf_token_type type)
    if there is no section name on that position. Sets inputfile position
    after section name.
  */
-static QString get_token_section_name(struct inputfile *inf)
+static QByteArray get_token_section_name(struct inputfile *inf)
 {
-  fc_assert_ret_val(have_line(inf), "");
+  fc_assert_ret_val(have_line(inf), QByteArray());
 
   auto start = inf->cur_line_pos;
-  if (start >= inf->cur_line.length() || inf->cur_line[start] != '[') {
-    return "";
+  if (start >= inf->cur_line.length() || inf->cur_line.at(start) != '[') {
+    return QByteArray();
   }
   ++start; // Skip the [
   auto end = inf->cur_line.indexOf(']', start);
   if (end < 0) {
-    return "";
+    return QByteArray();
   }
 
   // Extract the name
-  inf->token = inf->cur_line.mid(start, end - start);
   inf->cur_line_pos = end + 1;
-  return inf->token;
+  return line_view(inf, start, end - start);
 }
 
 /**
    Returns next entry name from inputfile. Skips white spaces and
    comments. Sets inputfile position after entry name.
  */
-static QString get_token_entry_name(struct inputfile *inf)
+static QByteArray get_token_entry_name(struct inputfile *inf)
 {
-  fc_assert_ret_val(have_line(inf), "");
+  fc_assert_ret_val(have_line(inf), QByteArray());
+
+  const auto &line = inf->cur_line;
 
   // Skip whitespace
   auto i = inf->cur_line_pos;
-  for (; i < inf->cur_line.length(); ++i) {
-    if (!inf->cur_line[i].isSpace()) {
+  for (; i < line.length(); ++i) {
+    if (!is_space(line.at(i))) {
       break;
     }
   }
-  if (i >= inf->cur_line.length()) {
-    return "";
+  if (i >= line.length()) {
+    return QByteArray();
   }
   auto start = i;
 
   // Find the end of the name
-  for (; i < inf->cur_line.length(); ++i) {
-    auto c = inf->cur_line[i];
-    if (c.isSpace() || c == '=') {
+  for (; i < line.length(); ++i) {
+    auto c = line.at(i);
+    if (is_space(c) || c == '=') {
       break;
     }
   }
-  if (i >= inf->cur_line.length()) {
-    return "";
+  if (i >= line.length()) {
+    return QByteArray();
   }
   auto end = i;
 
   // Find the equal sign
-  auto eq = inf->cur_line.indexOf('=', end);
+  auto eq = line.indexOf('=', end);
   if (eq < 0) {
-    return "";
+    return QByteArray();
   }
 
   // Check that we didn't eat a comment in the middle
-  auto ref = inf->cur_line.midRef(inf->cur_line_pos, eq - inf->cur_line_pos);
+  auto ref = line_view(inf, inf->cur_line_pos, eq - inf->cur_line_pos);
   if (ref.contains(';') || ref.contains('#')) {
-    return "";
+    return QByteArray();
   }
 
   inf->cur_line_pos = eq + 1;
-  inf->token = inf->cur_line.mid(start, end - start);
-
-  return inf->token;
+  return line_view(inf, start, end - start);
 }
 
 /**
    If inputfile is at end-of-line, frees current line, and returns " ".
    If there is still something on that line, returns "".
  */
-static QString get_token_eol(struct inputfile *inf)
+static QByteArray get_token_eol(struct inputfile *inf)
 {
-  fc_assert_ret_val(have_line(inf), "");
+  fc_assert_ret_val(have_line(inf), QByteArray());
 
   if (!at_eol(inf)) {
-    auto it = inf->cur_line.cbegin() + inf->cur_line_pos;
-    for (; it < inf->cur_line.cend() && it->isSpace(); ++it) {
+    auto i = inf->cur_line_pos;
+    for (; i < inf->cur_line.length() && is_space(inf->cur_line.at(i));
+         ++i) {
       // Skip
     }
-    if (it != inf->cur_line.cend() && !is_comment(*it)) {
-      return "";
+    if (i != inf->cur_line.length() && !is_comment(inf->cur_line.at(i))) {
+      return QByteArray();
     }
   }
 
@@ -667,36 +711,34 @@ static QString get_token_eol(struct inputfile *inf)
   inf->cur_line.clear();
   inf->cur_line_pos = 0;
 
-  inf->token = QStringLiteral(" ");
-  return inf->token;
+  return QByteArrayLiteral(" ");
 }
 
 /**
    Get a flag token of a single character, with optional
    preceeding whitespace.
  */
-static QString get_token_white_char(struct inputfile *inf, char target)
+static QByteArray get_token_white_char(struct inputfile *inf, char target)
 {
-  fc_assert_ret_val(have_line(inf), nullptr);
+  fc_assert_ret_val(have_line(inf), QByteArray());
 
   // Skip whitespace
-  auto it = inf->cur_line.cbegin() + inf->cur_line_pos;
-  for (; it != inf->cur_line.cend() && it->isSpace(); ++it) {
+  auto i = inf->cur_line_pos;
+  for (; i < inf->cur_line.length() && is_space(inf->cur_line.at(i)); ++i) {
     // Skip
   }
-  if (it == inf->cur_line.cend() || *it != target) {
-    return "";
+  if (i == inf->cur_line.length() || inf->cur_line.at(i) != target) {
+    return QByteArray();
   }
 
-  inf->cur_line_pos = it - inf->cur_line.cbegin() + 1;
-  inf->token = target;
-  return inf->token;
+  inf->cur_line_pos = i + 1;
+  return line_view(inf, i, 1);
 }
 
 /**
    Get flag token for table start, or nullptr if that is not next token.
  */
-static QString get_token_table_start(struct inputfile *inf)
+static QByteArray get_token_table_start(struct inputfile *inf)
 {
   return get_token_white_char(inf, '{');
 }
@@ -704,7 +746,7 @@ static QString get_token_table_start(struct inputfile *inf)
 /**
    Get flag token for table end, or nullptr if that is not next token.
  */
-static QString get_token_table_end(struct inputfile *inf)
+static QByteArray get_token_table_end(struct inputfile *inf)
 {
   return get_token_white_char(inf, '}');
 }
@@ -712,94 +754,104 @@ static QString get_token_table_end(struct inputfile *inf)
 /**
    Get flag token comma, or nullptr if that is not next token.
  */
-static QString get_token_comma(struct inputfile *inf)
+static QByteArray get_token_comma(struct inputfile *inf)
 {
   return get_token_white_char(inf, ',');
 }
 
+/**
+   Returns TRUE if what follows a value at 'pos' is fine.
+ */
+static bool value_ends_at(const struct inputfile *inf, int pos)
+{
+  if (pos >= inf->cur_line.length()) {
+    return true;
+  }
+
+  auto c = inf->cur_line.at(pos);
+  return (c == ',' || is_space(c) || is_comment(c));
+}
+
 /**
    This one is more complicated; note that it may read in multiple lines.
  */
-static QString get_token_value(struct inputfile *inf)
+static QByteArray get_token_value(struct inputfile *inf)
 {
-  fc_assert_ret_val(have_line(inf), nullptr);
+  fc_assert_ret_val(have_line(inf), QByteArray());
 
-  auto begin = inf->cur_line.cbegin();
-  auto end = inf->cur_line.cend();
+  const auto &line = inf->cur_line;
+  auto len = line.length();
 
   // Skip whitespace
-  auto c = begin + inf->cur_line_pos;
-  for (; c != end && c->isSpace(); ++c) {
+  auto c = inf->cur_line_pos;
+  for (; c < len && is_space(line.at(c)); ++c) {
     // Skip
   }
-  if (c == end) {
-    return "";
+  if (c == len) {
+    return QByteArray();
   }
 
   // Advance
-  inf->cur_line_pos = c - begin;
+  inf->cur_line_pos = c;
 
-  if (*c == '-' || *c == '+' || c->isDigit()) {
+  if (line.at(c) == '-' || line.at(c) == '+' || is_digit(line.at(c))) {
     // A number
     auto start = c++;
-    for (; c != end && c->isDigit(); ++c) {
+    for (; c < len && is_digit(line.at(c)); ++c) {
       // Take
     }
-    if (*c == '.') {
+    if (c < len && line.at(c) == '.') {
       // Float maybe
       c++;
-      for (; c != end && c->isDigit(); ++c) {
+      for (; c < len && is_digit(line.at(c)); ++c) {
         // Take
       }
     }
     // check that the trailing stuff is ok
-    if (!(c == end || *c == ',' || c->isSpace() || is_comment(*c))) {
-      return "";
+    if (!value_ends_at(inf, c)) {
+      return QByteArray();
     }
 
-    inf->token = inf->cur_line.mid(start - begin, c - start);
-    inf->cur_line_pos = c - begin;
-
-    return inf->token;
+    inf->cur_line_pos = c;
+    return line_view(inf, start, c - start);
   }
 
   // Allow gettext marker
   bool has_i18n_marking = false;
-  if (*c == '_' && *(c + 1) == '(') {
+  if (line.at(c) == '_' && c + 1 < len && line.at(c + 1) == '(') {
     has_i18n_marking = true;
     c += 2;
-    while (c != end && c->isSpace()) {
+    while (c < len && is_space(line.at(c))) {
       c++;
     }
-    if (c == end) {
-      return nullptr;
+    if (c == len) {
+      return QByteArray();
     }
   }
 
-  auto border_character = *c;
+  auto border_character = line.at(c);
   if (border_character == '*') {
     // File included as string
-    auto first = c - begin + 1; // Switch to indexes
+    auto first = c + 1;
 
     // Find the closing *
-    auto last = inf->cur_line.indexOf('*', first);
+    auto last = line.indexOf('*', first);
     if (last < 0) {
-      return "";
+      return QByteArray();
     }
     // Check that the trailing stuff is ok
-    c += last - first + 2;
-    if (!(c == end || *c == ',' || c->isSpace() || is_comment(*c))) {
-      return "";
+    c = last + 1;
+    if (!value_ends_at(inf, c)) {
+      return QByteArray();
     }
 
     // File name without *
-    auto name = inf->cur_line.mid(first, last - first);
+    auto name = QString::fromUtf8(line.mid(first, last - first));
     auto rfname = inf->datafn(name);
-    if (rfname == nullptr) {
-
+    if (rfname.isEmpty()) {
       qCCritical(inf_category, _("Cannot find stringfile \"%s\"."),
                  qUtf8Printable(name));
-      return "";
+      return QByteArray();
     }
     auto fp = new KFilterDev(rfname);
     fp->open(QIODevice::ReadOnly);
@@ -807,35 +859,33 @@ static QString get_token_value(struct inputfile *inf)
       qCCritical(inf_category, _("Cannot open stringfile \"%s\"."),
                  qUtf8Printable(rfname));
       delete fp;
-      return "";
+      return QByteArray();
     }
     qCDebug(inf_category) << "Stringfile" << name << "opened ok";
 
-    inf->token = QStringLiteral("*"); // Mark as a string read from a file
-    inf->token += QString::fromUtf8(fp->readAll());
+    // Mark as a string read from a file
+    auto token = QByteArrayLiteral("*") + fp->readAll();
 
     delete fp;
     fp = nullptr;
 
-    inf->cur_line_pos = c + 1 - begin;
+    inf->cur_line_pos = c;
 
-    return inf->token;
+    return token;
   } else if (border_character != '\"' && border_character != '\''
              && border_character != '$') {
     // A one-word string: maybe FALSE or TRUE.
     auto start = c;
-    for (; c->isLetterOrNumber(); ++c) {
+    for (; c < len && is_word_char(line.at(c)); ++c) {
       // Skip
     }
     // check that the trailing stuff is ok:
-    if (!(c == end || *c == ',' || c->isSpace() || is_comment(*c))) {
-      return nullptr;
+    if (!value_ends_at(inf, c)) {
+      return QByteArray();
     }
 
-    inf->cur_line_pos = c - begin;
-    inf->token = inf->cur_line.mid(start - begin, c - start);
-
-    return inf->token;
+    inf->cur_line_pos = c;
+    return line_view(inf, start, c - start);
   }
 
   /* From here, we know we have a string, we just have to find the
@@ -847,57 +897,59 @@ static QString get_token_value(struct inputfile *inf)
      not necessary: at that point we probably have a malformed
      string/file.)
 
-     As we read extra lines, the string value from previous
-     lines is placed in partial.
+     The lines of a file follow each other in its data, so the string
+     is a single view even when it spans several lines.
   */
 
   // prepare for possibly multi-line string:
   inf->string_start_line = inf->line_num;
   inf->in_string = true;
-  inf->partial.clear();
 
-  auto start = c++; /* start includes the initial \", to
-                     * distinguish from a number */
+  /* start includes the initial \", to distinguish from a number */
+  auto start = line.constData() + c++;
   for (;;) {
-    while (c != end && *c != border_character) {
+    while (c < len && line.at(c) != border_character) {
       /* skip over escaped chars, including backslash-doublequote,
        * and backslash-backslash: */
-      if (*c == '\\' && (c + 1) != end) {
+      if (line.at(c) == '\\' && c + 1 < len) {
         c++;
       }
       c++;
     }
 
-    if (*c == border_character) {
+    if (c < len) {
       // Found end of string
       break;
     }
 
-    inf->partial += QString(start);
-
+    auto next = line.constData() + len;
     if (!read_a_line(inf)) {
       // shouldn't happen
       qCCritical(inf_category,
                  "Bad return for multi-line string from read_a_line");
-      return "";
+      return QByteArray();
+    }
+    if (line.constData() != next) {
+      qCCritical(inf_category, "String not terminated in included file");
+      return QByteArray();
     }
-    begin = inf->cur_line.cbegin();
-    end = inf->cur_line.cend();
-    c = start = begin;
+    len = line.length();
+    c = 0;
   }
 
   // found end of string
-  inf->cur_line_pos = c + 1 - begin;
-  inf->token = inf->partial + inf->cur_line.mid(start - begin, c - start);
+  inf->cur_line_pos = c + 1;
+  auto token =
+      QByteArray::fromRawData(start, line.constData() + c - start);
 
   // check gettext tag at end:
   if (has_i18n_marking) {
-    if (*++c == ')') {
+    if (c + 1 < len && line.at(c + 1) == ')') {
       inf->cur_line_pos++;
     } else {
       qCWarning(inf_category, "Missing end of i18n string marking");
     }
   }
   inf->in_string = false;
-  return inf->token;
+  return token;
 }
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <QByteArray>
+
 // utility
 #include "log.h"     // QtMsgType
 #include "support.h" // bool type and fc__attribute
@@ -44,7 +46,7 @@ enum inf_token_type {
 };
 #define INF_TOK_FIRST INF_TOK_SECTION_NAME
 
-QString inf_token(struct inputfile *inf, enum inf_token_type type);
+QByteArray inf_token(struct inputfile *inf, enum inf_token_type type);
 int inf_discard_tokens(struct inputfile *inf, enum inf_token_type type);
 
 QString inf_log_str(struct inputfile *inf, const char *message, ...)
@@ -13,13 +13,20 @@
 
 #include <fc_config.h>
 
+#include <atomic>
+#include <memory>
 #include <vector>
 
 // Qt
+#include <QElapsedTimer>
+#include <QFile>
 #include <QFileInfo>
 #include <QLoggingCategory>
 #include <QMutexLocker>
+#include <QRecursiveMutex>
 #include <QString>
+#include <QThread>
+#include <QWaitCondition>
 
 // Windows
 #ifdef Q_OS_WIN
@@ -34,15 +41,328 @@
 
 Q_LOGGING_CATEGORY(assert_category, "freeciv.assert")
 
+// Write to the log file when this many bytes are waiting...
+#define LOG_BATCH_BYTES (64 * 1024)
+// ...or when the oldest waiting line is this old.
+#define LOG_FLUSH_MSEC 200
+
 namespace {
 static QString log_level = QStringLiteral();
 static bool fatal_assertions = false;
 
-static QBasicMutex mutex;
 static void handle_message(QtMsgType type, const QMessageLogContext &context,
                            const QString &message);
 static QtMessageHandler original_handler = nullptr;
-static QFile *log_file = nullptr;
+
+/**
+  A line waiting to be written to the log file.
+ */
+struct log_line {
+  std::atomic<log_line *> next{nullptr};
+  QString text;
+  bool flush = false;   // the logging thread waits until it is on disk
+  bool written = false; // set by the writer for lines to flush
+};
+
+/**
+  Lock-free queue with many producers and a single consumer (D. Vyukov's
+  intrusive MPSC queue). Pushing is a single atomic exchange.
+ */
+class log_queue {
+public:
+  log_queue() : head(&stub), tail(&stub) {}
+
+  /**
+     Add a line. Safe to call from any thread.
+   */
+  void push(log_line *line)
+  {
+    line->next.store(nullptr, std::memory_order_relaxed);
+    log_line *prev = head.exchange(line, std::memory_order_acq_rel);
+    prev->next.store(line, std::memory_order_release);
+  }
+
+  /**
+     Take the oldest line, or nullptr if there is none or a push is half
+     way done. Only the consumer may call this.
+   */
+  log_line *pop()
+  {
+    log_line *first = tail;
+    log_line *next = first->next.load(std::memory_order_acquire);
+
+    if (first == &stub) {
+      if (next == nullptr) {
+        return nullptr;
+      }
+      tail = next;
+      first = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+      tail = next;
+      return first;
+    }
+    if (first != head.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    push(&stub);
+    next = first->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      tail = next;
+      return first;
+    }
+    return nullptr;
+  }
+
+private:
+  std::atomic<log_line *> head;
+  log_line *tail;
+  log_line stub;
+};
+
+/**
+  Writes the log file in the background. Lines are written in batches, at
+  the latest LOG_FLUSH_MSEC after they were logged. Lines marked for flush
+  are written at once and the logging thread waits for them. Logging a
+  line takes no lock: the writer is only woken up when the queue was empty
+  or for a flush. Once the thread has stopped, lines are written by the
+  thread logging them.
+ */
+class log_writer : public QThread {
+public:
+  explicit log_writer(QFile *file) : file(file) {}
+  ~log_writer() override
+  {
+    stop();
+    delete file;
+  }
+
+  /**
+     Queue a line. When flush is set, wait until it is written.
+   */
+  void write(const QString &text, bool flush)
+  {
+    // The writer can't wait for itself
+    bool own = QThread::currentThread() == this;
+    int was_pending = pending++;
+
+    if (finished) {
+      // Nobody left to queue it to
+      pending--;
+      write_late(text, flush);
+      return;
+    }
+
+    auto *line = new log_line;
+    line->text = text;
+    line->flush = flush && !own;
+    queue.push(line);
+
+    if (line->flush) {
+      // This line is deleted here, once written
+      QMutexLocker lock(&mutex);
+      wake.wakeOne();
+      while (!line->written) {
+        done.wait(&mutex);
+      }
+      delete line;
+    } else if (was_pending == 0 && !own) {
+      // The writer deletes the line. It may be asleep.
+      QMutexLocker lock(&mutex);
+      wake.wakeOne();
+    }
+  }
+
+  /**
+     Write everything that is queued and stop the thread.
+   */
+  void stop()
+  {
+    {
+      QMutexLocker lock(&mutex);
+      stopping = true;
+      wake.wakeOne();
+    }
+    wait();
+  }
+
+  qint64 max_size = 0; // rotate above this size, 0 to never rotate
+  int keep = 3;        // number of rotated files kept
+
+protected:
+  /**
+     Consumer loop.
+   */
+  void run() override
+  {
+    QByteArray buffer;
+    QElapsedTimer age;
+    std::vector<log_line *> flushing;
+
+    while (true) {
+      {
+        QMutexLocker lock(&mutex);
+        // Sleep until a line is queued or the buffered lines are due
+        while (pending == 0 && !stopping) {
+          if (buffer.isEmpty()) {
+            wake.wait(&mutex);
+          } else if (age.hasExpired(LOG_FLUSH_MSEC)
+                     || !wake.wait(&mutex,
+                                   LOG_FLUSH_MSEC - age.elapsed())) {
+            break;
+          }
+        }
+        if (stopping) {
+          break;
+        }
+      }
+
+      if (take_queued(buffer, age, flushing) == 0) {
+        // A line is being pushed
+        QThread::yieldCurrentThread();
+      }
+      if (!flushing.empty()
+          || (!buffer.isEmpty() && age.hasExpired(LOG_FLUSH_MSEC))) {
+        write_buffer(buffer, true);
+      }
+      if (!flushing.empty()) {
+        QMutexLocker lock(&mutex);
+        mark_written(flushing);
+      }
+    }
+
+    /* Last pass. Threads that see 'finished' write their lines
+     * themselves once it is over; the others queued theirs already. */
+    QMutexLocker late_lock(&late_mutex);
+    finished = true;
+    while (pending != 0) {
+      if (take_queued(buffer, age, flushing) == 0) {
+        QThread::yieldCurrentThread();
+      }
+    }
+    write_buffer(buffer, true);
+    QMutexLocker lock(&mutex);
+    mark_written(flushing);
+  }
+
+private:
+  /**
+     Write a line from the logging thread, once the writer has finished.
+   */
+  void write_late(const QString &text, bool flush)
+  {
+    // QFile may log, hence a recursive mutex
+    QMutexLocker lock(&late_mutex);
+    QByteArray buffer = text.toLocal8Bit() + '\n';
+
+    write_buffer(buffer, flush);
+  }
+
+  /**
+     Move the queued lines to the buffer, writing it when it gets large.
+     The lines to flush are added to 'flushing', the others deleted.
+     Returns the number of lines taken.
+   */
+  int take_queued(QByteArray &buffer, QElapsedTimer &age,
+                  std::vector<log_line *> &flushing)
+  {
+    log_line *line;
+    int count = 0;
+
+    while ((line = queue.pop()) != nullptr) {
+      if (buffer.isEmpty()) {
+        age.start();
+      }
+      buffer += line->text.toLocal8Bit();
+      buffer += '\n';
+      if (line->flush) {
+        flushing.push_back(line);
+      } else {
+        delete line;
+      }
+      if (buffer.size() >= LOG_BATCH_BYTES) {
+        write_buffer(buffer, false);
+      }
+      pending--;
+      count++;
+    }
+
+    return count;
+  }
+
+  /**
+     Tell the threads waiting for the lines in 'flushing' that they are
+     written. The mutex must be held.
+   */
+  void mark_written(std::vector<log_line *> &flushing)
+  {
+    if (flushing.empty()) {
+      return;
+    }
+
+    for (auto *line : flushing) {
+      line->written = true;
+    }
+    flushing.clear();
+    done.wakeAll();
+  }
+
+  /**
+     Write and clear the buffer, rotating the file if it got too large.
+   */
+  void write_buffer(QByteArray &buffer, bool flush)
+  {
+    if (!buffer.isEmpty()) {
+      file->write(buffer);
+      buffer.clear();
+    }
+    if (flush) {
+      file->flush();
+    }
+
+    if (max_size > 0 && file->size() > max_size) {
+      rotate();
+    }
+  }
+
+  /**
+     Move the log file to "<name>.1", the previous one to "<name>.2" and so
+     on, and start a new one.
+   */
+  void rotate()
+  {
+    const QString name = file->fileName();
+
+    file->close();
+    QFile::remove(QStringLiteral("%1.%2").arg(name).arg(keep));
+    for (int i = keep - 1; i >= 1; i--) {
+      QFile::rename(QStringLiteral("%1.%2").arg(name).arg(i),
+                    QStringLiteral("%1.%2").arg(name).arg(i + 1));
+    }
+    if (keep > 0) {
+      QFile::rename(name, name + QStringLiteral(".1"));
+    }
+    file->open(QIODevice::WriteOnly | QIODevice::Text
+               | QIODevice::Truncate);
+  }
+
+  QFile *file;
+  log_queue queue;
+
+  QMutex mutex;
+  QWaitCondition wake;               // wakes the writer
+  QWaitCondition done;               // wakes threads waiting for a flush
+  bool stopping = false;
+  std::atomic<int> pending{0};       // lines logged but not taken yet
+  std::atomic<bool> finished{false}; // the thread takes no more lines
+  QRecursiveMutex late_mutex;        // serializes writes once finished
+};
+
+// Replaced with std::atomic_exchange() while other threads log
+static std::shared_ptr<log_writer> writer;
+static qint64 log_max_size = 0;
+static int log_keep = 3;
 } // anonymous namespace
 
 /**
@@ -137,15 +457,10 @@ namespace {
 static void handle_message(QtMsgType type, const QMessageLogContext &context,
                            const QString &message)
 {
-  // Forward to file
-  if (log_file != nullptr) {
-    QMutexLocker lock(&mutex);
-    log_file->write((message + QStringLiteral("\n")).toLocal8Bit());
-
-    // Make sure we flush when it looks serious, maybe we'll crash soon
-    if (type == QtFatalMsg || type == QtCriticalMsg) {
-      log_file->flush();
-    }
+  // Forward to file. Make sure we flush when it looks serious, maybe we'll
+  // crash soon.
+  if (auto current = std::atomic_load(&writer)) {
+    current->write(message, type == QtFatalMsg || type == QtCriticalMsg);
   }
 
   // Forward to the Qt handler
@@ -157,7 +472,8 @@ static void handle_message(QtMsgType type, const QMessageLogContext &context,
 
 /**
    Redirects the log to a file. It will still be shown on standard error.
-   This function is *not* thread-safe.
+   The file is written from a background thread. This function is *not*
+   thread-safe.
  */
 void log_set_file(const QString &path)
 {
@@ -179,9 +495,29 @@ void log_set_file(const QString &path)
     return;
   }
 
-  // Unset the old one
-  delete log_file;
-  log_file = new_file;
+  // Replace the old one, writing what it still has queued
+  auto new_writer = std::make_shared<log_writer>(new_file);
+  new_writer->max_size = log_max_size;
+  new_writer->keep = log_keep;
+  new_writer->start(QThread::LowPriority);
+
+  /* Threads still logging to the old one keep it alive; they write
+   * their lines themselves once it has stopped. */
+  auto old_writer = std::atomic_exchange(&writer, new_writer);
+  if (old_writer) {
+    old_writer->stop();
+  }
+}
+
+/**
+   Start a new log file when the current one grows larger than max_size
+   bytes, keeping the keep previous ones as "<name>.1" to "<name>.<keep>".
+   Use 0 to never rotate. Call this before log_set_file().
+ */
+void log_set_rotation(qint64 max_size, int keep)
+{
+  log_max_size = qMax<qint64>(0, max_size);
+  log_keep = qMax(0, keep);
 }
 
 /**
@@ -196,12 +532,15 @@ const QString &log_get_level() { return log_level; }
  */
 void log_close()
 {
-  QMutexLocker locker(&mutex);
-
-  delete log_file;
-  log_file = nullptr;
   // Reinstall the old handler
   qInstallMessageHandler(original_handler);
+
+  // Stops the thread after writing everything
+  auto old_writer =
+      std::atomic_exchange(&writer, std::shared_ptr<log_writer>());
+  if (old_writer) {
+    old_writer->stop();
+  }
 }
 
 /**
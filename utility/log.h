@@ -32,6 +32,7 @@ constexpr auto LOG_DEBUG = QtDebugMsg;
 void log_close();
 bool log_init(const QString &level_str = QStringLiteral("info"));
 void log_set_file(const QString &path);
+void log_set_rotation(qint64 max_size, int keep = 3);
 const QString &log_get_level();
 
 // The log macros
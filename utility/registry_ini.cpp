@@ -174,7 +174,8 @@ static inline void entry_use(struct entry *pentry);
 
 static bool entry_to_file(const struct entry *pentry, QIODevice *fs);
 static void entry_from_inf_token(struct section *psection,
-                                 const QString &name, const QString &tok,
+                                 const QByteArray &name,
+                                 const QByteArray &tok,
                                  struct inputfile *file);
 
 /* An 'entry' is a string, integer, boolean or string vector;
@@ -182,7 +183,8 @@ static void entry_from_inf_token(struct section *psection,
  */
 struct entry {
   struct section *psection; // Parent section.
-  char *name;               // Name, not including section prefix.
+  const char *name;         /* Name, not including section prefix.
+                             * Owned by secfile->entry_names. */
   enum entry_type type;     // The type of the entry.
   int used;                 // Number of times entry looked up.
   char *comment;            // Comment, may be nullptr.
@@ -237,6 +239,43 @@ static bool is_secfile_entry_name_valid(const QString &name)
   return true;
 }
 
+/**
+   Ensure name is correct to use it as section or entry name. 'name' is
+   in UTF-8.
+ */
+static bool is_secfile_entry_name_valid(const QByteArray &name)
+{
+  for (const auto c : name) {
+    if (static_cast<unsigned char>(c) >= 0x80) {
+      // Let QChar judge non-ASCII letters.
+      return is_secfile_entry_name_valid(QString::fromUtf8(name));
+    }
+    if (!QChar::isLetterOrNumber(c)
+        && ('\0' == c || nullptr == strchr("_.,-[]", c))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+   Returns the copy of the entry name kept by the secfile. Each name is
+   stored once, as many entries share the same names.
+ */
+static const char *secfile_entry_name_intern(struct section_file *secfile,
+                                             const QByteArray &name)
+{
+  auto it = secfile->entry_names->constFind(name);
+
+  if (it == secfile->entry_names->constEnd()) {
+    // Deep copy: the name may be a view into a file being loaded.
+    it = secfile->entry_names->insert(
+        QByteArray(name.constData(), name.size()));
+  }
+
+  return it->constData();
+}
+
 /**
    Insert an entry into the hash table.  Returns TRUE on success.
  */
@@ -299,11 +338,12 @@ static struct section_file *secfile_from_input_file(struct inputfile *inf,
   struct section *single_section = nullptr;
   bool table_state = false; // TRUE when within tabular format.
   int table_lineno = 0;     // Row number in tabular, 0 top data row.
-  QString tok;
+  QByteArray tok;
   int i;
-  QString base_name; // for table or single entry
-  QString field_name;
-  QVector<QString> columns; // qstrings for column headings
+  QByteArray base_name; // for table or single entry
+  QByteArray field_name;
+  QVector<QByteArray> columns; // column headings
+  const QByteArray section_utf8 = section.toUtf8();
   bool found_my_section = false;
   bool error = false;
 
@@ -325,6 +365,9 @@ static struct section_file *secfile_from_input_file(struct inputfile *inf,
     qDebug("Reading registry");
   }
 
+  // Reserved capacity is kept when truncating.
+  field_name.reserve(MAX_LEN_SECPATH);
+
   while (!inf_at_eof(inf)) {
     if (!inf_token(inf, INF_TOK_EOL).isEmpty()) {
       continue;
@@ -359,10 +402,10 @@ static struct section_file *secfile_from_input_file(struct inputfile *inf,
          but then secfile_get_secnames_prefix would return duplicates.)
          Duplicate section in input are likely to be useful for includes.
       */
-      psection = secfile_section_by_name(secfile, tok);
+      psection = secfile->hash.sections->value(tok, nullptr);
       if (!psection) {
-        if (section.isEmpty() || tok == section) {
-          psection = secfile_section_new(secfile, tok);
+        if (section.isEmpty() || tok == section_utf8) {
+          psection = secfile_section_new(secfile, QString::fromUtf8(tok));
           if (!section.isEmpty()) {
             single_section = psection;
             found_my_section = true;
@@ -410,14 +453,17 @@ static struct section_file *secfile_from_input_file(struct inputfile *inf,
           goto END;
         }
 
+        // The name is built in place, so that its buffer is reused.
+        field_name.truncate(0);
+        field_name += base_name;
+        field_name += QByteArray::number(table_lineno);
+        field_name += '.';
         if (i < num_columns) {
-          field_name = QStringLiteral("%1%2.%3").arg(
-              base_name, QString::number(table_lineno), columns.at(i));
+          field_name += columns.at(i);
         } else {
-          field_name = QStringLiteral("%1%2.%3,%4")
-                           .arg(base_name, QString::number(table_lineno),
-                                columns.at(num_columns - 1),
-                                QString::number((i - num_columns + 1)));
+          field_name += columns.at(num_columns - 1);
+          field_name += ',';
+          field_name += QByteArray::number(i - num_columns + 1);
         }
         entry_from_inf_token(psection, field_name, tok, inf);
       } while (!inf_token(inf, INF_TOK_COMMA).isEmpty());
@@ -440,8 +486,9 @@ static struct section_file *secfile_from_input_file(struct inputfile *inf,
       goto END;
     }
 
-    // need to store tok before next calls:
-    base_name = tok;
+    /* need to store tok before next calls; it may belong to an included
+     * file that ends before the values. */
+    base_name = QByteArray(tok.constData(), tok.size());
 
     inf_discard_tokens(inf, INF_TOK_EOL); // allow newlines
 
@@ -463,7 +510,7 @@ static struct section_file *secfile_from_input_file(struct inputfile *inf,
           error = true;
           goto END;
         }
-        columns.append(tok.mid(1));
+        columns.append(QByteArray(tok.constData() + 1, tok.size() - 1));
       } while (!inf_token(inf, INF_TOK_COMMA).isEmpty());
 
       if (inf_token(inf, INF_TOK_EOL).isEmpty()) {
@@ -489,11 +536,13 @@ static struct section_file *secfile_from_input_file(struct inputfile *inf,
         goto END;
       }
       if (i == 0) {
-        entry_from_inf_token(psection, qUtf8Printable(base_name), tok, inf);
+        entry_from_inf_token(psection, base_name, tok, inf);
       } else {
-        field_name =
-            QStringLiteral("%1,%2").arg(base_name, QString::number(i));
-        entry_from_inf_token(psection, qUtf8Printable(field_name), tok, inf);
+        field_name.truncate(0);
+        field_name += base_name;
+        field_name += ',';
+        field_name += QByteArray::number(i);
+        entry_from_inf_token(psection, field_name, tok, inf);
       }
     } while (!inf_token(inf, INF_TOK_COMMA).isEmpty());
     if (inf_token(inf, INF_TOK_EOL).isEmpty()) {
@@ -535,7 +584,7 @@ static struct section_file *secfile_from_input_file(struct inputfile *inf,
   if (!error) {
     // Build the entry hash table.
     secfile->allow_duplicates = allow_duplicates;
-    secfile->hash.entries = new QMultiHash<QString, struct entry *>;
+    secfile->hash.entries = new QMultiHash<QByteArray, struct entry *>;
     section_list_iterate(secfile->sections, hashing_section)
     {
       entry_list_iterate(section_entries(hashing_section), pentry)
@@ -1729,7 +1778,8 @@ struct entry *secfile_entry_by_path(const struct section_file *secfile,
   }
 
   if (nullptr != secfile->hash.entries) {
-    struct entry *pentry = secfile->hash.entries->value(fullpath, nullptr);
+    struct entry *pentry = secfile->hash.entries->value(
+        QByteArray::fromRawData(fullpath, qstrlen(fullpath)), nullptr);
 
     if (pentry) {
       entry_use(pentry);
@@ -2663,6 +2713,10 @@ struct section *secfile_section_by_name(const struct section_file *secfile,
 {
   SECFILE_RETURN_VAL_IF_FAIL(secfile, nullptr, nullptr != secfile, nullptr);
 
+  if (nullptr != secfile->hash.sections) {
+    return secfile->hash.sections->value(name.toUtf8(), nullptr);
+  }
+
   section_list_iterate(secfile->sections, psection)
   {
     if (section_name(psection) == name) {
@@ -2843,9 +2897,10 @@ struct entry *section_entry_by_name(const struct section *psection,
   SECFILE_RETURN_VAL_IF_FAIL(nullptr, psection, nullptr != psection,
                              nullptr);
 
+  const auto utf8 = name.toUtf8();
   entry_list_iterate(psection->entries, pentry)
   {
-    if (entry_name(pentry) == name) {
+    if (utf8 == entry_name(pentry)) {
       entry_use(pentry);
       return pentry;
     }
@@ -2856,9 +2911,9 @@ struct entry *section_entry_by_name(const struct section *psection,
 }
 
 /**
-   Returns a new entry.
+   Returns a new entry. 'name' is in UTF-8.
  */
-static entry *entry_new(struct section *psection, const QString &name)
+static entry *entry_new(struct section *psection, const QByteArray &name)
 {
   struct section_file *secfile;
   struct entry *pentry;
@@ -2867,26 +2922,27 @@ static entry *entry_new(struct section *psection, const QString &name)
                              nullptr);
 
   secfile = psection->secfile;
-  if (nullptr == name || '\0' == name[0]) {
+  if (name.isEmpty()) {
     SECFILE_LOG(secfile, psection, "Cannot create an entry without name.");
     return nullptr;
   }
 
   if (!is_secfile_entry_name_valid(name)) {
     SECFILE_LOG(secfile, psection, "\"%s\" is not a valid entry name.",
-                qUtf8Printable(name));
+                qUtf8Printable(QString::fromUtf8(name)));
     return nullptr;
   }
 
   if (!secfile->allow_duplicates
-      && nullptr != section_entry_by_name(psection, name)) {
+      && nullptr
+             != section_entry_by_name(psection, QString::fromUtf8(name))) {
     SECFILE_LOG(secfile, psection, "Entry \"%s\" already exists.",
-                qUtf8Printable(name));
+                qUtf8Printable(QString::fromUtf8(name)));
     return nullptr;
   }
 
   pentry = new entry;
-  pentry->name = qstrdup(qUtf8Printable(name));
+  pentry->name = secfile_entry_name_intern(secfile, name);
   pentry->type = ENTRY_ILLEGAL; // Invalid case
   pentry->used = 0;
   pentry->comment = nullptr;
@@ -2908,7 +2964,7 @@ static entry *entry_new(struct section *psection, const QString &name)
 struct entry *section_entry_int_new(struct section *psection,
                                     const QString &name, int value)
 {
-  struct entry *pentry = entry_new(psection, name);
+  struct entry *pentry = entry_new(psection, name.toUtf8());
 
   if (nullptr != pentry) {
     pentry->type = ENTRY_INT;
@@ -2924,7 +2980,7 @@ struct entry *section_entry_int_new(struct section *psection,
 struct entry *section_entry_bool_new(struct section *psection,
                                      const QString &name, bool value)
 {
-  struct entry *pentry = entry_new(psection, name);
+  struct entry *pentry = entry_new(psection, name.toUtf8());
 
   if (nullptr != pentry) {
     pentry->type = ENTRY_BOOL;
@@ -2940,7 +2996,7 @@ struct entry *section_entry_bool_new(struct section *psection,
 struct entry *section_entry_float_new(struct section *psection,
                                       const QString &name, float value)
 {
-  struct entry *pentry = entry_new(psection, name);
+  struct entry *pentry = entry_new(psection, name.toUtf8());
 
   if (nullptr != pentry) {
     pentry->type = ENTRY_FLOAT;
@@ -2957,7 +3013,7 @@ struct entry *section_entry_str_new(struct section *psection,
                                     const QString &name,
                                     const QString &value, bool escaped)
 {
-  struct entry *pentry = entry_new(psection, name);
+  struct entry *pentry = entry_new(psection, name.toUtf8());
 
   if (nullptr != pentry) {
     pentry->type = ENTRY_STR;
@@ -3029,8 +3085,7 @@ void entry_destroy(struct entry *pentry)
     break;
   }
 
-  // Common free.
-  delete[] pentry->name;
+  // Common free. The name is owned by the secfile.
   delete[] pentry->comment;
   delete pentry;
   pentry = nullptr;
@@ -3110,8 +3165,7 @@ bool entry_set_name(struct entry *pentry, const char *name)
   secfile_hash_delete(secfile, pentry);
 
   // Really rename the entry.
-  free(pentry->name);
-  pentry->name = fc_strdup(name);
+  pentry->name = secfile_entry_name_intern(secfile, name);
 
   // Insert into hash table the new path.
   secfile_hash_insert(secfile, pentry);
@@ -3353,15 +3407,99 @@ static bool entry_to_file(const struct entry *pentry, QIODevice *fs)
 }
 
 /**
-   Creates a new entry from the token.
+   Returns a copy of the 'len' bytes at 'str', allocated with new[], with
+   the escapes removed like remove_escapes() does.
+ */
+static char *entry_unescape(const char *str, int len, bool full_escapes)
+{
+  auto copy = new char[len + 1];
+  int j = 0;
+
+  for (int i = 0; i < len; i++) {
+    if (str[i] != '\\') {
+      copy[j++] = str[i];
+    } else if (!full_escapes) {
+      // Replace only escaped newlines
+      if (i + 1 >= len || str[i + 1] != '\n') {
+        copy[j++] = str[i];
+      }
+    } else if (++i < len) {
+      switch (str[i]) {
+      case 'n':
+        copy[j++] = '\n';
+        break;
+      case '\n':
+        // Remove the newline
+        break;
+      default:
+        copy[j++] = str[i];
+      }
+    }
+  }
+  copy[j] = '\0';
+
+  return copy;
+}
+
+/**
+   Creates a new entry from the token. Both the name and the token are in
+   UTF-8; they are parsed without being converted.
  */
 static void entry_from_inf_token(struct section *psection,
-                                 const QString &name, const QString &tok,
+                                 const QByteArray &name,
+                                 const QByteArray &tok,
                                  struct inputfile *inf)
 {
-  if (!entry_from_token(psection, name, tok)) {
+  struct entry *pentry = nullptr;
+  bool ok = false;
+
+  if ('*' == tok[0] || '$' == tok[0] || '"' == tok[0]) {
+    bool escaped = ('"' == tok[0]);
+
+    ok = true;
+    if ((pentry = entry_new(psection, name))) {
+      pentry->type = ENTRY_STR;
+      pentry->string.value =
+          entry_unescape(tok.constData() + 1, tok.size() - 1, escaped);
+      pentry->string.escaped = escaped;
+      pentry->string.raw = false;
+      pentry->string.gt_marking = false;
+    }
+  } else if (QChar::isDigit(tok[0])
+             || (('-' == tok[0] || '+' == tok[0]) && 1 < tok.size()
+                 && QChar::isDigit(tok[1]))) {
+    if (tok.contains('.')) {
+      float fvalue = tok.toFloat(&ok);
+
+      if (ok && (pentry = entry_new(psection, name))) {
+        pentry->type = ENTRY_FLOAT;
+        pentry->floating.value = fvalue;
+      }
+    } else {
+      int ivalue = tok.toInt(&ok, 0);
+
+      if (ok && (pentry = entry_new(psection, name))) {
+        pentry->type = ENTRY_INT;
+        pentry->integer.value = ivalue;
+      }
+    }
+  } else if (0 == tok.compare("FALSE", Qt::CaseInsensitive)
+             || 0 == tok.compare("TRUE", Qt::CaseInsensitive)) {
+    bool value = (0 == tok.compare("TRUE", Qt::CaseInsensitive));
+
+    ok = true;
+    if ((pentry = entry_new(psection, name))) {
+      pentry->type = ENTRY_BOOL;
+      pentry->boolean.value = value;
+    }
+  }
+
+  if (!ok) {
+    // The token may not be nul-terminated.
+    const QByteArray copy(tok.constData(), tok.size());
+
     qCritical("%s", qUtf8Printable(
                         inf_log_str(inf, "Entry value not recognized: %s",
-                                    qUtf8Printable(tok))));
+                                    copy.constData())));
   }
 }
@@ -19,9 +19,6 @@
 
 static char error_buffer[MAX_LEN_ERRORBUF] = "\0";
 
-// Debug function for every new entry.
-#define DEBUG_ENTRIES(...) // log_debug(__VA_ARGS__);
-
 /**
    Returns the last error which occurred in a string.  It never returns
    nullptr.
@@ -72,9 +69,10 @@ struct section_file *secfile_new(bool allow_duplicates)
   secfile->allow_duplicates = allow_duplicates;
   secfile->allow_digital_boolean = false; // Default
 
-  secfile->hash.sections = new QMultiHash<QString, struct section *>;
+  secfile->hash.sections = new QMultiHash<QByteArray, struct section *>;
   // Maybe allocated later.
   secfile->hash.entries = nullptr;
+  secfile->entry_names = new QSet<QByteArray>;
 
   return secfile;
 }
@@ -93,6 +91,8 @@ void secfile_destroy(struct section_file *secfile)
   delete secfile->hash.entries;
   secfile->hash.entries = nullptr;
   section_list_destroy(secfile->sections);
+  delete secfile->entry_names;
+  secfile->entry_names = nullptr;
   delete[] secfile->name;
   secfile->name = nullptr;
   delete secfile;
@@ -110,60 +110,3 @@ void secfile_allow_digital_boolean(struct section_file *secfile,
   fc_assert_ret(nullptr != secfile);
   secfile->allow_digital_boolean = allow_digital_boolean;
 }
-
-/**
-   Add entry to section from token.
- */
-bool entry_from_token(struct section *psection, const QString &name,
-                      const QString &tok)
-{
-  if ('*' == tok[0]) {
-    auto buf = remove_escapes(tok.mid(1), false);
-    (void) section_entry_str_new(psection, name, buf, false);
-    DEBUG_ENTRIES("entry %s '%s'", name, qUtf8Printable(buf));
-    return true;
-  }
-
-  if ('$' == tok[0] || '"' == tok[0]) {
-    bool escaped = ('"' == tok[0]);
-    auto buf = remove_escapes(tok.mid(1), escaped);
-    (void) section_entry_str_new(psection, name, buf, escaped);
-    DEBUG_ENTRIES("entry %s '%s'", name, qUtf8Printable(buf));
-    return true;
-  }
-
-  if (tok[0].isDigit()
-      || (('-' == tok[0] || '+' == tok[0]) && tok[1].isDigit())) {
-    if (tok.contains('.')) {
-      bool ok;
-      auto fvalue = tok.toFloat(&ok);
-      if (ok) {
-        (void) section_entry_float_new(psection, name, fvalue);
-        DEBUG_ENTRIES("entry %s %d", name, fvalue);
-        return true;
-      }
-    } else {
-      bool ok;
-      auto ivalue = tok.toInt(&ok, 0);
-      if (ok) {
-        (void) section_entry_int_new(psection, name, ivalue);
-        DEBUG_ENTRIES("entry %s %d", name, ivalue);
-
-        return true;
-      }
-    }
-    return false;
-  }
-
-  if (tok.compare(QStringLiteral("FALSE"), Qt::CaseInsensitive) == 0
-      || tok.compare(QStringLiteral("TRUE"), Qt::CaseInsensitive) == 0) {
-    bool value =
-        (tok.compare(QStringLiteral("TRUE"), Qt::CaseInsensitive) == 0);
-
-    (void) section_entry_bool_new(psection, name, value);
-    DEBUG_ENTRIES("entry %s %s", name, value ? "TRUE" : "FALSE");
-    return true;
-  }
-
-  return false;
-}
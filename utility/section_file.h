@@ -10,7 +10,9 @@
 **************************************************************************/
 #pragma once
 
+#include <QByteArray>
 #include <QMultiHash>
+#include <QSet>
 /* This header contains internals of section_file that its users should
  * not care about. This header should be included by source files
  * implementing registry itself. */
@@ -41,9 +43,11 @@ struct section_file {
   bool allow_duplicates;
   bool allow_digital_boolean;
   struct {
-    QMultiHash<QString, struct section *> *sections;
-    QMultiHash<QString, struct entry *> *entries;
+    // Keyed by UTF-8 names and paths.
+    QMultiHash<QByteArray, struct section *> *sections;
+    QMultiHash<QByteArray, struct entry *> *entries;
   } hash;
+  QSet<QByteArray> *entry_names; // Storage for the names of the entries.
 };
 
 void secfile_log(const struct section_file *secfile,
@@ -64,6 +68,3 @@ void secfile_log(const struct section_file *secfile,
     SECFILE_LOG(secfile, psection, "Assertion '%s' failed.", #condition);   \
     return value;                                                           \
   }
-
-bool entry_from_token(struct section *psection, const QString &name,
-                      const QString &tok);